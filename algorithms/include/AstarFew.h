@@ -22,6 +22,7 @@ private:
     DWGraph::node_t s;
     std::list<DWGraph::node_t> d;
     const DWGraph::weight_t dMax;
+    DWGraph::weight_t dMaxSearch;
     std::unordered_map<DWGraph::node_t, std::pair<DWGraph::weight_t, DWGraph::node_t>> dist;
 public:
     /**
@@ -43,6 +44,12 @@ public:
      */
     void initialize(const DWGraph::DWGraph *G, DWGraph::node_t s, std::list<DWGraph::node_t> d);
 
+    /**
+     * @brief Initializes, searching up to the smallest of dMax and the
+     * maximum given in the constructor
+     */
+    void initialize(const DWGraph::DWGraph *G, DWGraph::node_t s, std::list<DWGraph::node_t> d, DWGraph::weight_t dMax);
+
     DWGraph::node_t getStart() const;
     std::list<DWGraph::node_t> getDest () const;
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <list>
+#include <vector>
 #include "Vector2.h"
 
 /**
@@ -8,6 +9,17 @@
  * 
  */
 class ClosestPoint {
+protected:
+    /**
+     * @brief Get order in which to process a batch of queries.
+     * 
+     * Processing nearby queries consecutively reuses the same parts of the
+     * structure while they are still in cache. Defaults to Morton order.
+     * 
+     * @param queries   Query points
+     * @return std::vector<size_t> Permutation of the indices of queries
+     */
+    virtual std::vector<size_t> getQueryOrder(const std::vector<Vector2> &queries) const;
 public:
     virtual ~ClosestPoint();
 
@@ -25,6 +37,27 @@ public:
     virtual void run() = 0;
 
     virtual Vector2 getClosestPoint(Vector2 p) const = 0;
+
+    /**
+     * @brief Get index of the closest point.
+     * 
+     * @param p         Query point
+     * @return size_t   Position of the closest point in the list passed to initialize
+     */
+    virtual size_t getClosestPointIdx(Vector2 p) const = 0;
+
+    /**
+     * @brief Answer a batch of queries.
+     * 
+     * @param queries   Query points
+     * @param res       Output; res[i] is the index of the closest point to queries[i]
+     * @param nThreads  Number of threads to split the queries across
+     */
+    virtual void getClosestPointMany(
+        const std::vector<Vector2> &queries,
+        std::vector<size_t> &res,
+        size_t nThreads = 1
+    ) const;
 };
 
 class ClosestPointFactory {
@@ -1,9 +1,26 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <deque>
 #include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 #include "Coord.h"
 
 class ClosestPointsInRadius {
+protected:
+    /**
+     * @brief Get order in which to process a batch of queries.
+     * 
+     * Defaults to Morton order.
+     * 
+     * @param queries   Query points
+     * @return std::vector<size_t> Permutation of the indices of queries
+     */
+    virtual std::vector<size_t> getQueryOrder(const std::vector<Coord> &queries) const;
 public:
     virtual ~ClosestPointsInRadius();
 
@@ -21,4 +38,93 @@ public:
     virtual void run() = 0;
 
     virtual std::vector<Coord> getClosestPoints(Coord p) const = 0;
+
+    /**
+     * @brief Get indices of all points in radius.
+     * 
+     * @param p     Query point
+     * @param res   Indices (positions in the list passed to initialize) are appended to res
+     */
+    virtual void getClosestPointsIdx(Coord p, std::vector<size_t> &res) const = 0;
+
+    /**
+     * @brief Answer a batch of queries into a flat output.
+     * 
+     * The indices of the points in radius of queries[i] are
+     * idxs[offsets[i]], ..., idxs[offsets[i+1]-1].
+     * 
+     * @param queries   Query points
+     * @param offsets   Output; has size queries.size()+1
+     * @param idxs      Output; indices of the points in radius
+     * @param nThreads  Number of threads to split the queries across
+     */
+    virtual void getClosestPointsMany(
+        const std::vector<Coord> &queries,
+        std::vector<size_t> &offsets,
+        std::vector<size_t> &idxs,
+        size_t nThreads = 1
+    ) const;
+
+    class Cache;
+};
+
+/**
+ * @brief Memoizes queries to another ClosestPointsInRadius.
+ * 
+ * Queries are quantized to square cells of side q metres. The first query
+ * in a cell asks the underlying structure for all points within
+ * d + q*sqrt(2)/2 of the cell center, which is a superset of the answer for
+ * any point in the cell; that superset is cached, and every query filters
+ * it exactly. The cache is split in shards with independent locks, and
+ * each shard evicts its oldest cells once it goes over its share of the
+ * memory budget.
+ */
+class ClosestPointsInRadius::Cache: public ClosestPointsInRadius {
+public:
+    struct stats_t {
+        size_t hits;
+        size_t misses;
+        /// Total time spent answering hits (in seconds)
+        double hitTime;
+        /// Total time spent answering misses (in seconds)
+        double missTime;
+    };
+private:
+    typedef std::vector<uint32_t> entry_t;
+    struct shard_t {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, std::shared_ptr<const entry_t>> entries;
+        std::deque<uint64_t> fifo;
+        size_t bytes = 0;
+    };
+
+    static const size_t NUM_SHARDS = 64;
+
+    ClosestPointsInRadius &closestPointsInRadius;
+    const double q;
+    const size_t shardBudget;
+    double d;
+    std::vector<Coord> v;
+    mutable std::vector<shard_t> shards;
+
+    mutable std::atomic<size_t> hits, misses;
+    mutable std::atomic<long long> hitNanos, missNanos;
+
+    uint64_t getKey(const Coord &p, Coord &center) const;
+public:
+    /**
+     * @brief Construct cache.
+     * 
+     * @param closestPointsInRadius_    Underlying structure; is initialized by the cache
+     * @param q_                        Side of the cells (in metres)
+     * @param maxBytes                  Memory budget for cached cells (in bytes)
+     */
+    Cache(ClosestPointsInRadius &closestPointsInRadius_, double q_, size_t maxBytes);
+    void initialize(const std::list<Coord> &points, double d);
+    void run();
+    std::vector<Coord> getClosestPoints(Coord p) const;
+    void getClosestPointsIdx(Coord p, std::vector<size_t> &res) const;
+
+    stats_t getStats() const;
+    void resetStats();
 };
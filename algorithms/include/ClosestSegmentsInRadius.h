@@ -0,0 +1,52 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+#include "Coord.h"
+
+/**
+ * @brief Find all segments within a given distance of a point.
+ * 
+ */
+class ClosestSegmentsInRadius {
+public:
+    typedef std::pair<Coord, Coord> segment_t;
+
+    /**
+     * @brief A segment close to the query point.
+     */
+    struct result_t {
+        /// Position of the segment in the vector passed to initialize
+        size_t idx;
+        /// Point of the segment closest to the query point
+        Coord projection;
+        /// Distance along the segment from its first point to projection (in metres)
+        double offset;
+        /// Distance from the query point to projection (in metres)
+        double distance;
+    };
+
+    virtual ~ClosestSegmentsInRadius();
+
+    /**
+     * @brief Initializes data members
+     * 
+     * @param segments  Segments
+     * @param d         Radius (in metres)
+     */
+    virtual void initialize(const std::vector<segment_t> &segments, double d) = 0;
+
+    /**
+     * @brief Executes the algorithm
+     * 
+     */
+    virtual void run() = 0;
+
+    /**
+     * @brief Get segments closer than d to p.
+     * 
+     * @param p     Query point
+     * @param res   Segments are appended to res
+     */
+    virtual void getClosestSegments(Coord p, std::vector<result_t> &res) const = 0;
+};
@@ -13,4 +13,5 @@ public:
     void initialize(const std::list<Vector2> &points);
     void run();
     Vector2 getClosestPoint(Vector2 p) const;
+    size_t getClosestPointIdx(Vector2 p) const;
 };
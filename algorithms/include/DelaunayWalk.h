@@ -0,0 +1,86 @@
+#pragma once
+
+#include "ClosestPoint.h"
+
+#include <cstdint>
+
+/**
+ * @brief Closest point by greedy walk over the Delaunay triangulation.
+ * 
+ * From any site, if the query point is not in its Voronoi cell then some
+ * Delaunay neighbour is closer to the query; so moving to the closest
+ * neighbour until no neighbour is closer ends at the closest site. Starting
+ * the walk at the answer to the previous query makes queries along a
+ * trajectory take a few steps each.
+ */
+class DelaunayWalk: public ClosestPoint {
+private:
+    std::vector<Vector2> v;
+    std::vector<Vector2> sites;
+    std::vector<size_t> siteToIdx;
+    std::vector<size_t> adjStart;
+    std::vector<uint32_t> adj;
+
+    // Coarse grid with a starting site per cell, for queries without history
+    double xMin, yMin, cellW, cellH;
+    long nx, ny;
+    std::vector<uint32_t> seeds;
+
+    size_t getSeed(const Vector2 &p) const;
+public:
+    /**
+     * @brief Remembers the last answer, and starts each walk from there.
+     */
+    class Cursor {
+    private:
+        const DelaunayWalk &delaunayWalk;
+        size_t site;
+        bool started = false;
+        size_t steps = 0;
+    public:
+        Cursor(const DelaunayWalk &delaunayWalk_);
+
+        /**
+         * @brief Get index of the closest point to p.
+         * 
+         * @param p         Query point
+         * @return size_t   Position of the closest point in the list passed to initialize
+         */
+        size_t next(Vector2 p);
+
+        /**
+         * @brief Forget the last answer; the next query starts from the coarse grid.
+         */
+        void reset();
+
+        /**
+         * @brief Get total number of sites moved through, over all queries.
+         */
+        size_t getSteps() const;
+    };
+
+    void initialize(const std::list<Vector2> &points);
+    void run();
+    Vector2 getClosestPoint(Vector2 p) const;
+    size_t getClosestPointIdx(Vector2 p) const;
+
+    /**
+     * @brief Answer a batch of queries; each query starts from the answer of
+     * the previous query in the same thread.
+     */
+    void getClosestPointMany(
+        const std::vector<Vector2> &queries,
+        std::vector<size_t> &res,
+        size_t nThreads = 1
+    ) const;
+
+    /**
+     * @brief Walk from a site to the site closest to p.
+     * 
+     * @param p         Query point
+     * @param start     Site to start from
+     * @param steps     Incremented once per site moved through
+     * @return size_t   Closest site
+     */
+    size_t walk(const Vector2 &p, size_t start, size_t &steps) const;
+};
@@ -16,6 +16,7 @@ private:
     DWGraph::node_t s;
     std::list<DWGraph::node_t> d;
     const DWGraph::weight_t dMax;
+    DWGraph::weight_t dMaxSearch;
     std::unordered_map<DWGraph::node_t, DWGraph::weight_t> dist;
     
 public:
@@ -29,6 +30,12 @@ public:
      */
     void initialize(const DWGraph::DWGraph *G, DWGraph::node_t s, std::list<DWGraph::node_t> d_);
 
+    /**
+     * @brief Initializes, searching up to the smallest of dMax and the
+     * maximum given in the constructor
+     */
+    void initialize(const DWGraph::DWGraph *G, DWGraph::node_t s, std::list<DWGraph::node_t> d_, DWGraph::weight_t dMax);
+
     /**
      * @brief Execute the algorithm
      * 
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "ClosestPointsInRadius.h"
+
+#include <cstdint>
+
+/**
+ * @brief Fixed-radius neighbour queries over a uniform grid.
+ * 
+ * Cells are approximately d x d metres, so all points within distance d of
+ * a query are in the 3x3 block of cells around it. Cells are stored in CSR
+ * format: points of cell c are at positions cellStart[c], ...,
+ * cellStart[c+1]-1 of the packed arrays.
+ */
+class GridRadius: public ClosestPointsInRadius {
+private:
+    std::vector<Coord> v;
+    double d;
+    const size_t nThreads;
+
+    double xMin, yMin;
+    double cellW, cellH;
+    long nx, ny;
+    std::vector<uint32_t> cellStart;
+    std::vector<Coord> packed;
+    std::vector<uint32_t> packedIdx;
+
+    long getCellX(const Coord &p) const;
+    long getCellY(const Coord &p) const;
+protected:
+    /**
+     * @brief Sort queries by cell.
+     */
+    virtual std::vector<size_t> getQueryOrder(const std::vector<Coord> &queries) const;
+public:
+    /**
+     * @brief Construct grid.
+     * 
+     * @param nThreads_ Number of threads used to build the grid
+     */
+    GridRadius(size_t nThreads_ = 1);
+    void initialize(const std::list<Coord> &points, double width);
+    void run();
+    std::vector<Coord> getClosestPoints(Coord p) const;
+    void getClosestPointsIdx(Coord p, std::vector<size_t> &res) const;
+
+    /**
+     * @brief Get memory used by the grid, in bytes.
+     */
+    size_t getMemoryUsage() const;
+};
@@ -4,7 +4,12 @@
 
 #include "ClosestPointsInRadius.h"
 #include "ShortestPathFew.h"
-#include "ViterbiOptimized.h"
+#include "ViterbiLog.h"
+#include "ViterbiSparse.h"
+#include "utils.h"
+
+#include <cstdint>
+#include <deque>
 
 class HiddenMarkovModel: public MapMatching {
 private:
@@ -13,8 +18,69 @@ private:
     const double d;
     const double sigma_z;
     const double beta;
+    const size_t beamWidth;
+    const double beamMargin;
+    const bool lazy;
+    const double maxSpeed;
     const MapGraph *mapGraph;
     DWGraph::DWGraph distGraph;
+    std::vector<DWGraph::node_t> nodes;
+
+    static double emissionProbability(double sigma_z, double d);
+    static double transitionProbability(double beta, double dArc, double dRoute);
+    static double logTransitionProbability(double beta, double dArc, double dRoute);
+
+    /**
+     * @brief Append the scores of one observation.
+     *
+     * @param z          Observation
+     * @param dArc       Great-circle distance from the previous observation
+     * @param candidates Coordinates of the candidate states of z
+     * @param dRoute     Route distances from the previous candidates
+     * @param scores     Scores to append to
+     */
+    void addScores(
+        const Coord &z, double dArc,
+        const std::vector<Coord> &candidates,
+        const std::vector<double> &dRoute,
+        ViterbiLog::Scores &scores
+    ) const;
+
+    /**
+     * @brief Get states of a step whose transitions are explored.
+     *
+     * @param s Log scores of the states of the step
+     * @param n Number of states of the step
+     * @return std::vector<size_t> Reachable states in the beam, in order
+     */
+    std::vector<size_t> getBeam(const double *s, size_t n) const;
+
+    /**
+     * @brief Get route distances from the states of a step to the candidates
+     * of the next step.
+     *
+     * If lazy, sources are taken from the likeliest, and a pair is only
+     * searched if its optimistic score, with the great-circle distance as a
+     * lower bound of the route distance, can still improve its target.
+     * Pairs that are not searched cannot change the Viterbi result.
+     *
+     * @param s     Log scores of the states of the step
+     * @param beam  States of the step to search from
+     * @param from  Candidates of the step
+     * @param to    Candidates of the next step
+     * @param S     Coordinates of all candidates
+     * @param idxToNode Nodes of all candidates
+     * @param dArc  Great-circle distance between both observations
+     * @param dMax  Longest feasible route distance (in metres)
+     * @param D     Route distances (row-major, in metres); fINF if
+     *              unreachable or not searched
+     */
+    void getRouteDistances(
+        const double *s, const std::vector<size_t> &beam,
+        const std::vector<long> &from, const std::vector<long> &to,
+        const std::vector<Coord> &S, const std::vector<DWGraph::node_t> &idxToNode,
+        double dArc, double dMax, std::vector<double> &D
+    ) const;
 public:
     /**
      * @brief Construct a Hidden Markov Model.
@@ -22,16 +88,60 @@ public:
      * @param closestPointsInRadius_ Calculates nearest points
      * @param d_                     Radius to search candidate states for (in degrees)
      * @param sigma_z_               Variance of the observations (in metres)
+     * @param beamWidth_             Only the beamWidth likeliest states of
+     *                               each step are extended (0 for all)
+     * @param beamMargin_            Only states whose log score is within
+     *                               beamMargin of the best are extended
+     * @param lazy_                  Skip shortest path searches of pairs
+     *                               that cannot win (same result)
+     * @param maxSpeed_              Maximum plausible speed (in metres per
+     *                               second), to bound route distances when
+     *                               timestamps are given
      */
     HiddenMarkovModel(
         ClosestPointsInRadius &closestPointsInRadius_,
         ShortestPathFew &shortestPathFew_,
-        double d_, double sigma_z_, double beta_
+        double d_, double sigma_z_, double beta_,
+        size_t beamWidth_ = 0, double beamMargin_ = fINF,
+        bool lazy_ = true, double maxSpeed_ = fINF
     );
     virtual void initialize(const MapGraph *mapGraph_);
     virtual void run();
     virtual std::vector<DWGraph::node_t> getMatches(const std::vector<Coord> &trip) const;
 
+    /**
+     * @brief Get matches of a trip with timestamps.
+     *
+     * Between observations t-1 and t, the vehicle travels at most
+     * max(dArc, maxSpeed*(timestamps[t]-timestamps[t-1])), where dArc is the
+     * great-circle distance between both; candidates are up to d away from
+     * their observations, so routes longer than that plus 2d are dropped,
+     * and searches stop there.
+     *
+     * @param trip          Observations
+     * @param timestamps    Time of each observation (in seconds)
+     */
+    std::vector<DWGraph::node_t> getMatches(const std::vector<Coord> &trip, const std::vector<long long> &timestamps) const;
+
+    /**
+     * @brief Get log scores of a trip, computed once for all pairs.
+     *
+     * @param Y          Observations
+     * @param candidates Coordinates of the candidate states of each observation
+     * @param dRoute     Route distances from the candidates of step t-1 to
+     *                   those of step t, for t > 0 (row-major, in metres;
+     *                   fINF if unreachable)
+     * @param scores     Scores to fill
+     */
+    void getScores(
+        const std::vector<Coord> &Y,
+        const std::vector<std::vector<Coord>> &candidates,
+        const std::vector<std::vector<double>> &dRoute,
+        ViterbiLog::Scores &scores
+    ) const;
+
+    class Session;
+
     struct MyPi : public Viterbi::InitialProbabilitiesGenerator {
     private:
         const double sigma_z;
@@ -62,3 +172,69 @@ public:
         virtual double operator()(long i, long t) const;
     };
 };
+
+/**
+ * @brief Online matching of one vehicle, one observation at a time.
+ *
+ * Keeps the Viterbi columns of the observations that are not decided yet.
+ * After each observation, every step up to where the backpointers of all
+ * current states converge is final; the newest step is only decided with the
+ * next observation or by flush, so a single candidate does not lose the
+ * context of the next transition. If the window still holds more than
+ * maxLag steps, its oldest step is decided by the likeliest current state,
+ * and the states that do not descend from that decision are dropped; so
+ * memory and latency are bounded by maxLag.
+ *
+ * If no candidate of an observation can be reached from the previous one,
+ * the window is flushed and matching restarts from that observation.
+ *
+ * Sessions only read the model; sessions sharing a ShortestPathFew must be
+ * used from one thread at a time.
+ */
+class HiddenMarkovModel::Session {
+private:
+    static constexpr uint32_t INVALID = UINT32_MAX;
+
+    struct step_t {
+        std::vector<uint32_t> states; // Indices in the model's nodes
+        std::vector<double> prob;     // Relative to the likeliest state
+        std::vector<uint32_t> prev;   // Index of the previous state in the previous step
+    };
+
+    const HiddenMarkovModel &hmm;
+    ShortestPathFew &shortestPathFew;
+    const size_t maxLag;
+    Coord lastObservation;
+    std::deque<step_t> window;
+
+    void decide(size_t s, uint32_t k, std::vector<DWGraph::node_t> &matches);
+public:
+    /**
+     * @brief Start a session.
+     *
+     * @param hmm_              Initialized model
+     * @param shortestPathFew_  Calculates distances between candidates
+     * @param maxLag_           Maximum number of undecided observations
+     */
+    Session(const HiddenMarkovModel &hmm_, ShortestPathFew &shortestPathFew_, size_t maxLag_);
+
+    /**
+     * @brief Add an observation.
+     *
+     * @param z         Observation
+     * @return std::vector<DWGraph::node_t> Matches decided by this observation,
+     *                  continuing the ones returned before
+     */
+    std::vector<DWGraph::node_t> push(const Coord &z);
+
+    /**
+     * @brief Decide all pending observations, e.g. at the end of a trip; the
+     * session can then be reused for another trip.
+     */
+    std::vector<DWGraph::node_t> flush();
+
+    /**
+     * @brief Get number of observations not decided yet.
+     */
+    size_t getWindowSize() const;
+};
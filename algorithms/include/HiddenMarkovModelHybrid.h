@@ -0,0 +1,70 @@
+#pragma once
+
+#include "MapMatching.h"
+
+#include "HiddenMarkovModel.h"
+#include "ShortestPathFew.h"
+
+/**
+ * @brief Nearest-neighbour matching, with a Hidden Markov Model only where
+ * the nearest neighbour is doubtful.
+ *
+ * Every observation is first matched to its nearest node. A match is
+ * ambiguous if it is more than maxDistance away from its observation, and
+ * two consecutive matches are inconsistent if the route between them is not
+ * within maxDetour of the great-circle distance between their observations
+ * (the same quantity the HMM's transition probability penalizes). Ambiguous
+ * and inconsistent observations, widened by context observations on each
+ * side, form windows that are matched with the HMM; all other observations
+ * keep their nearest-neighbour match.
+ *
+ * Like the HMM, matching uses a shared ShortestPathFew, so a matcher must be
+ * used from one thread at a time.
+ */
+class HiddenMarkovModelHybrid: public MapMatching {
+public:
+    struct stats_t {
+        size_t points;
+        /// Points that kept their nearest-neighbour match
+        size_t fastPoints;
+        /// Windows matched with the HMM
+        size_t windows;
+    };
+private:
+    MapMatching::FromClosestPoint &nearestNeighbour;
+    HiddenMarkovModel &hmm;
+    ShortestPathFew &shortestPathFew;
+    const double maxDistance;
+    const double maxDetour;
+    const size_t context;
+    const MapGraph *mapGraph;
+    DWGraph::DWGraph distGraph;
+
+    mutable stats_t stats;
+public:
+    /**
+     * @brief Construct a hybrid matcher; both matchers are initialized and
+     * run by it.
+     *
+     * @param nearestNeighbour_ Nearest-neighbour matcher
+     * @param hmm_              Hidden Markov Model for doubtful windows
+     * @param shortestPathFew_  Calculates routes between consecutive matches
+     * @param maxDistance_      Farthest unambiguous match (in metres)
+     * @param maxDetour_        Largest difference between route and
+     *                          great-circle distances of consistent matches
+     *                          (in metres)
+     * @param context_          Observations added to each side of a window
+     */
+    HiddenMarkovModelHybrid(
+        MapMatching::FromClosestPoint &nearestNeighbour_,
+        HiddenMarkovModel &hmm_,
+        ShortestPathFew &shortestPathFew_,
+        double maxDistance_, double maxDetour_, size_t context_
+    );
+    virtual void initialize(const MapGraph *mapGraph_);
+    virtual void run();
+    virtual std::vector<DWGraph::node_t> getMatches(const std::vector<Coord> &trip) const;
+
+    stats_t getStats() const;
+    void resetStats();
+};
@@ -6,7 +6,14 @@
 #include "DijkstraDist.h"
 #include "ShortestPathFew.h"
 #include "utils.h"
-#include "ViterbiOptimized.h"
+#include "ViterbiSparse.h"
+
+#include <atomic>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
 
 class HiddenMarkovModelMany: public MapMatchingMany {
 private:
@@ -14,19 +21,35 @@ private:
     const double d;
     const double sigma_z;
     const double beta;
+    const double maxSpeed;
     const MapGraph *mapGraph;
     const std::vector<Trip> *trips;
     DWGraph::DWGraph distGraph;
+    std::vector<DWGraph::node_t> nodes;
 
+    const size_t nThreads;
     utils::ThreadPool threadPool;
 
-    std::deque<std::list<Coord>*> observations;
-    std::vector<std::set<DWGraph::node_t>> candidates;
-    std::mutex candidatesMutex;
-    static void candidatesWorker(HiddenMarkovModelMany *hmm, size_t idx);
+    /**
+     * @brief Get nodes that are candidates of some observation of some trip,
+     * as positions in nodes.
+     */
+    std::vector<size_t> getCandidates() const;
 
+    ShortestPathAll *shortestPathAll;
     std::map<DWGraph::node_t, DijkstraDist> dijkstras;
 
+    /**
+     * @brief Get path weights from u to each of v, from the precomputed
+     * searches or from shortestPathAll.
+     */
+    void getPathWeights(DWGraph::node_t u, const std::vector<DWGraph::node_t> &v, std::vector<DWGraph::weight_t> &res) const;
+
+    /**
+     * @brief Run bounded searches from every node that is a candidate.
+     */
+    void precompute();
+
     class TripTask: public utils::ThreadPool::Task {
     friend HiddenMarkovModelMany;
     private:
@@ -49,6 +72,12 @@ private:
     };
 
     std::map<long long, TripTask*> tripTasks;
+
+    /**
+     * @brief Estimate the time to match a trip, to schedule the longest
+     * trips first; it is about proportional to the number of observations.
+     */
+    static double getCost(const Trip &trip);
 public:
     /**
      * @brief Construct a Hidden Markov Model.
@@ -56,14 +85,217 @@ public:
      * @param closestPointsInRadius_ Calculates nearest points
      * @param d_                     Radius to search candidate states for (in degrees)
      * @param sigma_z_               Variance of the observations (in metres)
+     * @param maxSpeed_              Maximum plausible speed (in metres per
+     *                               second); transitions that would need to
+     *                               be faster are dropped
+     * @param shortestPathAll_       Thread-safe route distances, shared by
+     *                               all trips (e.g. ShortestPathAll::Cache);
+     *                               if null, bounded searches from every
+     *                               candidate are precomputed
      */
     HiddenMarkovModelMany(
         ClosestPointsInRadius &closestPointsInRadius_,
         double d_, double sigma_z_, double beta_,
-        size_t nThreads
+        size_t nThreads, double maxSpeed_ = fINF,
+        ShortestPathAll *shortestPathAll_ = nullptr
     );
     ~HiddenMarkovModelMany();
     virtual void initialize(const MapGraph *mapGraph_, const std::vector<Trip> &trips_);
+
+    /**
+     * @brief Initialize without trips, to match them one at a time with
+     * matchTrip; needs a ShortestPathAll.
+     */
+    void initialize(const MapGraph *mapGraph_);
+
+    /**
+     * @brief Prepare the state shared by all trips (closest points and route
+     * distances); run does this before matching.
+     */
+    void prepare();
+
+    /**
+     * @brief Match all trips, longest first, and report how long each thread
+     * was busy.
+     */
     virtual void run();
     virtual const std::vector<DWGraph::node_t> &getMatches(long long tripId) const;
+
+    /**
+     * @brief Match one trip, once prepared; can be called from several
+     * threads.
+     * 
+     * Trips of at least ViterbiParallel::DEFAULT_MIN_STEPS observations take
+     * all threads in spareThreads while they are decoded, and split Viterbi
+     * in time over them; the threads are given back afterwards.
+     * 
+     * @param trip          Trip
+     * @param matches       Output; matched node of each observation
+     * @param spareThreads  Idle threads that can be borrowed, or null
+     * @throws std::runtime_error if the trip cannot be matched
+     */
+    void matchTrip(const Trip &trip, std::vector<DWGraph::node_t> &matches, std::atomic<size_t> *spareThreads = nullptr) const;
+
+    class Pipeline;
+    class Checkpoint;
+};
+
+/**
+ * @brief Matches of a bulk run, committed in numbered segments so the run
+ * can be resumed.
+ * 
+ * Matches are written to dir/segment-NNNNNN.txt, in the same format as
+ * Pipeline writes to a stream, each segment covering segmentSize
+ * consecutive trips of the input. A segment is only listed in
+ * dir/manifest.txt once it is complete, and both files are replaced by
+ * renaming, so after a crash the manifest lists exactly the trips that need
+ * not be matched again.
+ * 
+ * The first line of the manifest identifies the run (input path, number of
+ * trips in the input and segment size); resuming a run with a different
+ * input or segment size throws, instead of mixing matches of both.
+ */
+class HiddenMarkovModelMany::Checkpoint {
+public:
+    static const std::string MANIFEST;
+
+    struct segment_t {
+        size_t index;
+        /// Position in the input of the segment's first trip
+        size_t firstTrip;
+        size_t trips;
+        /// Trips that were matched successfully
+        size_t written;
+    };
+private:
+    const std::string dir;
+    const size_t segmentSize;
+    const std::string input;
+    const size_t inputTrips;
+    std::vector<segment_t> segments;
+    size_t matchedTrips = 0;
+
+    std::ofstream os;
+    segment_t current;
+
+    std::string getSegmentPath(size_t index) const;
+public:
+    /**
+     * @brief Open checkpoint, reading the manifest in dir if there is one.
+     * 
+     * @param dir_          Existing directory for segments and manifest
+     * @param segmentSize_  Trips per segment
+     * @param input_        Path of the input trips file
+     * @param inputTrips_   Number of trips in the input
+     * @throws std::runtime_error if the manifest belongs to another input or
+     *                            segment size
+     */
+    Checkpoint(const std::string &dir_, size_t segmentSize_, const std::string &input_, size_t inputTrips_);
+
+    /**
+     * @brief Get number of trips at the start of the input that are in
+     * committed segments.
+     */
+    size_t getMatchedTrips() const;
+
+    const std::vector<segment_t> &getSegments() const;
+
+    /**
+     * @brief Write the matches of the next trip of the input.
+     * 
+     * @param trip      Trip
+     * @param matches   Matches, or null if the trip could not be matched
+     */
+    void write(const Trip &trip, const std::vector<DWGraph::node_t> *matches);
+
+    /**
+     * @brief Commit the current segment, even if it is not full.
+     */
+    void commit();
+};
+
+/**
+ * @brief Matches trips streamed from a binary trips file, and writes the
+ * results in file order.
+ * 
+ * A reader thread reads chunks of chunkSize trips and queues their trips
+ * longest first, workers match trips, and the calling thread writes the
+ * chunks in order once all their trips are matched. Ordering each chunk by
+ * cost keeps a long trip from being left running alone at the end; once the
+ * input is exhausted, workers left without trips lend their threads to the
+ * long trips still being decoded (see matchTrip). At most
+ * maxChunks chunks are read and not yet written, so memory does not depend
+ * on the number of trips: when the workers or the writer fall behind, the
+ * reader waits. Throughput and worker utilization are reported every
+ * reportPeriod seconds.
+ * 
+ * Each matched trip is written as its id and number of matches, followed by
+ * one matched node per line; trips that cannot be matched are skipped.
+ */
+class HiddenMarkovModelMany::Pipeline {
+private:
+    typedef std::function<void(const Trip&, const std::vector<DWGraph::node_t>*)> writer_t;
+
+    struct chunk_t {
+        size_t index;
+        std::vector<Trip> trips;
+        std::vector<std::vector<DWGraph::node_t>> matches;
+        std::vector<bool> success;
+        /// Trips not matched yet
+        std::atomic<size_t> left;
+    };
+    struct job_t {
+        std::shared_ptr<chunk_t> chunk;
+        size_t i;
+    };
+
+    const HiddenMarkovModelMany &hmm;
+    const size_t nThreads;
+    const size_t chunkSize;
+    const size_t maxChunks;
+    const double reportPeriod;
+
+    std::vector<double> busyTimes;
+
+    size_t run(Trip::Reader &reader, const writer_t &write);
+public:
+    /**
+     * @brief Construct pipeline.
+     * 
+     * @param hmm_          Prepared model
+     * @param nThreads_     Number of worker threads
+     * @param chunkSize_    Trips per chunk
+     * @param maxChunks_    Maximum chunks in memory
+     * @param reportPeriod_ Seconds between throughput reports
+     */
+    Pipeline(
+        const HiddenMarkovModelMany &hmm_,
+        size_t nThreads_, size_t chunkSize_, size_t maxChunks_,
+        double reportPeriod_ = 10.0
+    );
+
+    /**
+     * @brief Match all remaining trips of reader.
+     * 
+     * @param reader    Trips to match
+     * @param os        Stream to write matches to
+     * @return Number of trips written
+     */
+    size_t run(Trip::Reader &reader, std::ostream &os);
+
+    /**
+     * @brief Match the trips of reader that are not in checkpoint yet,
+     * committing segments as they are written.
+     * 
+     * @param reader        Trips to match, from the start of the file
+     * @param checkpoint    Checkpoint to resume from and write to
+     * @return Number of trips written in this run
+     */
+    size_t run(Trip::Reader &reader, Checkpoint &checkpoint);
+
+    /**
+     * @brief Get time each worker spent matching trips in the last run (in
+     * seconds).
+     */
+    const std::vector<double> &getBusyTimes() const;
 };
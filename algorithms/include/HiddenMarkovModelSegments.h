@@ -0,0 +1,81 @@
+#pragma once
+
+#include "MapMatching.h"
+
+#include "ClosestSegmentsInRadius.h"
+#include "ShortestPathFew.h"
+#include "ViterbiSparse.h"
+
+/**
+ * @brief Hidden Markov Model whose states are positions along road segments.
+ * 
+ * Each candidate state is an (edge, offset) pair, obtained by projecting an
+ * observation onto the road segments within radius d. Since candidates need
+ * not be graph nodes, this works on the original graph, without splitting
+ * long edges.
+ */
+class HiddenMarkovModelSegments: public MapMatching {
+public:
+    /**
+     * @brief Position along an edge.
+     */
+    struct match_t {
+        DWGraph::node_t u;
+        DWGraph::node_t v;
+        /// Distance from u (in metres)
+        double offset;
+        Coord coord;
+    };
+private:
+    ClosestSegmentsInRadius &closestSegmentsInRadius;
+    ShortestPathFew &shortestPathFew;
+    const double d;
+    const double sigma_z;
+    const double beta;
+    const MapGraph *mapGraph;
+    DWGraph::DWGraph distGraph;
+    std::vector<std::pair<DWGraph::node_t, DWGraph::node_t>> edges;
+    std::vector<double> lengths;
+public:
+    /**
+     * @brief Construct a Hidden Markov Model over road segments.
+     * 
+     * @param closestSegmentsInRadius_  Calculates nearest segments
+     * @param shortestPathFew_          Calculates distances between edges
+     * @param d_                        Radius to search candidate states for (in metres)
+     * @param sigma_z_                  Variance of the observations (in metres)
+     * @param beta_                     Transition probability parameter (in metres)
+     */
+    HiddenMarkovModelSegments(
+        ClosestSegmentsInRadius &closestSegmentsInRadius_,
+        ShortestPathFew &shortestPathFew_,
+        double d_, double sigma_z_, double beta_
+    );
+    virtual void initialize(const MapGraph *mapGraph_);
+    virtual void run();
+
+    /**
+     * @brief Get matches as nodes; each observation is matched to the
+     * closest endpoint of its edge.
+     */
+    virtual std::vector<DWGraph::node_t> getMatches(const std::vector<Coord> &trip) const;
+
+    std::vector<match_t> getMatchesOnEdges(const std::vector<Coord> &trip) const;
+
+    struct MyA : public Viterbi::TransitionMatrixGenerator {
+    private:
+        const double beta;
+        const std::vector<Coord> &Y;
+        const std::vector<size_t> &first;
+        const std::vector<std::vector<double>> &D;
+    public:
+        /**
+         * @param first_    States of step t are first[t], ..., first[t+1]-1
+         * @param D_        D[t][i*n+j] is the route distance from the i-th
+         *                  state of step t to the j-th state of step t+1,
+         *                  where step t+1 has n states
+         */
+        MyA(double beta_, const std::vector<Coord> &Y_, const std::vector<size_t> &first_, const std::vector<std::vector<double>> &D_);
+        virtual double operator()(long i, long j, long t) const;
+    };
+};
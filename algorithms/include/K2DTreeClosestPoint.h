@@ -11,10 +11,12 @@
  */
 class K2DTreeClosestPoint: public ClosestPoint{
 private:
+    std::vector<Vector2> v;
+    std::vector<size_t> ids;
     std::vector<Vector2> c;
     std::vector<double> split;
 
-    void search(const Vector2 &p, size_t r, Vector2 &cbest, double &dbest) const;
+    void search(const Vector2 &p, size_t r, size_t &ibest, double &dbest) const;
 public:
     /**
      * @brief Construct from degrees
@@ -37,4 +39,6 @@ public:
     void run();
 
     Vector2 getClosestPoint(const Vector2 p) const;
+
+    size_t getClosestPointIdx(const Vector2 p) const;
 };
@@ -21,6 +21,7 @@ private:
     ClosestPointFactory &closestPointFactory;
     ClosestPoint *closestPoint = nullptr;
     const MapGraph *mapGraph;
+    std::vector<DWGraph::node_t> nodes;
 public:
     FromClosestPoint(ClosestPointFactory &closestPointFactory_);
 
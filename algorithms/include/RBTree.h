@@ -630,6 +630,21 @@ public:
         return ret;
     }
 
+    template <
+        class U,
+        class Compare = std::less<U>
+    > const key_type *predecessor(const U &val, Compare comp = Compare()) const {
+        const key_type *ret = nullptr;
+
+        node_ptr_type u = root_;
+        while(u){
+            if   (comp(u->entry->key, val)){ ret = &u->entry->key; u = u->right; }
+            else                           {                       u = u->left ; }
+        }
+
+        return ret;
+    }
+
 private:
     node_ptr_type root_;
     std::size_t size_;
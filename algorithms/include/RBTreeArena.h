@@ -0,0 +1,414 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <set>
+#include <stack>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Persistent red-black tree with nodes allocated from an arena.
+ *
+ * Same algorithms as RBTree (Okasaki's insertion, Kahrs' deletion), but
+ * nodes are immutable values in a vector owned by an Arena and refer to
+ * their children by 32-bit index; keys are stored inline. Nodes are never
+ * freed individually: every version created from the same arena stays
+ * valid until the arena is cleared or destroyed. This suits structures that
+ * keep all versions, like slab decompositions, and avoids the allocations
+ * and atomic reference counting of shared pointers.
+ *
+ * @tparam T Key type
+ */
+template <
+    class T
+> class RBTreeArena {
+public:
+    typedef uint32_t node_t;
+    static const node_t NIL = std::numeric_limits<node_t>::max();
+
+    typedef T key_type;
+
+    struct Node {
+        key_type key;
+        node_t left;
+        node_t right;
+        bool red;
+    };
+
+    /**
+     * @brief Storage for the nodes of all versions of one or more trees.
+     */
+    class Arena {
+        friend class RBTreeArena;
+    private:
+        std::vector<Node> nodes;
+
+        node_t make(bool red, const key_type &key, node_t left, node_t right) {
+            nodes.push_back(Node{key, left, right, red});
+            return node_t(nodes.size() - 1);
+        }
+    public:
+        /**
+         * @brief Reserve space for n nodes.
+         */
+        void reserve(size_t n) { nodes.reserve(n); }
+
+        /**
+         * @brief Free all nodes, invalidating every tree using this arena.
+         */
+        void clear() { nodes.clear(); nodes.shrink_to_fit(); }
+
+        /**
+         * @brief Number of nodes allocated.
+         */
+        size_t size() const { return nodes.size(); }
+
+        /**
+         * @brief Get memory used by the nodes, in bytes.
+         */
+        size_t getMemoryUsage() const { return nodes.capacity() * sizeof(Node); }
+    };
+
+private:
+    Arena *arena;
+    node_t root_;
+    std::size_t size_;
+
+    RBTreeArena(Arena *arena_, node_t root, std::size_t size) : arena(arena_), root_(root), size_(size) {}
+
+    const Node &at(node_t u) const { return arena->nodes[u]; }
+    bool isRed(node_t u) const { return u != NIL && at(u).red; }
+    bool isBlack(node_t u) const { return u != NIL && !at(u).red; }
+
+    node_t make(bool red, const key_type &key, node_t left, node_t right) const {
+        return arena->make(red, key, left, right);
+    }
+
+    node_t copyAsBlack(node_t u) const {
+        const Node n = at(u);
+        return make(false, n.key, n.left, n.right);
+    }
+
+    node_t copyAsRed(node_t u) const {
+        const Node n = at(u);
+        return make(true, n.key, n.left, n.right);
+    }
+
+    // Nodes are copied out before calling make(), which may reallocate the arena
+
+    node_t balanceInsert(node_t u) const {
+        const Node n = at(u);
+        if (n.red) return u;
+
+        if (isRed(n.left)) {
+            const Node l = at(n.left);
+            // case: (Some(R), Some(R), ..)
+            if (isRed(l.left)) {
+                const Node ll = at(l.left);
+                const node_t new_left  = make(false, ll.key, ll.left, ll.right);
+                const node_t new_right = make(false, n.key, l.right, n.right);
+                return make(true, l.key, new_left, new_right);
+            }
+            // case: (Some(R), _, Some(R), ..)
+            if (isRed(l.right)) {
+                const Node lr = at(l.right);
+                const node_t new_left  = make(false, l.key, l.left, lr.left);
+                const node_t new_right = make(false, n.key, lr.right, n.right);
+                return make(true, lr.key, new_left, new_right);
+            }
+        }
+
+        if (isRed(n.right)) {
+            const Node r = at(n.right);
+            // case: (.., Some(R), Some(R), _)
+            if (isRed(r.left)) {
+                const Node rl = at(r.left);
+                const node_t new_left  = make(false, n.key, n.left, rl.left);
+                const node_t new_right = make(false, r.key, rl.right, r.right);
+                return make(true, rl.key, new_left, new_right);
+            }
+            // case: (.., Some(R), _, Some(R))
+            if (isRed(r.right)) {
+                const Node rr = at(r.right);
+                const node_t new_left  = make(false, n.key, n.left, r.left);
+                const node_t new_right = make(false, rr.key, rr.left, rr.right);
+                return make(true, r.key, new_left, new_right);
+            }
+        }
+
+        return u;
+    }
+
+    template<
+        class Compare
+    > std::pair<node_t, bool> insert(node_t u, const key_type &key, Compare comp) const {
+        if (u == NIL) return std::make_pair(make(true, key, NIL, NIL), true);
+
+        const Node n = at(u);
+        if (comp(key, n.key)) {
+            const auto [new_left, is_new_key] = insert(n.left, key, comp);
+            const node_t new_node = make(n.red, n.key, new_left, n.right);
+            return std::make_pair(is_new_key ? balanceInsert(new_node) : new_node, is_new_key);
+        } else if (comp(n.key, key)) {
+            const auto [new_right, is_new_key] = insert(n.right, key, comp);
+            const node_t new_node = make(n.red, n.key, n.left, new_right);
+            return std::make_pair(is_new_key ? balanceInsert(new_node) : new_node, is_new_key);
+        } else {
+            return std::make_pair(make(n.red, key, n.left, n.right), false);
+        }
+    }
+
+    node_t fuse(node_t left, node_t right) const {
+        // case: (None, r)
+        if (left == NIL) return right;
+        // case: (l, None)
+        if (right == NIL) return left;
+
+        const Node l = at(left);
+        const Node r = at(right);
+
+        // case: (B, R)
+        if (!l.red && r.red) {
+            const node_t fused = fuse(left, r.left);
+            return make(true, r.key, fused, r.right);
+        }
+        // case: (R, B)
+        if (l.red && !r.red) {
+            const node_t fused = fuse(l.right, right);
+            return make(true, l.key, l.left, fused);
+        }
+        // case: (R, R)
+        if (l.red && r.red) {
+            const node_t fused = fuse(l.right, r.left);
+            if (isRed(fused)) {
+                const Node f = at(fused);
+                const node_t new_left  = make(true, l.key, l.left, f.left);
+                const node_t new_right = make(true, r.key, f.right, r.right);
+                return make(true, f.key, new_left, new_right);
+            }
+            const node_t new_right = make(true, r.key, fused, r.right);
+            return make(true, l.key, l.left, new_right);
+        }
+        // case: (B, B)
+        const node_t fused = fuse(l.right, r.left);
+        if (isRed(fused)) {
+            const Node f = at(fused);
+            const node_t new_left  = make(false, l.key, l.left, f.left);
+            const node_t new_right = make(false, r.key, f.right, r.right);
+            return make(true, f.key, new_left, new_right);
+        }
+        const node_t new_right = make(false, r.key, fused, r.right);
+        const node_t new_node = make(true, l.key, l.left, new_right);
+        return balanceLeft(new_node);
+    }
+
+    node_t balance(node_t u) const {
+        const Node n = at(u);
+        if (isRed(n.left) && isRed(n.right)) {
+            const node_t new_left  = copyAsBlack(n.left);
+            const node_t new_right = copyAsBlack(n.right);
+            return make(true, n.key, new_left, new_right);
+        }
+        return balanceInsert(u);
+    }
+
+    node_t balanceLeft(node_t u) const {
+        const Node n = at(u);
+        // case: (Some(R), ..)
+        if (isRed(n.left)) {
+            const Node l = at(n.left);
+            const node_t new_left = make(false, l.key, l.left, l.right);
+            return make(true, n.key, new_left, n.right);
+        }
+        // case: (_, Some(B), _)
+        if (isBlack(n.right)) {
+            const Node r = at(n.right);
+            const node_t new_right = make(true, r.key, r.left, r.right);
+            const node_t new_node = make(false, n.key, n.left, new_right);
+            return balance(new_node);
+        }
+        // case: (_, Some(R), Some(B))
+        if (isRed(n.right) && isBlack(at(n.right).left)) {
+            const Node r = at(n.right);
+            const Node rl = at(r.left);
+            const node_t red_rr = copyAsRed(r.right);
+            const node_t unbalanced_new_right = make(false, r.key, rl.right, red_rr);
+            const node_t new_right = balance(unbalanced_new_right);
+            const node_t new_left = make(false, n.key, n.left, rl.left);
+            return make(true, rl.key, new_left, new_right);
+        }
+        throw std::runtime_error("RBTreeArena::balanceLeft runtime error");
+    }
+
+    node_t balanceRight(node_t u) const {
+        const Node n = at(u);
+        // case: (.., Some(R))
+        if (isRed(n.right)) {
+            const Node r = at(n.right);
+            const node_t new_right = make(false, r.key, r.left, r.right);
+            return make(true, n.key, n.left, new_right);
+        }
+        // case: (Some(B), ..)
+        if (isBlack(n.left)) {
+            const Node l = at(n.left);
+            const node_t new_left = make(true, l.key, l.left, l.right);
+            const node_t new_node = make(false, n.key, new_left, n.right);
+            return balance(new_node);
+        }
+        // case: (Some(R), Some(B), _)
+        if (isRed(n.left) && isBlack(at(n.left).right)) {
+            const Node l = at(n.left);
+            const Node lr = at(l.right);
+            const node_t red_ll = copyAsRed(l.left);
+            const node_t unbalanced_new_left = make(false, l.key, red_ll, lr.left);
+            const node_t new_left = balance(unbalanced_new_left);
+            const node_t new_right = make(false, n.key, lr.right, n.right);
+            return make(true, lr.key, new_left, new_right);
+        }
+        throw std::runtime_error("RBTreeArena::balanceRight runtime error");
+    }
+
+    template<
+        class Compare
+    > std::pair<node_t, bool> remove(node_t u, const key_type &key, Compare comp) const {
+        if (u == NIL) return std::make_pair(NIL, false);
+
+        const Node n = at(u);
+        if (comp(key, n.key)) {
+            const auto [new_left, removed] = remove(n.left, key, comp);
+            // In case of rebalance the color does not matter
+            const node_t new_node = make(true, n.key, new_left, n.right);
+            return std::make_pair(isBlack(n.left) ? balanceLeft(new_node) : new_node, removed);
+        } else if (comp(n.key, key)) {
+            const auto [new_right, removed] = remove(n.right, key, comp);
+            const node_t new_node = make(true, n.key, n.left, new_right);
+            return std::make_pair(isBlack(n.right) ? balanceRight(new_node) : new_node, removed);
+        } else {
+            return std::make_pair(fuse(n.left, n.right), true);
+        }
+    }
+
+    // http://www.eternallyconfuzzled.com/tuts/datastructures/jsw_tut_rbtree.aspx
+    template<
+        class Compare
+    > std::size_t checkConsistency(node_t u, Compare comp) const {
+        if (u == NIL) return 1;
+
+        const Node &n = at(u);
+        if (n.red && (isRed(n.left) || isRed(n.right))) return 0;
+
+        if ((n.left  != NIL && !comp(at(n.left).key, n.key)) ||
+            (n.right != NIL && !comp(n.key, at(n.right).key))) return 0;
+
+        const std::size_t lh = checkConsistency(n.left, comp);
+        const std::size_t rh = checkConsistency(n.right, comp);
+
+        if (lh == 0 || rh == 0 || lh != rh) return 0;
+
+        return n.red ? lh : lh + 1;
+    }
+
+public:
+    /**
+     * @brief Empty tree, whose versions allocate nodes from arena.
+     */
+    explicit RBTreeArena(Arena &arena_) : arena(&arena_), root_(NIL), size_(0) {}
+
+    template<
+        class Compare = std::less<T>
+    > RBTreeArena insert(const key_type &key, Compare comp = Compare()) const {
+        const auto [mb_new_root, is_new_key] = insert(root_, key, comp);
+        const node_t new_root = copyAsBlack(mb_new_root);  // mb = maybe black
+        return RBTreeArena(arena, new_root, size_ + (is_new_key ? 1 : 0));
+    }
+
+    template<
+        class Compare = std::less<T>
+    > RBTreeArena remove(const key_type &key, Compare comp = Compare()) const {
+        const auto [mb_new_root, removed] = remove(root_, key, comp);
+        if (!removed) return *this;
+        const node_t new_root = mb_new_root != NIL ? copyAsBlack(mb_new_root) : NIL;
+        return RBTreeArena(arena, new_root, size_ - 1);
+    }
+
+    std::set<key_type> items() const {
+        std::set<key_type> out;
+        node_t u = root_;
+        std::stack<node_t> s;
+        while (!s.empty() || u != NIL) {
+            if (u != NIL) {
+                s.push(u);
+                u = at(u).left;
+            } else {
+                u = s.top();
+                s.pop();
+                out.emplace(at(u).key);
+                u = at(u).right;
+            }
+        }
+        return out;
+    }
+
+    auto size() const {
+        return size_;
+    }
+
+    template<
+        class Compare = std::less<T>
+    > bool consistent(Compare comp = Compare()) const {
+        return checkConsistency(root_, comp) != 0;
+    }
+
+    void clear() {
+        root_ = NIL;
+        size_ = 0;
+    }
+
+    /**
+     * @brief Smallest key not less than val.
+     *
+     * @return const key_type*  Pointer to key, valid until the arena grows;
+     *                          or nullptr if there is no such key
+     */
+    template <
+        class U,
+        class Compare = std::less<U>
+    > const key_type *lower_bound(const U &val, Compare comp = Compare()) const {
+        const key_type *ret = nullptr;
+
+        node_t u = root_;
+        while(u != NIL){
+            const Node &n = at(u);
+            if   (comp(n.key, val)){                 u = n.right; }
+            else                   { ret = &n.key;   u = n.left ; }
+        }
+
+        return ret;
+    }
+
+    /**
+     * @brief Largest key less than val.
+     *
+     * @return const key_type*  Pointer to key, valid until the arena grows;
+     *                          or nullptr if there is no such key
+     */
+    template <
+        class U,
+        class Compare = std::less<U>
+    > const key_type *predecessor(const U &val, Compare comp = Compare()) const {
+        const key_type *ret = nullptr;
+
+        node_t u = root_;
+        while(u != NIL){
+            const Node &n = at(u);
+            if   (comp(n.key, val)){ ret = &n.key;   u = n.right; }
+            else                   {                 u = n.left ; }
+        }
+
+        return ret;
+    }
+};
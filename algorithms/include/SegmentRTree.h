@@ -0,0 +1,46 @@
+#pragma once
+
+#include "ClosestSegmentsInRadius.h"
+
+/**
+ * @brief R-tree over segments, bulk-loaded with Sort-Tile-Recursive.
+ * 
+ * Nodes are stored in a single vector, with the children of a node in
+ * consecutive positions; segments are stored in leaf order.
+ */
+class SegmentRTree: public ClosestSegmentsInRadius {
+private:
+    struct box_t {
+        double xMin, yMin, xMax, yMax;
+        void add(const box_t &b);
+        bool intersects(const box_t &b) const;
+    };
+    struct tree_node_t {
+        box_t box;
+        size_t first;
+        size_t count;
+        bool leaf;
+    };
+
+    const size_t B;
+    double d;
+
+    std::vector<segment_t> segments;
+    std::vector<size_t> ids;
+    std::vector<double> lengths;
+    std::vector<tree_node_t> tree;
+    size_t root;
+
+    static box_t getBox(const segment_t &s);
+    static std::vector<size_t> sortTileRecursive(const std::vector<box_t> &boxes, size_t B);
+public:
+    /**
+     * @brief Construct R-tree.
+     * 
+     * @param B_    Maximum number of children of each node
+     */
+    SegmentRTree(size_t B_ = 16);
+    void initialize(const std::vector<segment_t> &segments, double d);
+    void run();
+    void getClosestSegments(Coord p, std::vector<result_t> &res) const;
+};
@@ -1,10 +1,14 @@
 #ifndef SHORTESTPATHALL_H_INCLUDED
 #define SHORTESTPATHALL_H_INCLUDED
 
+#include <atomic>
 #include <list>
+#include <mutex>
 #include <vector>
 #include <queue>
 #include <thread>
+#include <unordered_map>
+#include <utility>
 
 #include "DWGraph.h"
 #include "ShortestPathOneMany.h"
@@ -51,12 +55,24 @@ public:
 
     virtual DWGraph::weight_t getPathWeight(DWGraph::node_t s, DWGraph::node_t d) const = 0;
 
+    /**
+     * @brief Get path weights from s to several destinations at once.
+     * 
+     * Defaults to calling getPathWeight for each destination.
+     * 
+     * @param s     Starting Node
+     * @param d     Destination Nodes
+     * @param res   Output; res[i] is the path weight from s to d[i]
+     */
+    virtual void getPathWeights(DWGraph::node_t s, const std::vector<DWGraph::node_t> &d, std::vector<DWGraph::weight_t> &res) const;
+
     /**
      * @brief Shortest Path Between every of the Nodes provided and any other Node
      * 
      */
     class FromOneMany;
     class FromFew;
+    class Cache;
 };
 
 class ShortestPathAll::FromOneMany : public ShortestPathAll {
@@ -117,4 +133,79 @@ public:
     DWGraph::weight_t getPathWeight(DWGraph::node_t s, DWGraph::node_t d) const;
 };
 
+/**
+ * @brief Concurrent cache of bounded path weights between pairs of nodes.
+ * 
+ * A request for several destinations of the same source searches all the
+ * missing ones with a single bounded Dijkstra, and caches every answer,
+ * including paths longer than dMax (reported as iINF). Entries are split in
+ * shards by pair, each with its own lock and a CLOCK ring: hits set the
+ * entry's reference bit, and a full shard evicts the first entry its hand
+ * finds without it, clearing the bits it passes. Threads that miss the same
+ * pair at the same time may both search it.
+ */
+class ShortestPathAll::Cache : public ShortestPathAll {
+public:
+    struct stats_t {
+        size_t hits;
+        size_t misses;
+        /// Searches run to answer misses
+        size_t searches;
+        size_t evictions;
+    };
+private:
+    typedef std::pair<DWGraph::node_t, DWGraph::node_t> key_t;
+    struct keyHash {
+        size_t operator()(const key_t &k) const;
+    };
+    struct entry_t {
+        key_t key;
+        DWGraph::weight_t w;
+        bool referenced;
+    };
+    struct shard_t {
+        std::mutex mutex;
+        std::unordered_map<key_t, size_t, keyHash> index;
+        std::vector<entry_t> ring;
+        size_t hand = 0;
+    };
+
+    static const size_t NUM_SHARDS = 64;
+    static const size_t ENTRY_BYTES;
+
+    const DWGraph::weight_t dMax;
+    const size_t shardCapacity;
+    const DWGraph::DWGraph *G = nullptr;
+    mutable std::vector<shard_t> shards;
+
+    mutable std::atomic<size_t> hits, misses, searches, evictions;
+
+    shard_t &getShard(const key_t &key) const;
+    bool find(const key_t &key, DWGraph::weight_t &w) const;
+    void insert(const key_t &key, DWGraph::weight_t w) const;
+public:
+    /**
+     * @brief Construct cache.
+     * 
+     * @param dMax_     Maximum path weight searched
+     * @param maxBytes  Memory budget for cached pairs (in bytes)
+     */
+    Cache(DWGraph::weight_t dMax_, size_t maxBytes);
+
+    /**
+     * @brief Set the graph; the cache is only cleared if the graph changes,
+     * so it is kept across initializations from ShortestPathFew::FromAll.
+     * 
+     * @param G Directed Weighted Graph
+     */
+    void initialize(const DWGraph::DWGraph *G);
+    void run();
+    DWGraph::node_t getPrev(DWGraph::node_t s, DWGraph::node_t d) const;
+    DWGraph::weight_t getPathWeight(DWGraph::node_t s, DWGraph::node_t d) const;
+    void getPathWeights(DWGraph::node_t s, const std::vector<DWGraph::node_t> &d, std::vector<DWGraph::weight_t> &res) const;
+
+    stats_t getStats() const;
+    void resetStats();
+};
+
 #endif //SHORTESTPATHALL_H_INCLUDED
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <list>
+#include <unordered_map>
+#include <vector>
 
 #include "DWGraph.h"
 #include "ShortestPathAll.h"
@@ -23,6 +25,17 @@ public:
      */
     virtual void initialize(const DWGraph::DWGraph *G, DWGraph::node_t s, std::list<DWGraph::node_t> d) = 0;
 
+    /**
+     * @brief Initializes, when paths longer than dMax are not needed; those
+     * may be reported as unreachable. By default, dMax is ignored.
+     *
+     * @param G     Directed Weighted Graph
+     * @param s     Starting Node
+     * @param d     Destination Nodes
+     * @param dMax  Maximum path weight of interest
+     */
+    virtual void initialize(const DWGraph::DWGraph *G, DWGraph::node_t s, std::list<DWGraph::node_t> d, DWGraph::weight_t dMax);
+
     virtual DWGraph::node_t getStart() const = 0;
     virtual std::list<DWGraph::node_t> getDest () const = 0;
 
@@ -65,8 +78,11 @@ class ShortestPathFew::FromAll : public ShortestPathFew {
 private:
     ShortestPathAll &shortestPathAll;
     DWGraph::node_t s;
+    std::vector<DWGraph::node_t> d;
+    std::unordered_map<DWGraph::node_t, DWGraph::weight_t> dist;
 public:
     FromAll(ShortestPathAll &shortestPathAll_);
+    using ShortestPathFew::initialize;
     virtual void initialize(const DWGraph::DWGraph *G, DWGraph::node_t s, std::list<DWGraph::node_t> d);
     virtual void run();
     virtual DWGraph::node_t getStart() const;
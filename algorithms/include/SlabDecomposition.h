@@ -8,22 +8,24 @@
 class SlabDecomposition : public VoronoiDecomposition {
 private:
     struct cmp_t {
+        const std::vector<Edge> *edges;
         double x;
-        bool operator()(const Edge *lhs, const Edge *rhs) const {
-            return lhs->evaluateY(x) < rhs->evaluateY(x);
+        bool operator()(Voronoi::idx_t lhs, Voronoi::idx_t rhs) const {
+            return (*edges)[lhs].evaluateY(x) < (*edges)[rhs].evaluateY(x);
         }
     };
 
     struct Event {
         bool start;
-        const Edge *e;
+        Voronoi::idx_t e;
     };
 
-    std::vector<const Edge*> edges;
+    std::vector<Edge> edges;
+    std::vector<Site> sites;
     std::map<double, std::list<Event>> events;
-    std::map<double, std::vector<const Edge*>> slabs;
+    std::map<double, std::vector<Voronoi::idx_t>> slabs;
 public:
-    void initialize(const std::list<Edge> &edges);
+    void initialize(const VoronoiDiagram &diagram);
     void run();
     Vector2 getClosestPoint(Vector2 p) const;
 };
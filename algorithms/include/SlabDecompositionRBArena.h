@@ -0,0 +1,51 @@
+#pragma once
+
+#include "VoronoiDecomposition.h"
+
+#include "RBTreeArena.h"
+
+#include <map>
+#include <list>
+
+/**
+ * @brief Slab decomposition with persistent red-black trees whose nodes
+ * are allocated from a single arena.
+ *
+ * Same as SlabDecompositionRB, but slab versions share an RBTreeArena
+ * instead of reference-counted nodes, since no version is ever freed
+ * before the decomposition itself.
+ */
+class SlabDecompositionRBArena : public VoronoiDecomposition {
+private:
+    struct cmp_t {
+        const std::vector<Edge> *edges;
+        double x;
+        bool operator()(Voronoi::idx_t lhs, Voronoi::idx_t rhs) const {
+            return (*edges)[lhs].evaluateY(x) < (*edges)[rhs].evaluateY(x);
+        }
+    };
+
+    struct Event {
+        bool start;
+        Voronoi::idx_t e;
+    };
+
+    std::vector<Edge> edges;
+    std::vector<Site> sites;
+    std::map<double, std::list<Event>> events;
+    RBTreeArena<Voronoi::idx_t>::Arena arena;
+    std::map<double, RBTreeArena<Voronoi::idx_t>> slabs;
+public:
+    SlabDecompositionRBArena() = default;
+    SlabDecompositionRBArena(const SlabDecompositionRBArena &) = delete;
+    SlabDecompositionRBArena &operator=(const SlabDecompositionRBArena &) = delete;
+
+    void initialize(const VoronoiDiagram &diagram);
+    void run();
+    Vector2 getClosestPoint(Vector2 p) const;
+
+    /**
+     * @brief Get memory used by tree nodes of all slabs, in bytes.
+     */
+    size_t getTreeMemoryUsage() const;
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "VoronoiDecomposition.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Point location in a Voronoi diagram using a trapezoidal map.
+ *
+ * The map and its search DAG are built by randomized incremental
+ * construction over the edges of the diagram, taking O(n) expected space
+ * and O(n log n) expected time; queries take O(log n) expected time.
+ * Points are ordered lexicographically (by x, then by y), so vertical
+ * edges and shared endpoints need no special treatment.
+ *
+ * Edges with no site on either side, like the bounds of the diagram, are
+ * ignored; the map is enclosed in a frame larger than the edges. Once
+ * built, leaves of the DAG refer to the site of their trapezoid and the
+ * trapezoids themselves are freed.
+ */
+class TrapezoidalMap : public VoronoiDecomposition {
+private:
+    typedef Voronoi::idx_t idx_t;
+
+    struct Segment {
+        Vector2 p;  // Left endpoint
+        Vector2 q;  // Right endpoint
+        idx_t site_up;
+        idx_t site_down;
+    };
+
+    struct Trapezoid {
+        idx_t top, bottom;
+        Vector2 leftp, rightp;
+        idx_t upper_left  = Voronoi::INVALID_IDX;   // Left neighbour with the same top
+        idx_t lower_left  = Voronoi::INVALID_IDX;   // Left neighbour with the same bottom
+        idx_t upper_right = Voronoi::INVALID_IDX;
+        idx_t lower_right = Voronoi::INVALID_IDX;
+        idx_t node = Voronoi::INVALID_IDX;          // Leaf of the search DAG
+    };
+
+    struct Node {
+        enum Type : uint8_t { X, Y, LEAF } type;
+        idx_t i;        // Segment (Y); trapezoid (LEAF, while building) or site (LEAF)
+        idx_t left;     // Left of point (X) or above segment (Y)
+        idx_t right;    // Right of point (X) or below segment (Y)
+        Vector2 point;  // X only
+    };
+
+    std::vector<Site> sites;
+    std::vector<Segment> segments;
+    std::vector<Trapezoid> trapezoids;
+    std::vector<Node> nodes;
+    idx_t root = Voronoi::INVALID_IDX;
+
+    std::vector<idx_t> crossed, upper, lower;
+
+    static double orientation(const Segment &s, Vector2 r);
+    bool isAbove(idx_t s, Vector2 r) const;
+
+    idx_t newTrapezoid(idx_t top, idx_t bottom, Vector2 leftp, Vector2 rightp);
+    idx_t leafOf(idx_t t);
+
+    idx_t siteOf(const Trapezoid &t) const;
+    void compact();
+
+    idx_t locate(Vector2 p) const;
+    idx_t locateSegment(const Segment &s) const;
+    void insertSegment(idx_t s);
+public:
+    void initialize(const VoronoiDiagram &diagram);
+    void run();
+    Vector2 getClosestPoint(Vector2 p) const;
+
+    /**
+     * @brief Get memory used by segments and the search DAG, in bytes.
+     */
+    size_t getMemoryUsage() const;
+};
@@ -11,12 +11,21 @@ private:
     const double d;
     double xMin;
     std::vector<std::vector<Vector2>> stripes;
+    std::vector<std::vector<size_t>> stripesIdx;
 
-    void checkStripe(const Vector2 &p, size_t i, double &dBest, Vector2 &cBest) const;
+    size_t getStripe(const Vector2 &p) const;
+    void checkStripe(const Vector2 &p, size_t i, double &dBest, size_t &iBest) const;
+protected:
+    /**
+     * @brief Sort queries by stripe, then by y.
+     */
+    virtual std::vector<size_t> getQueryOrder(const std::vector<Vector2> &queries) const;
 public:
     VStripes(double width);
     void initialize(const std::list<Vector2> &points);
     void run();
     Vector2 getClosestPoint(Vector2 p) const;
+    size_t getClosestPointIdx(Vector2 p) const;
     std::pair<bool, Vector2> getClosestPoint_success(Vector2 p) const;
+    std::pair<bool, size_t> getClosestPointIdx_success(Vector2 p) const;
 };
@@ -9,10 +9,23 @@ private:
 
     double xMin;
     std::vector<std::vector<Coord>> stripes;
+    std::vector<std::vector<size_t>> stripesIdx;
 
-    void checkStripe(const Coord &p, size_t i, std::vector<Coord> &sols) const;
+    size_t getStripe(const Coord &p) const;
+    void checkStripe(const Coord &p, size_t i, std::vector<size_t> &sols) const;
+protected:
+    /**
+     * @brief Sort queries by stripe, then by latitude.
+     */
+    virtual std::vector<size_t> getQueryOrder(const std::vector<Coord> &queries) const;
 public:
     void initialize(const std::list<Coord> &points, double width);
     void run();
     std::vector<Coord> getClosestPoints(Coord p) const;
+    void getClosestPointsIdx(Coord p, std::vector<size_t> &res) const;
+
+    /**
+     * @brief Get memory used by the stripes, in bytes.
+     */
+    size_t getMemoryUsage() const;
 };
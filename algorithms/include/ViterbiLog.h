@@ -0,0 +1,135 @@
+#pragma once
+
+#include "Viterbi.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <set>
+
+/**
+ * @brief Viterbi in log space over precomputed score blocks.
+ *
+ * Each step t has a vector of log emissions for its states and a block of
+ * log transitions from the states of step t-1, so the kernel only adds and
+ * compares numbers in contiguous arrays (max-plus product). Rows are padded
+ * to a multiple of LANES and processed LANES states at a time with vector
+ * instructions; layers of up to 4*LANES states keep all their accumulators
+ * in registers.
+ */
+class ViterbiLog {
+public:
+    typedef uint16_t local_t;
+
+    static constexpr size_t LANES = 4;
+
+    /**
+     * @brief Log score of something impossible. Finite, so it also works with
+     * -ffinite-math-only.
+     */
+    static constexpr double LOG_ZERO = -1e300;
+
+    /**
+     * @brief Log scores of all steps.
+     *
+     * Step 0 has only emissions, which are the initial scores. Step t > 0
+     * also has transitions from step t-1: row i, column j is the transition
+     * from state i of step t-1 to state j of step t, rows getStride(t) apart.
+     */
+    class Scores {
+    private:
+        std::vector<size_t> sz;
+        std::vector<size_t> emissionBegin;
+        std::vector<size_t> transitionBegin;
+        std::vector<double> emissions;
+        std::vector<double> transitions;
+    public:
+        void clear();
+
+        /**
+         * @brief Append a step with n states; all its scores are LOG_ZERO.
+         */
+        void addStep(size_t n);
+
+        size_t getSteps() const;
+        size_t getSize(size_t t) const;
+        size_t getStride(size_t t) const;
+
+        double *emission(size_t t);
+        const double *emission(size_t t) const;
+        double *transition(size_t t);
+        const double *transition(size_t t) const;
+
+        /**
+         * @brief Scores from probability generators, as used by
+         * ViterbiOptimized.
+         */
+        static Scores fromGenerators(
+            const Viterbi::InitialProbabilitiesGenerator *Pi,
+            const Viterbi::TransitionMatrixGenerator *A,
+            const Viterbi::EmissionMatrixGenerator *B,
+            const std::vector<std::set<long>> &candidates
+        );
+    };
+private:
+    const Scores *scores;
+    size_t first, last;          // Decode steps [first, last)
+    std::vector<double>  initial;
+    std::vector<size_t>  begin;  // Step first+l is [begin[l], begin[l+1])
+    std::vector<double>  score;
+    std::vector<local_t> prev;   // Index of the previous state, in step t-1
+
+    template<size_t V> void runBlocks(size_t t, size_t k);
+public:
+    /**
+     * @brief Initialize.
+     *
+     * @param scores_ Scores; at most 2^16 - 1 states per step
+     */
+    void initialize(const Scores *scores_);
+
+    /**
+     * @brief Initialize to decode only steps [first_, last_), starting with
+     * given log scores for the states of step first_ instead of its
+     * emissions.
+     *
+     * @param scores_   Scores; at most 2^16 - 1 states per step
+     * @param first_    First step
+     * @param last_     Step after the last one to decode
+     * @param initial_  Log scores of the states of step first_, or nullptr
+     *                  to use its emissions
+     */
+    void initialize(const Scores *scores_, size_t first_, size_t last_, const double *initial_);
+
+    /**
+     * @brief Run the steps added to the scores since the last call, so steps
+     * can be added while decoding.
+     */
+    void run();
+
+    /**
+     * @brief Get log scores of the likeliest paths to each state of step t,
+     * which must have been run.
+     */
+    const double *getStepScores(size_t t) const;
+
+    /**
+     * @brief Whether some path reaches a state with log score s.
+     */
+    static bool isReachable(double s);
+
+    /**
+     * @brief Get likeliest path over the steps run so far.
+     *
+     * @return Index of the state of each step
+     */
+    std::vector<size_t> getLikeliestPath() const;
+
+    /**
+     * @brief Get likeliest path over the steps run so far, ending in state j
+     * of the last step.
+     *
+     * @return Index of the state of each step, from the first one
+     */
+    std::vector<size_t> getLikeliestPath(size_t j) const;
+};
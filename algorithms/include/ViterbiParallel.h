@@ -0,0 +1,64 @@
+#pragma once
+
+#include "ViterbiLog.h"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Viterbi split in time, for very long sequences.
+ *
+ * Viterbi is a chain of max-plus products, which is associative. The steps
+ * are split into chunks; each chunk's transfer matrix (best log score from
+ * each state before the chunk to each state of its last step) is computed in
+ * parallel, the matrices are combined to get the scores at the chunk
+ * boundaries and the state of the likeliest path at each of them, and then
+ * every chunk is decoded and backtracked in parallel between its boundary
+ * states.
+ *
+ * Transfer matrices take one pass per state before the chunk, so this does
+ * about K times the work of ViterbiLog; it only pays off when threads would
+ * otherwise be idle, not when every thread is already matching a trip (see
+ * HiddenMarkovModelMany::Pipeline, which lends the threads of workers that
+ * ran out of trips to the trips still being matched). Sequences
+ * shorter than minSteps are decoded with ViterbiLog.
+ */
+class ViterbiParallel {
+public:
+    static const size_t DEFAULT_MIN_STEPS = 500;
+private:
+    const size_t nThreads;
+    const size_t minSteps;
+    const ViterbiLog::Scores *scores;
+
+    ViterbiLog sequential;
+    bool parallel = false;
+    bool found = false;
+    long tFail = -1;
+    std::vector<size_t> path;
+
+    void runParallel();
+public:
+    /**
+     * @brief Construct.
+     *
+     * @param nThreads_ Number of threads, and of chunks
+     * @param minSteps_ Minimum number of steps to decode in parallel
+     */
+    ViterbiParallel(size_t nThreads_, size_t minSteps_ = DEFAULT_MIN_STEPS);
+
+    void initialize(const ViterbiLog::Scores *scores_);
+    void run();
+
+    /**
+     * @brief Whether the last run was split in time.
+     */
+    bool ranInParallel() const;
+
+    /**
+     * @brief Get likeliest path.
+     *
+     * @return Index of the state of each step
+     */
+    std::vector<size_t> getLikeliestPath() const;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Viterbi.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <set>
+
+/**
+ * @brief Viterbi over the candidates of each step only.
+ *
+ * Each step t is a layer holding only its candidates C_t, laid out back to
+ * back in flat arrays; back-pointers are indices into the previous layer.
+ * Memory is O(sum |C_t|) and time O(sum |C_t|*|C_t+1|), instead of O(T*K)
+ * for ViterbiOptimized, where K is the number of candidates of the whole trip.
+ */
+class ViterbiSparse {
+public:
+    typedef uint16_t local_t;
+private:
+    const Viterbi::InitialProbabilitiesGenerator *Pi;
+    const Viterbi::TransitionMatrixGenerator     *A;
+    const Viterbi::EmissionMatrixGenerator       *B;
+
+    std::vector<size_t>  layer;  // Layer t is [layer[t], layer[t+1])
+    std::vector<long>    states; // Global index of each state
+    std::vector<double>  prob;
+    std::vector<local_t> prev;   // Index of the previous state, in layer t-1
+public:
+    /**
+     * @brief Initialize.
+     *
+     * @param candidates_ Candidate states of each step; at most
+     *                    2^16 - 1 per step
+     */
+    void initialize(
+        Viterbi::InitialProbabilitiesGenerator *Pi_,
+        Viterbi::TransitionMatrixGenerator *A_,
+        Viterbi::EmissionMatrixGenerator *B_,
+        const std::vector<std::set<long>> &candidates_
+    );
+    void run();
+    std::vector<long> getLikeliestPath() const;
+};
@@ -11,9 +11,9 @@ public:
     /**
      * @brief Initializes data members
      * 
-     * @param points List of provided edges
+     * @param diagram Voronoi diagram, whose edges refer to its sites by index
      */
-    virtual void initialize(const std::list<Edge> &edges) = 0;
+    virtual void initialize(const VoronoiDiagram &diagram) = 0;
 
     /**
      * @brief Executes the algorithm
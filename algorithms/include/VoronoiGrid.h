@@ -0,0 +1,85 @@
+#pragma once
+
+#include "ClosestPoint.h"
+#include "K2DTreeClosestPoint.h"
+
+#include <cstdint>
+
+/**
+ * @brief Closest point from a grid over the Voronoi diagram of the points.
+ *
+ * Each cell of the grid stores the few sites whose Voronoi cells intersect
+ * it: the site of its center, and the sites on both sides of any Voronoi
+ * edge crossing it. Cells with more than a few sites are split in four, up
+ * to a maximum depth, so memory stays proportional to the number of sites
+ * while most queries scan one or two. Queries outside the grid fall back to
+ * a 2D-tree.
+ */
+class VoronoiGrid: public ClosestPoint {
+private:
+    static const uint32_t INTERNAL = UINT32_MAX;
+
+    /**
+     * @brief Leaf: candidates [begin, begin+count), or the site itself if
+     * count == 1. Internal (count == INTERNAL): children at begin, in order
+     * (0,0), (1,0), (0,1), (1,1).
+     */
+    struct Cell {
+        uint32_t begin;
+        uint32_t count;
+    };
+
+    /**
+     * @brief Voronoi edges between two sites, clipped to the bounding box.
+     */
+    struct Segments {
+        std::vector<Vector2> a, b;
+        std::vector<std::pair<uint32_t, uint32_t>> sites;
+    };
+
+    const double cellsPerSite;
+    const size_t maxCandidates;
+    const size_t maxDepth;
+
+    std::vector<Vector2> v;
+    K2DTreeClosestPoint fallback;
+
+    double x0, y0, cellW, cellH;
+    long nx, ny;
+    std::vector<Cell> cells;
+    std::vector<Vector2> candidates;
+    std::vector<uint32_t> candidateIds;
+
+    void build(uint32_t cell, double xl, double yl, double w, double h, const Segments &segments, const std::vector<uint32_t> &edges, const std::vector<uint32_t> &parentIds, size_t depth);
+public:
+    /**
+     * @brief Construct grid.
+     *
+     * @param cellsPerSite  Number of cells of the top-level grid per site
+     * @param maxCandidates Cells with more candidates are split...
+     * @param maxDepth      ...up to this many times
+     */
+    VoronoiGrid(double cellsPerSite = 1.0, size_t maxCandidates = 8, size_t maxDepth = 8);
+
+    /**
+     * @brief Initializes data members
+     *
+     * @param points List of provided Points
+     */
+    void initialize(const std::list<Vector2> &points);
+
+    /**
+     * @brief Executes the algorithm
+     *
+     */
+    void run();
+
+    Vector2 getClosestPoint(const Vector2 p) const;
+
+    size_t getClosestPointIdx(const Vector2 p) const;
+
+    /**
+     * @brief Get memory used by the grid (not counting the fallback), in bytes.
+     */
+    size_t getMemoryUsage() const;
+};
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "ClosestPoint.h"
+
+#include "VoronoiGrid.h"
+
+class VoronoiGridFactory: public ClosestPointFactory {
+private:
+    const double cellsPerSite;
+    const size_t maxCandidates;
+    const size_t maxDepth;
+public:
+    VoronoiGridFactory(double cellsPerSite_ = 1.0, size_t maxCandidates_ = 8, size_t maxDepth_ = 8);
+    virtual ClosestPoint *factoryMethod();
+};
@@ -1,5 +1,6 @@
 #include "AstarFew.h"
 
+#include <algorithm>
 #include <queue>
 #include <iostream>
 #include <chrono>
@@ -51,6 +52,11 @@ AstarFew::AstarFew(
 {}
 
 void AstarFew::initialize(const DWGraph::DWGraph *G_, node_t s_, list<node_t> d_){
+    initialize(G_, s_, d_, dMax);
+}
+
+void AstarFew::initialize(const DWGraph::DWGraph *G_, node_t s_, list<node_t> d_, weight_t dMax_){
+    dMaxSearch = min(dMax, dMax_);
     G = G_;
     s = s_;
     d = d_;
@@ -95,9 +101,9 @@ void AstarFew::run(){
         
         for(const DWGraph::Edge &e: G->getAdj(u)){
             weight_t c_ = dist.at(u).first + e.w;
-            if(c_ > dMax) continue;
+            if(c_ > dMaxSearch) continue;
             weight_t ch_ = c_ + (*h)(e.v);
-            if(ch_ > dMax) continue;
+            if(ch_ > dMaxSearch) continue;
             auto dit = dist.find(e.v);
             if(dit == dist.end() || c_ < dit->second.first){
                 dist[e.v] = mk(c_, u);
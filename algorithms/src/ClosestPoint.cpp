@@ -1,3 +1,26 @@
 #include "ClosestPoint.h"
 
+#include "utils.h"
+
+using namespace std;
+
 ClosestPoint::~ClosestPoint(){}
+
+vector<size_t> ClosestPoint::getQueryOrder(const vector<Vector2> &queries) const {
+    return utils::mortonOrder(queries);
+}
+
+void ClosestPoint::getClosestPointMany(
+    const vector<Vector2> &queries,
+    vector<size_t> &res,
+    size_t nThreads
+) const {
+    vector<size_t> order = getQueryOrder(queries);
+    res.resize(queries.size());
+    utils::parallelFor(order.size(), nThreads, [this, &queries, &res, &order](size_t l, size_t r){
+        for(size_t k = l; k < r; ++k){
+            const size_t &i = order[k];
+            res[i] = getClosestPointIdx(queries[i]);
+        }
+    });
+}
@@ -1,3 +1,166 @@
 #include "ClosestPointsInRadius.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "utils.h"
+
+using namespace std;
+
 ClosestPointsInRadius::~ClosestPointsInRadius(){}
+
+vector<size_t> ClosestPointsInRadius::getQueryOrder(const vector<Coord> &queries) const {
+    return utils::mortonOrder(queries);
+}
+
+void ClosestPointsInRadius::getClosestPointsMany(
+    const vector<Coord> &queries,
+    vector<size_t> &offsets,
+    vector<size_t> &idxs,
+    size_t nThreads
+) const {
+    const size_t N = queries.size();
+    vector<size_t> order = getQueryOrder(queries);
+
+    // Queries are split in contiguous chunks of the processing order. Each
+    // chunk answers its queries into a local buffer, remembering where the
+    // answer of each query starts and how many points it has
+    const size_t nChunks = max(size_t(1), min(nThreads, N));
+    vector<size_t> chunkBegin(nChunks+1, 0);
+    for(size_t c = 0; c < nChunks; ++c)
+        chunkBegin[c+1] = chunkBegin[c] + N/nChunks + (c < N%nChunks ? 1 : 0);
+
+    vector<vector<size_t>> buffers(nChunks);
+    vector<size_t> localStart(N), count(N);
+    utils::parallelFor(nChunks, nChunks, [&](size_t l, size_t r){
+        for(size_t c = l; c < r; ++c){
+            vector<size_t> &buf = buffers[c];
+            for(size_t k = chunkBegin[c]; k < chunkBegin[c+1]; ++k){
+                const size_t &i = order[k];
+                localStart[i] = buf.size();
+                getClosestPointsIdx(queries[i], buf);
+                count[i] = buf.size() - localStart[i];
+            }
+        }
+    });
+
+    offsets.assign(N+1, 0);
+    for(size_t i = 0; i < N; ++i) offsets[i+1] = offsets[i] + count[i];
+    idxs.resize(offsets[N]);
+
+    utils::parallelFor(nChunks, nChunks, [&](size_t l, size_t r){
+        for(size_t c = l; c < r; ++c){
+            const vector<size_t> &buf = buffers[c];
+            for(size_t k = chunkBegin[c]; k < chunkBegin[c+1]; ++k){
+                const size_t &i = order[k];
+                copy(
+                    buf.begin() + localStart[i],
+                    buf.begin() + localStart[i] + count[i],
+                    idxs.begin() + offsets[i]
+                );
+            }
+        }
+    });
+}
+
+using hrc = std::chrono::high_resolution_clock;
+
+ClosestPointsInRadius::Cache::Cache(ClosestPointsInRadius &closestPointsInRadius_, double q_, size_t maxBytes):
+    closestPointsInRadius(closestPointsInRadius_),
+    q(q_),
+    shardBudget(maxBytes/NUM_SHARDS),
+    shards(NUM_SHARDS),
+    hits(0), misses(0), hitNanos(0), missNanos(0)
+{}
+
+void ClosestPointsInRadius::Cache::initialize(const list<Coord> &points, double d_){
+    d = d_;
+    v = vector<Coord>(points.begin(), points.end());
+    for(shard_t &shard: shards){
+        shard.entries.clear();
+        shard.fifo.clear();
+        shard.bytes = 0;
+    }
+    closestPointsInRadius.initialize(points, d + q*sqrt(2.0)/2.0);
+}
+
+void ClosestPointsInRadius::Cache::run(){
+    closestPointsInRadius.run();
+}
+
+uint64_t ClosestPointsInRadius::Cache::getKey(const Coord &p, Coord &center) const {
+    const double qLon = q*Coord::MetersToLonDegrees();
+    const double qLat = q*Coord::MetersToLatDegrees();
+    int64_t cx = int64_t(floor(p.lon()/qLon));
+    int64_t cy = int64_t(floor(p.lat()/qLat));
+    center = Coord((double(cy)+0.5)*qLat, (double(cx)+0.5)*qLon);
+    return (uint64_t(uint32_t(cx)) << 32) | uint64_t(uint32_t(cy));
+}
+
+vector<Coord> ClosestPointsInRadius::Cache::getClosestPoints(Coord p) const {
+    vector<size_t> idxs;
+    getClosestPointsIdx(p, idxs);
+
+    vector<Coord> sols(idxs.size());
+    for(size_t i = 0; i < idxs.size(); ++i) sols[i] = v[idxs[i]];
+    return sols;
+}
+
+void ClosestPointsInRadius::Cache::getClosestPointsIdx(Coord p, vector<size_t> &res) const {
+    hrc::time_point begin = hrc::now();
+
+    Coord center;
+    const uint64_t key = getKey(p, center);
+    shard_t &shard = shards[hash<uint64_t>()(key) % NUM_SHARDS];
+
+    shared_ptr<const entry_t> entry;
+    {
+        lock_guard<mutex> lock(shard.mutex);
+        auto it = shard.entries.find(key);
+        if(it != shard.entries.end()) entry = it->second;
+    }
+
+    const bool hit = (entry != nullptr);
+    if(!hit){
+        vector<size_t> superset;
+        closestPointsInRadius.getClosestPointsIdx(center, superset);
+        entry = make_shared<const entry_t>(superset.begin(), superset.end());
+
+        const size_t bytes = sizeof(entry_t) + entry->size()*sizeof(uint32_t);
+        lock_guard<mutex> lock(shard.mutex);
+        if(shard.entries.emplace(key, entry).second){
+            shard.fifo.push_back(key);
+            shard.bytes += bytes;
+            while(shard.bytes > shardBudget && shard.fifo.size() > 1){
+                auto it = shard.entries.find(shard.fifo.front());
+                shard.bytes -= sizeof(entry_t) + it->second->size()*sizeof(uint32_t);
+                shard.entries.erase(it);
+                shard.fifo.pop_front();
+            }
+        }
+    }
+
+    for(const uint32_t &i: *entry){
+        if(Coord::getDistanceArcSimple(v[i], p) < d)
+            res.push_back(i);
+    }
+
+    long long dt = chrono::duration_cast<chrono::nanoseconds>(hrc::now()-begin).count();
+    if(hit){ ++hits  ; hitNanos  += dt; }
+    else   { ++misses; missNanos += dt; }
+}
+
+ClosestPointsInRadius::Cache::stats_t ClosestPointsInRadius::Cache::getStats() const {
+    const double NANOS_TO_SECS = 1.0/1000000000.0;
+    return stats_t{
+        hits, misses,
+        double(hitNanos)*NANOS_TO_SECS,
+        double(missNanos)*NANOS_TO_SECS
+    };
+}
+
+void ClosestPointsInRadius::Cache::resetStats(){
+    hits = 0; misses = 0;
+    hitNanos = 0; missNanos = 0;
+}
@@ -0,0 +1,3 @@
+#include "ClosestSegmentsInRadius.h"
+
+ClosestSegmentsInRadius::~ClosestSegmentsInRadius(){}
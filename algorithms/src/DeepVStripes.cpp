@@ -32,3 +32,15 @@ Vector2 DeepVStripes::getClosestPoint(Vector2 p) const {
     }
     return ret.second;
 }
+
+size_t DeepVStripes::getClosestPointIdx(Vector2 p) const {
+    pair<bool, size_t> ret;
+    size_t i = 0;
+    do {
+        ret = vstripes_vtr[i++].getClosestPointIdx_success(p);
+    } while(i < vstripes_vtr.size() && !ret.first);
+    if(!ret.first){
+        throw runtime_error("Could not find a solution");
+    }
+    return ret.second;
+}
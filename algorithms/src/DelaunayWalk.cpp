@@ -0,0 +1,137 @@
+#include "DelaunayWalk.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "FortuneAlgorithm.h"
+#include "utils.h"
+
+using namespace std;
+
+void DelaunayWalk::initialize(const list<Vector2> &points){
+    v = vector<Vector2>(points.begin(), points.end());
+    sites.clear();
+    siteToIdx.clear();
+    adjStart.clear();
+    adj.clear();
+    seeds.clear();
+}
+
+void DelaunayWalk::run(){
+    // Fortune's algorithm does not handle repeated sites
+    vector<size_t> order(v.size());
+    iota(order.begin(), order.end(), 0);
+    sort(order.begin(), order.end(), [this](size_t i, size_t j){ return Vector2::compXY(v[i], v[j]); });
+    for(const size_t &i: order){
+        if(!sites.empty() && sites.back() == v[i]) continue;
+        sites.push_back(v[i]);
+        siteToIdx.push_back(i);
+    }
+    const size_t N = sites.size();
+
+    // Delaunay triangulation
+    VoronoiDiagram diagram = FortuneAlgorithm(sites).construct();
+
+    vector<pair<size_t, size_t>> edges;
+    for(const pair<Voronoi::idx_t, Voronoi::idx_t> &e: diagram.getDelaunayEdges()){
+        if(e.first == e.second) continue;
+        edges.push_back(make_pair(e.first, e.second));
+        edges.push_back(make_pair(e.second, e.first));
+    }
+    sort(edges.begin(), edges.end());
+    edges.erase(unique(edges.begin(), edges.end()), edges.end());
+
+    adjStart.assign(N+1, 0);
+    adj.resize(edges.size());
+    for(size_t k = 0; k < edges.size(); ++k){
+        ++adjStart[edges[k].first+1];
+        adj[k] = uint32_t(edges[k].second);
+    }
+    for(size_t i = 0; i < N; ++i) adjStart[i+1] += adjStart[i];
+
+    // Coarse grid of starting sites
+    double xMax = -fINF, yMax = -fINF;
+    xMin = +fINF; yMin = +fINF;
+    for(const Vector2 &p: sites){
+        xMin = min(xMin, p.x); xMax = max(xMax, p.x);
+        yMin = min(yMin, p.y); yMax = max(yMax, p.y);
+    }
+    nx = ny = max(1L, long(ceil(sqrt(double(N)/16.0))));
+    cellW = max(xMax-xMin, 1e-12)/double(nx);
+    cellH = max(yMax-yMin, 1e-12)/double(ny);
+    seeds.resize(nx*ny);
+    size_t site = 0, steps = 0;
+    for(long y = 0; y < ny; ++y){
+        for(long x = 0; x < nx; ++x){
+            Vector2 c(xMin + (double(x)+0.5)*cellW, yMin + (double(y)+0.5)*cellH);
+            if(N > 0) site = walk(c, site, steps);
+            seeds[y*nx + x] = uint32_t(site);
+        }
+    }
+}
+
+size_t DelaunayWalk::getSeed(const Vector2 &p) const {
+    long x = min(nx-1, max(0L, long(floor((p.x-xMin)/cellW))));
+    long y = min(ny-1, max(0L, long(floor((p.y-yMin)/cellH))));
+    return seeds[y*nx + x];
+}
+
+size_t DelaunayWalk::walk(const Vector2 &p, size_t start, size_t &steps) const {
+    size_t cur = start;
+    double dCur = p.getDistance(sites[cur]);
+    while(true){
+        size_t best = cur;
+        for(size_t k = adjStart[cur]; k < adjStart[cur+1]; ++k){
+            double d = p.getDistance(sites[adj[k]]);
+            if(d < dCur){
+                dCur = d;
+                best = adj[k];
+            }
+        }
+        if(best == cur) return cur;
+        cur = best;
+        ++steps;
+    }
+}
+
+Vector2 DelaunayWalk::getClosestPoint(Vector2 p) const {
+    return v[getClosestPointIdx(p)];
+}
+
+size_t DelaunayWalk::getClosestPointIdx(Vector2 p) const {
+    size_t steps = 0;
+    return siteToIdx[walk(p, getSeed(p), steps)];
+}
+
+void DelaunayWalk::getClosestPointMany(
+    const vector<Vector2> &queries,
+    vector<size_t> &res,
+    size_t nThreads
+) const {
+    vector<size_t> order = getQueryOrder(queries);
+    res.resize(queries.size());
+    utils::parallelFor(order.size(), nThreads, [this, &queries, &res, &order](size_t l, size_t r){
+        Cursor cursor(*this);
+        for(size_t k = l; k < r; ++k){
+            const size_t &i = order[k];
+            res[i] = cursor.next(queries[i]);
+        }
+    });
+}
+
+DelaunayWalk::Cursor::Cursor(const DelaunayWalk &delaunayWalk_):
+delaunayWalk(delaunayWalk_){}
+
+size_t DelaunayWalk::Cursor::next(Vector2 p){
+    if(!started){
+        site = delaunayWalk.getSeed(p);
+        started = true;
+    }
+    site = delaunayWalk.walk(p, site, steps);
+    return delaunayWalk.siteToIdx[site];
+}
+
+void DelaunayWalk::Cursor::reset(){ started = false; }
+
+size_t DelaunayWalk::Cursor::getSteps() const { return steps; }
@@ -2,6 +2,7 @@
 
 #include "DijkstraFew.h"
 
+#include <algorithm>
 #include <queue>
 #include <utility>
 #include <chrono>
@@ -34,6 +35,11 @@ list<node_t> DijkstraFew::getDest () const{
 }
 
 void DijkstraFew::initialize(const DWGraph::DWGraph *G_, DWGraph::node_t s_, list<node_t> d_){
+    initialize(G_, s_, d_, dMax);
+}
+
+void DijkstraFew::initialize(const DWGraph::DWGraph *G_, DWGraph::node_t s_, list<node_t> d_, weight_t dMax_){
+    this->dMaxSearch = min(dMax, dMax_);
     this->s = s_;
     this->d = d_;
     this->G = G_;
@@ -54,7 +60,7 @@ void DijkstraFew::run(){
 
         for(const Edge &e: G->getAdj(u)){
             weight_t c_ = dist.at(u) + e.w;
-            if(c_ > dMax) continue;
+            if(c_ > dMaxSearch) continue;
             auto dit = dist.find(e.v);
             if(dit == dist.end() || c_ < dit->second){
                 dist[e.v] = c_;
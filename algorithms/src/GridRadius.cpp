@@ -0,0 +1,140 @@
+#include "GridRadius.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "utils.h"
+
+using namespace std;
+
+GridRadius::GridRadius(size_t nThreads_):
+nThreads(max(size_t(1), nThreads_)){}
+
+void GridRadius::initialize(const list<Coord> &points, double width){
+    v = vector<Coord>(points.begin(), points.end());
+    d = width;
+
+    cellStart.clear();
+    packed.clear();
+    packedIdx.clear();
+}
+
+long GridRadius::getCellX(const Coord &p) const { return long(floor((p.x - xMin)/cellW)); }
+long GridRadius::getCellY(const Coord &p) const { return long(floor((p.y - yMin)/cellH)); }
+
+void GridRadius::run(){
+    const size_t N = v.size();
+
+    cellW = d*Coord::MetersToLonDegrees();
+    cellH = d*Coord::MetersToLatDegrees();
+
+    double xMax = -fINF, yMax = -fINF;
+    xMin = +fINF; yMin = +fINF;
+    for(const Coord &p: v){
+        xMin = min(xMin, p.x); xMax = max(xMax, p.x);
+        yMin = min(yMin, p.y); yMax = max(yMax, p.y);
+    }
+    if(N == 0){ xMin = xMax = yMin = yMax = 0; }
+    nx = getCellX(Coord(yMax, xMax)) + 1;
+    ny = getCellY(Coord(yMax, xMax)) + 1;
+    const size_t nCells = size_t(nx)*size_t(ny);
+
+    // Cell of each point, and per-chunk histograms
+    const size_t nChunks = max(size_t(1), min(nThreads, N));
+    vector<size_t> chunkBegin(nChunks+1, 0);
+    for(size_t k = 0; k < nChunks; ++k)
+        chunkBegin[k+1] = chunkBegin[k] + N/nChunks + (k < N%nChunks ? 1 : 0);
+
+    vector<uint32_t> cellOf(N);
+    vector<vector<uint32_t>> count(nChunks, vector<uint32_t>(nCells, 0));
+    utils::parallelFor(nChunks, nChunks, [&](size_t l, size_t r){
+        for(size_t k = l; k < r; ++k){
+            for(size_t i = chunkBegin[k]; i < chunkBegin[k+1]; ++i){
+                cellOf[i] = uint32_t(getCellY(v[i])*nx + getCellX(v[i]));
+                ++count[k][cellOf[i]];
+            }
+        }
+    });
+
+    // Size of each cell (parallel over cells), then prefix sum
+    cellStart.assign(nCells+1, 0);
+    utils::parallelFor(nCells, nThreads, [&](size_t l, size_t r){
+        for(size_t c = l; c < r; ++c){
+            uint32_t s = 0;
+            for(size_t k = 0; k < nChunks; ++k) s += count[k][c];
+            cellStart[c+1] = s;
+        }
+    });
+    for(size_t c = 0; c < nCells; ++c) cellStart[c+1] += cellStart[c];
+
+    // Where each chunk starts writing in each cell (parallel over cells)
+    utils::parallelFor(nCells, nThreads, [&](size_t l, size_t r){
+        for(size_t c = l; c < r; ++c){
+            uint32_t s = cellStart[c];
+            for(size_t k = 0; k < nChunks; ++k){
+                uint32_t n = count[k][c];
+                count[k][c] = s;
+                s += n;
+            }
+        }
+    });
+
+    // Scatter points; chunks write to disjoint positions
+    packed.resize(N);
+    packedIdx.resize(N);
+    utils::parallelFor(nChunks, nChunks, [&](size_t l, size_t r){
+        for(size_t k = l; k < r; ++k){
+            for(size_t i = chunkBegin[k]; i < chunkBegin[k+1]; ++i){
+                uint32_t pos = count[k][cellOf[i]]++;
+                packed[pos] = v[i];
+                packedIdx[pos] = uint32_t(i);
+            }
+        }
+    });
+}
+
+vector<Coord> GridRadius::getClosestPoints(Coord p) const {
+    vector<size_t> idxs;
+    getClosestPointsIdx(p, idxs);
+
+    vector<Coord> sols(idxs.size());
+    for(size_t i = 0; i < idxs.size(); ++i) sols[i] = v[idxs[i]];
+    return sols;
+}
+
+void GridRadius::getClosestPointsIdx(Coord p, vector<size_t> &res) const {
+    const long cx = getCellX(p), cy = getCellY(p);
+    const long xl = max(0L, cx-1), xr = min(nx-1, cx+1);
+    const long yl = max(0L, cy-1), yr = min(ny-1, cy+1);
+    if(xl > xr || yl > yr) return;
+    for(long y = yl; y <= yr; ++y){
+        // Cells of the same row are consecutive
+        size_t l = cellStart[y*nx + xl];
+        size_t r = cellStart[y*nx + xr + 1];
+        for(size_t i = l; i < r; ++i){
+            if(Coord::getDistanceArcSimple(packed[i], p) < d)
+                res.push_back(packedIdx[i]);
+        }
+    }
+}
+
+vector<size_t> GridRadius::getQueryOrder(const vector<Coord> &queries) const {
+    vector<size_t> order(queries.size());
+    vector<long> cellOfQuery(queries.size());
+    for(size_t i = 0; i < queries.size(); ++i){
+        order[i] = i;
+        cellOfQuery[i] = getCellY(queries[i])*nx + getCellX(queries[i]);
+    }
+    sort(order.begin(), order.end(), [&cellOfQuery](size_t i, size_t j){
+        return cellOfQuery[i] < cellOfQuery[j];
+    });
+    return order;
+}
+
+size_t GridRadius::getMemoryUsage() const {
+    return
+        v        .size()*sizeof(Coord) +
+        cellStart.size()*sizeof(uint32_t) +
+        packed   .size()*sizeof(Coord) +
+        packedIdx.size()*sizeof(uint32_t);
+}
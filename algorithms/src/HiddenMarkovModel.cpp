@@ -1,15 +1,19 @@
 #include "HiddenMarkovModel.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <iostream>
 #include <map>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
 
 #include "AstarFew.h"
 #include "DUGraph.h"
 #include "Kosaraju.h"
 #include "utils.h"
-#include "ViterbiOptimized.h"
+#include "ViterbiLog.h"
 
 using namespace std;
 
@@ -31,11 +35,15 @@ const double METERS_TO_MILLIMS = 1000.0;
 HiddenMarkovModel::HiddenMarkovModel(
     ClosestPointsInRadius &closestPointsInRadius_,
     ShortestPathFew &shortestPathFew_,
-    double d_, double sigma_z_, double beta_
+    double d_, double sigma_z_, double beta_,
+    size_t beamWidth_, double beamMargin_,
+    bool lazy_, double maxSpeed_
 ):
     closestPointsInRadius(closestPointsInRadius_),
     shortestPathFew(shortestPathFew_),
-    d(d_), sigma_z(sigma_z_), beta(beta_)
+    d(d_), sigma_z(sigma_z_), beta(beta_),
+    beamWidth(beamWidth_), beamMargin(beamMargin_),
+    lazy(lazy_), maxSpeed(maxSpeed_)
 {}
 
 void HiddenMarkovModel::initialize(const MapGraph *mapGraph_){
@@ -55,9 +63,12 @@ void HiddenMarkovModel::initialize(const MapGraph *mapGraph_){
     }
     cout << "Calculated SCC" << endl;
 
-    auto nodes = distGraph.getNodes();
+    nodes.clear();
     list<Coord> l;
-    for(const node_t &u: nodes) l.push_back(mapGraph->nodeToCoord(u));
+    for(const node_t &u: distGraph.getNodes()){
+        nodes.push_back(u);
+        l.push_back(mapGraph->nodeToCoord(u));
+    }
     closestPointsInRadius.initialize(l, d);
 }
 
@@ -66,13 +77,26 @@ void HiddenMarkovModel::run(){
     cout << "Idx\tID                \tVStripes (s)\tT\tK\tA* (s)   \tViterbi (s)\t" << endl;
 }
 
+double HiddenMarkovModel::emissionProbability(double sigma_z, double d){
+    return exp(-0.5 * pow(d/sigma_z, 2))/(sqrt(2*M_PI) * sigma_z);
+}
+
+double HiddenMarkovModel::transitionProbability(double beta, double dArc, double dRoute){
+    double dt = fabs(dArc-dRoute);
+    return exp(-dt/beta)/beta;
+}
+
+double HiddenMarkovModel::logTransitionProbability(double beta, double dArc, double dRoute){
+    return -fabs(dArc-dRoute)/beta - log(beta);
+}
+
 HiddenMarkovModel::MyPi::MyPi(double sigma_z_, const vector<Coord> &S_, Coord firstObs):
 sigma_z(sigma_z_), S(S_), zt(firstObs){}
 
 double HiddenMarkovModel::MyPi::operator()(long i) const {
     const Coord &xti = S[i];
     double d = Coord::getDistanceArc(zt, xti);
-    return exp(-0.5 * pow(d/sigma_z, 2))/(sqrt(2*M_PI) * sigma_z);
+    return emissionProbability(sigma_z, d);
 }
 
 HiddenMarkovModel::MyA::MyA(double beta_, const vector<Coord> &Y_, const VVF &D_):
@@ -85,8 +109,7 @@ double HiddenMarkovModel::MyA::operator()(long i, long j, long t) const {
 
     const double &dRoute = D.at(i).at(j);
 
-    double dt = fabs(dArc-dRoute);
-    return exp(-dt/beta)/beta;
+    return transitionProbability(beta, dArc, dRoute);
 }
 
 HiddenMarkovModel::MyB::MyB(double sigma_z_, const vector<Coord> &S_, const vector<Coord> &Y_):
@@ -96,10 +119,17 @@ double HiddenMarkovModel::MyB::operator()(long i, long t) const {
     const Coord &zt = Y.at(t);
     const Coord &xti = S.at(i);
     double d = Coord::getDistanceArc(zt, xti);
-    return exp(-0.5 * pow(d/sigma_z, 2))/(sqrt(2*M_PI) * sigma_z);
+    return emissionProbability(sigma_z, d);
 }
 
 vector<node_t> HiddenMarkovModel::getMatches(const vector<Coord> &trip) const{
+    return getMatches(trip, vector<long long>());
+}
+
+vector<node_t> HiddenMarkovModel::getMatches(const vector<Coord> &trip, const vector<long long> &timestamps) const{
+    if(!timestamps.empty() && timestamps.size() != trip.size())
+        throw invalid_argument("Trip has " + to_string(trip.size()) + " observations but " + to_string(timestamps.size()) + " timestamps");
+
     vector<Coord> Y = trip;
     const size_t &T = Y.size();
 
@@ -107,21 +137,24 @@ vector<node_t> HiddenMarkovModel::getMatches(const vector<Coord> &trip) const{
 
     // ======== CLOSEST POINTS/CANDIDATE STATES (VSTRIPES) ========
     begin = hrc::now();
-    map<Coord, long, bool (*)(const Vector2&, const Vector2&)> Sv(Vector2::compXY);
+    vector<size_t> offsets, idxs;
+    closestPointsInRadius.getClosestPointsMany(Y, offsets, idxs);
+
+    unordered_map<size_t, long> Sv;
     vector<Coord> S;
     vector<node_t> idxToNode;
     vector<set<long>> candidateStates(T);
     for(size_t t = 0; t < T; ++t){
-        vector<Coord> v = closestPointsInRadius.getClosestPoints(Y.at(t));
-        if(v.empty()) throw std::runtime_error("Location t=" + to_string(t) + " has no candidates");
-        for(const Coord &c: v){
-            if(!Sv.count(c)){
-                long id = Sv.size();
-                Sv[c] = id;
-                S.push_back(c);
-                idxToNode.push_back(mapGraph->coordToNode(c));
+        if(offsets[t] == offsets[t+1]) throw std::runtime_error("Location t=" + to_string(t) + " has no candidates");
+        for(size_t k = offsets[t]; k < offsets[t+1]; ++k){
+            const size_t &c = idxs[k];
+            auto it = Sv.find(c);
+            if(it == Sv.end()){
+                it = Sv.emplace(c, Sv.size()).first;
+                idxToNode.push_back(nodes[c]);
+                S.push_back(mapGraph->nodeToCoord(nodes[c]));
             }
-            candidateStates.at(t).insert(Sv.at(c));
+            candidateStates.at(t).insert(it->second);
         }
     }
     const size_t &K = Sv.size();
@@ -130,65 +163,369 @@ vector<node_t> HiddenMarkovModel::getMatches(const vector<Coord> &trip) const{
     dt = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count())*NANOS_TO_SECS;
     cout << dt << "\t" << T << "\t" << K << "\t";
 
-    // ======== DISTANCE MATRIX (A*) ========
-    begin = hrc::now();
-    VVF distMatrix(K, VF(K, fINF));
-    for(size_t t = 0; t+1 < T; ++t){
-        list<node_t> l;
-        for(size_t j: candidateStates.at(t+1)) l.push_back(idxToNode.at(j));
+    // ======== ROUTE DISTANCES (A*), HIDDEN MARKOV MODEL (VITERBI) ========
+    // Step by step, so distances are only searched from the states in the beam
+    double dtAstar = 0.0, dtViterbi = 0.0;
 
-        for(size_t i: candidateStates.at(t)){
-            shortestPathFew.initialize(&distGraph, idxToNode.at(i), l);
-            shortestPathFew.run();
-            for(size_t j: candidateStates.at(t+1)){
-                DWGraph::weight_t d = shortestPathFew.getPathWeight(idxToNode.at(j));
-                double df = double(d)*MILLIMS_TO_METERS;
-                distMatrix[i][j] = (d == iINF ? fINF : df);
-            }
-        }
+    ViterbiLog::Scores scores;
+    ViterbiLog viterbi;
+    viterbi.initialize(&scores);
 
-        for(
-            auto it = candidateStates.at(t+1).begin();
-            it != candidateStates.at(t+1).end();
-        ){
-            size_t j = *it;
+    vector<VI> C(T);
+    vector<Coord> candidates;
+    C[0].assign(candidateStates[0].begin(), candidateStates[0].end());
+    for(long i: C[0]) candidates.push_back(S[i]);
+    addScores(Y[0], 0.0, candidates, VF(), scores);
+    viterbi.run();
 
-            double dBest = fINF;
-            for(size_t i: candidateStates.at(t)){
-                dBest = min(dBest, distMatrix[i][j]);
+    for(size_t t = 0; t+1 < T; ++t){
+        begin = hrc::now();
+        const VI &from = C[t];
+        const VI to(candidateStates[t+1].begin(), candidateStates[t+1].end());
+        const double *st = viterbi.getStepScores(t);
+        const vector<size_t> beam = getBeam(st, from.size());
+        const double dArc = Coord::getDistanceArc(Y[t], Y[t+1]);
+        double dMax = fINF;
+        if(!timestamps.empty() && maxSpeed < fINF)
+            dMax = max(dArc, maxSpeed*double(timestamps[t+1] - timestamps[t])) + 2*d;
+
+        VF D;
+        getRouteDistances(st, beam, from, to, S, idxToNode, dArc, dMax, D);
+
+        // Drop candidates that cannot be reached
+        vector<size_t> keep;
+        for(size_t j = 0; j < to.size(); ++j){
+            for(const size_t &i: beam){
+                if(D[i*to.size() + j] < fINF){
+                    keep.push_back(j);
+                    break;
+                }
             }
-
-            if(dBest >= fINF) it = candidateStates.at(t+1).erase(it);
-            else ++it;
         }
+        VF Dt(from.size()*keep.size());
+        for(size_t i = 0; i < from.size(); ++i)
+            for(size_t k = 0; k < keep.size(); ++k)
+                Dt[i*keep.size() + k] = D[i*to.size() + keep[k]];
+        for(const size_t &j: keep) C[t+1].push_back(to[j]);
+        end = hrc::now();
+        dtAstar += double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count())*NANOS_TO_SECS;
+
+        begin = hrc::now();
+        candidates.clear();
+        for(long j: C[t+1]) candidates.push_back(S[j]);
+        addScores(Y[t+1], dArc, candidates, Dt, scores);
+        viterbi.run();
+        end = hrc::now();
+        dtViterbi += double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count())*NANOS_TO_SECS;
     }
-    end = hrc::now();
-    dt = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count())*NANOS_TO_SECS;
-    cout << dt << "\t" << flush;
-    
-    // ======== HIDDEN MARKOV MODEL (VITERBI) ========
-    MyPi Pi(sigma_z, S, Y[0]);
-    MyA A(beta, Y, distMatrix);
-    MyB B(sigma_z, S, Y);
 
     begin = hrc::now();
-    ViterbiOptimized viterbi;
-    viterbi.initialize(T, K, &Pi, &A, &B, candidateStates);
-    viterbi.run();
-
-    vector<long> v = viterbi.getLikeliestPath();
+    vector<size_t> v = viterbi.getLikeliestPath();
     end = hrc::now();
-    dt = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count())*NANOS_TO_SECS;
-    cout << dt << "\t";
+    dtViterbi += double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count())*NANOS_TO_SECS;
+    cout << dtAstar << "\t" << dtViterbi << "\t";
 
     cout << endl;
 
     // Final processing
     assert(v.size() == Y.size());
-    
+
     vector<node_t> matches(v.size());
-    for(size_t i = 0; i < v.size(); ++i){
-        matches[i] = idxToNode[v[i]];
+    for(size_t t = 0; t < v.size(); ++t){
+        matches[t] = idxToNode[C[t][v[t]]];
     }
     return matches;
 }
+
+vector<size_t> HiddenMarkovModel::getBeam(const double *s, size_t n) const {
+    double best = ViterbiLog::LOG_ZERO;
+    for(size_t j = 0; j < n; ++j) best = max(best, s[j]);
+
+    vector<size_t> beam;
+    for(size_t j = 0; j < n; ++j)
+        if(ViterbiLog::isReachable(s[j]) && s[j] >= best - beamMargin)
+            beam.push_back(j);
+
+    if(beamWidth > 0 && beam.size() > beamWidth){
+        nth_element(beam.begin(), beam.begin() + long(beamWidth), beam.end(), [s](size_t i, size_t j){
+            if(s[i] > s[j]) return true;
+            if(s[i] < s[j]) return false;
+            return i < j;
+        });
+        beam.resize(beamWidth);
+        sort(beam.begin(), beam.end());
+    }
+    return beam;
+}
+
+void HiddenMarkovModel::getRouteDistances(
+    const double *s, const vector<size_t> &beam,
+    const VI &from, const VI &to,
+    const vector<Coord> &S, const vector<node_t> &idxToNode,
+    double dArc, double dMax, VF &D
+) const {
+    const size_t n = to.size();
+    D.assign(from.size()*n, fINF);
+    if(n == 0) return;
+
+    const DWGraph::weight_t wMax = (dMax < fINF ? DWGraph::weight_t(dMax*METERS_TO_MILLIMS) : iINF);
+
+    auto search = [&](size_t i, const vector<size_t> &js){
+        list<node_t> l;
+        for(const size_t &j: js) l.push_back(idxToNode.at(to[j]));
+        shortestPathFew.initialize(&distGraph, idxToNode.at(from[i]), l, wMax);
+        shortestPathFew.run();
+        for(const size_t &j: js){
+            DWGraph::weight_t d = shortestPathFew.getPathWeight(idxToNode.at(to[j]));
+            D[i*n + j] = (d == iINF || d > wMax ? fINF : double(d)*MILLIMS_TO_METERS);
+        }
+    };
+
+    // Edge weights are truncated to millimetres, so route distances can be
+    // slightly shorter than great-circle distances
+    const double SLACK = 1.0;
+
+    VF lat(n), lon(n), g(n);
+    for(size_t j = 0; j < n; ++j){
+        lat[j] = S[to[j]].lat();
+        lon[j] = S[to[j]].lon();
+    }
+
+    vector<size_t> js;
+    if(!lazy){
+        for(const size_t &i: beam){
+            // Drop pairs too far apart to be travelled in time
+            js.clear();
+            Coord::getDistanceArcMany(S[from[i]], lat.data(), lon.data(), n, g.data());
+            for(size_t j = 0; j < n; ++j)
+                if(g[j] - SLACK <= dMax) js.push_back(j);
+            if(!js.empty()) search(i, js);
+        }
+        return;
+    }
+
+    const double aMax = logTransitionProbability(beta, dArc, dArc);
+
+    vector<size_t> order = beam;
+    stable_sort(order.begin(), order.end(), [s](size_t i, size_t j){ return s[i] > s[j]; });
+
+    // best[j]: best score of a path to j through a pair already searched
+    VF best(n, ViterbiLog::LOG_ZERO);
+    for(const size_t &i: order){
+        // No pair from this or any later source can improve or tie any
+        // target; ties are searched too, so they resolve as if eager
+        if(s[i] + aMax < *min_element(best.begin(), best.end())) break;
+
+        Coord::getDistanceArcMany(S[from[i]], lat.data(), lon.data(), n, g.data());
+        js.clear();
+        for(size_t j = 0; j < n; ++j){
+            if(g[j] - SLACK > dMax) continue;
+            const double dLow = max(dArc, g[j] - SLACK);
+            if(s[i] + logTransitionProbability(beta, dArc, dLow) >= best[j]) js.push_back(j);
+        }
+        if(js.empty()) continue;
+
+        search(i, js);
+        for(const size_t &j: js)
+            if(D[i*n + j] < fINF)
+                best[j] = max(best[j], s[i] + logTransitionProbability(beta, dArc, D[i*n + j]));
+    }
+}
+
+void HiddenMarkovModel::getScores(
+    const vector<Coord> &Y,
+    const vector<vector<Coord>> &candidates,
+    const vector<VF> &dRoute,
+    ViterbiLog::Scores &scores
+) const {
+    scores.clear();
+    for(size_t t = 0; t < Y.size(); ++t){
+        // Great-circle distance between consecutive observations
+        const double dArc = (t == 0 ? 0.0 : Coord::getDistanceArc(Y[t-1], Y[t]));
+        addScores(Y[t], dArc, candidates[t], dRoute[t], scores);
+    }
+}
+
+void HiddenMarkovModel::addScores(
+    const Coord &z, double dArc,
+    const vector<Coord> &candidates,
+    const VF &dRoute,
+    ViterbiLog::Scores &scores
+) const {
+    // log(emissionProbability) = -0.5*(d/sigma_z)^2 - logNormEmission
+    // log(transitionProbability) = -|dArc-dRoute|/beta - logBeta
+    const double logNormEmission = log(sqrt(2*M_PI) * sigma_z);
+    const double logBeta = log(beta);
+    const double inv2Sigma2 = 0.5/(sigma_z*sigma_z);
+    const double invBeta = 1.0/beta;
+
+    const size_t t = scores.getSteps();
+    const size_t n = candidates.size();
+    scores.addStep(n);
+
+    // Emissions
+    VF lat(n), lon(n), d(n);
+    for(size_t j = 0; j < n; ++j){
+        lat[j] = candidates[j].lat();
+        lon[j] = candidates[j].lon();
+    }
+    Coord::getDistanceArcMany(z, lat.data(), lon.data(), n, d.data());
+    double *b = scores.emission(t);
+    for(size_t j = 0; j < n; ++j)
+        b[j] = -d[j]*d[j]*inv2Sigma2 - logNormEmission;
+
+    if(t == 0) return;
+
+    // Transitions
+    const size_t m = scores.getSize(t-1);
+    const size_t stride = scores.getStride(t);
+    const double *D = dRoute.data();
+    double *a = scores.transition(t);
+    for(size_t i = 0; i < m; ++i){
+        const double *Di = D + i*n;
+        double *ai = a + i*stride;
+        for(size_t j = 0; j < n; ++j){
+            const double x = -fabs(dArc - Di[j])*invBeta - logBeta;
+            ai[j] = (Di[j] < fINF ? x : ViterbiLog::LOG_ZERO);
+        }
+    }
+}
+
+HiddenMarkovModel::Session::Session(const HiddenMarkovModel &hmm_, ShortestPathFew &shortestPathFew_, size_t maxLag_):
+hmm(hmm_), shortestPathFew(shortestPathFew_), maxLag(max(maxLag_, size_t(1))){}
+
+void HiddenMarkovModel::Session::decide(size_t s, uint32_t k, vector<node_t> &matches){
+    vector<uint32_t> path(s+1);
+    path[s] = k;
+    for(size_t t = s; t > 0; --t) path[t-1] = window[t].prev[path[t]];
+    for(size_t t = 0; t <= s; ++t) matches.push_back(hmm.nodes[window[t].states[path[t]]]);
+
+    window.erase(window.begin(), window.begin() + long(s+1));
+
+    // Keep only the states that descend from the decision
+    vector<uint32_t> newIdx;
+    for(size_t t = 0; t < window.size(); ++t){
+        step_t &step = window[t];
+        vector<uint32_t> prevIdx; prevIdx.swap(newIdx);
+        newIdx.assign(step.states.size(), INVALID);
+        size_t n = 0;
+        for(size_t j = 0; j < step.states.size(); ++j){
+            uint32_t p = (t == 0 ? (step.prev[j] == k ? 0 : INVALID) : prevIdx[step.prev[j]]);
+            if(p == INVALID) continue;
+            newIdx[j] = uint32_t(n);
+            step.states[n] = step.states[j];
+            step.prob  [n] = step.prob  [j];
+            step.prev  [n] = (t == 0 ? INVALID : p);
+            ++n;
+        }
+        step.states.resize(n);
+        step.prob  .resize(n);
+        step.prev  .resize(n);
+    }
+    if(!window.empty()){
+        vector<double> &prob = window.back().prob;
+        double maxProb = *max_element(prob.begin(), prob.end());
+        for(double &p: prob) p /= maxProb;
+    }
+}
+
+vector<node_t> HiddenMarkovModel::Session::push(const Coord &z){
+    vector<size_t> idxs;
+    hmm.closestPointsInRadius.getClosestPointsIdx(z, idxs);
+    if(idxs.empty()) throw runtime_error("Observation has no candidates");
+
+    vector<node_t> matches;
+
+    step_t step;
+    if(!window.empty()){
+        const step_t &prevStep = window.back();
+        const double dArc = Coord::getDistanceArc(lastObservation, z);
+
+        list<node_t> l;
+        for(const size_t &c: idxs) l.push_back(hmm.nodes[c]);
+
+        vector<double> B(idxs.size());
+        for(size_t j = 0; j < idxs.size(); ++j)
+            B[j] = emissionProbability(hmm.sigma_z, Coord::getDistanceArc(z, hmm.mapGraph->nodeToCoord(hmm.nodes[idxs[j]])));
+
+        vector<double> prob(idxs.size(), 0.0);
+        vector<uint32_t> prev(idxs.size(), INVALID);
+        for(size_t i = 0; i < prevStep.states.size(); ++i){
+            shortestPathFew.initialize(&hmm.distGraph, hmm.nodes[prevStep.states[i]], l);
+            shortestPathFew.run();
+            for(size_t j = 0; j < idxs.size(); ++j){
+                DWGraph::weight_t d = shortestPathFew.getPathWeight(hmm.nodes[idxs[j]]);
+                if(d == iINF) continue;
+                double p = prevStep.prob[i] * transitionProbability(hmm.beta, dArc, double(d)*MILLIMS_TO_METERS) * B[j];
+                if(p > prob[j]){
+                    prob[j] = p;
+                    prev[j] = uint32_t(i);
+                }
+            }
+        }
+
+        for(size_t j = 0; j < idxs.size(); ++j){
+            if(prob[j] <= 0.0) continue;
+            step.states.push_back(uint32_t(idxs[j]));
+            step.prob  .push_back(prob[j]);
+            step.prev  .push_back(prev[j]);
+        }
+
+        // Unreachable from the previous observation, start over
+        if(step.states.empty()) matches = flush();
+    }
+    if(step.states.empty()){
+        for(const size_t &c: idxs){
+            step.states.push_back(uint32_t(c));
+            step.prob  .push_back(emissionProbability(hmm.sigma_z, Coord::getDistanceArc(z, hmm.mapGraph->nodeToCoord(hmm.nodes[c]))));
+            step.prev  .push_back(INVALID);
+        }
+    }
+
+    double maxProb = *max_element(step.prob.begin(), step.prob.end());
+    if(maxProb > 0.0) for(double &p: step.prob) p /= maxProb;
+
+    window.push_back(move(step));
+    lastObservation = z;
+
+    // Decide up to the last step all current states descend from; the newest
+    // step is never decided here, so the next observation is still matched
+    // from its states
+    if(window.size() > 1){
+        vector<uint32_t> ancestors = window.back().prev;
+        for(size_t t = window.size()-1; t-- > 0; ){
+            sort(ancestors.begin(), ancestors.end());
+            ancestors.erase(unique(ancestors.begin(), ancestors.end()), ancestors.end());
+            if(ancestors.size() == 1){
+                decide(t, ancestors[0], matches);
+                break;
+            }
+            if(t == 0) break;
+            for(uint32_t &j: ancestors) j = window[t].prev[j];
+        }
+    }
+
+    // Bound the lag by deciding the oldest step
+    while(window.size() > maxLag){
+        const step_t &last = window.back();
+        uint32_t j = uint32_t(max_element(last.prob.begin(), last.prob.end()) - last.prob.begin());
+        for(size_t t = window.size()-1; t > 0; --t) j = window[t].prev[j];
+        decide(0, j, matches);
+    }
+
+    return matches;
+}
+
+vector<node_t> HiddenMarkovModel::Session::flush(){
+    vector<node_t> matches;
+    if(window.empty()) return matches;
+
+    const step_t &last = window.back();
+    uint32_t j = uint32_t(max_element(last.prob.begin(), last.prob.end()) - last.prob.begin());
+    decide(window.size()-1, j, matches);
+    return matches;
+}
+
+size_t HiddenMarkovModel::Session::getWindowSize() const {
+    return window.size();
+}
@@ -0,0 +1,99 @@
+#include "HiddenMarkovModelHybrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "utils.h"
+
+using namespace std;
+
+typedef DWGraph::node_t node_t;
+
+const double MILLIMS_TO_METERS = (1.0/1000.0);
+const double METERS_TO_MILLIMS = 1000.0;
+
+HiddenMarkovModelHybrid::HiddenMarkovModelHybrid(
+    MapMatching::FromClosestPoint &nearestNeighbour_,
+    HiddenMarkovModel &hmm_,
+    ShortestPathFew &shortestPathFew_,
+    double maxDistance_, double maxDetour_, size_t context_
+):
+    nearestNeighbour(nearestNeighbour_),
+    hmm(hmm_),
+    shortestPathFew(shortestPathFew_),
+    maxDistance(maxDistance_), maxDetour(maxDetour_), context(context_),
+    stats{0, 0, 0}
+{}
+
+void HiddenMarkovModelHybrid::initialize(const MapGraph *mapGraph_){
+    mapGraph = mapGraph_;
+    distGraph = mapGraph->getDistanceGraph();
+    nearestNeighbour.initialize(mapGraph);
+    hmm.initialize(mapGraph);
+}
+
+void HiddenMarkovModelHybrid::run(){
+    nearestNeighbour.run();
+    hmm.run();
+}
+
+vector<node_t> HiddenMarkovModelHybrid::getMatches(const vector<Coord> &trip) const {
+    const size_t T = trip.size();
+    vector<node_t> matches = nearestNeighbour.getMatches(trip);
+
+    vector<bool> doubtful(T, false);
+    for(size_t t = 0; t < T; ++t){
+        if(Coord::getDistanceArc(trip[t], mapGraph->nodeToCoord(matches[t])) > maxDistance)
+            doubtful[t] = true;
+    }
+    for(size_t t = 0; t+1 < T; ++t){
+        if(doubtful[t] && doubtful[t+1]) continue;
+        const double dArc = Coord::getDistanceArc(trip[t], trip[t+1]);
+        double dRoute = 0.0;
+        if(matches[t] != matches[t+1]){
+            const DWGraph::weight_t wMax = DWGraph::weight_t((dArc + maxDetour)*METERS_TO_MILLIMS);
+            shortestPathFew.initialize(&distGraph, matches[t], {matches[t+1]}, wMax);
+            shortestPathFew.run();
+            const DWGraph::weight_t w = shortestPathFew.getPathWeight(matches[t+1]);
+            dRoute = (w == iINF || w > wMax ? fINF : double(w)*MILLIMS_TO_METERS);
+        }
+        if(fabs(dRoute - dArc) > maxDetour)
+            doubtful[t] = doubtful[t+1] = true;
+    }
+
+    // Widen doubtful observations by context on each side
+    vector<bool> slow(T, false);
+    size_t fast = T;
+    for(size_t t = 0; t < T; ++t){
+        if(!doubtful[t]) continue;
+        const size_t l = (t >= context ? t - context : 0), r = min(T, t + context + 1);
+        for(size_t k = l; k < r; ++k) slow[k] = true;
+    }
+
+    for(size_t l = 0; l < T;){
+        if(!slow[l]){ ++l; continue; }
+        size_t r = l;
+        while(r < T && slow[r]) ++r;
+
+        const vector<Coord> window(trip.begin() + long(l), trip.begin() + long(r));
+        const vector<node_t> windowMatches = hmm.getMatches(window);
+        copy(windowMatches.begin(), windowMatches.end(), matches.begin() + long(l));
+        fast -= r - l;
+        ++stats.windows;
+
+        l = r;
+    }
+
+    stats.points += T;
+    stats.fastPoints += fast;
+
+    return matches;
+}
+
+HiddenMarkovModelHybrid::stats_t HiddenMarkovModelHybrid::getStats() const {
+    return stats;
+}
+
+void HiddenMarkovModelHybrid::resetStats(){
+    stats = stats_t{0, 0, 0};
+}
@@ -2,6 +2,19 @@
 
 #include "HiddenMarkovModel.h"
 #include "Kosaraju.h"
+#include "ViterbiParallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
 
 using namespace std;
 using namespace utils;
@@ -20,11 +33,13 @@ const double METERS_TO_MILLIMS = 1000.0;
 HiddenMarkovModelMany::HiddenMarkovModelMany(
     ClosestPointsInRadius &closestPointsInRadius_,
     double d_, double sigma_z_, double beta_,
-    size_t nThreads
+    size_t nThreads_, double maxSpeed_,
+    ShortestPathAll *shortestPathAll_
 ):
     closestPointsInRadius(closestPointsInRadius_),
-    d(d_), sigma_z(sigma_z_), beta(beta_),
-    threadPool(nThreads)
+    d(d_), sigma_z(sigma_z_), beta(beta_), maxSpeed(maxSpeed_),
+    nThreads(nThreads_), threadPool(nThreads_),
+    shortestPathAll(shortestPathAll_)
 {
 }
 
@@ -40,8 +55,13 @@ void HiddenMarkovModelMany::initialize(
     const MapGraph *mapGraph_,
     const vector<Trip> &trips_
 ){
-    mapGraph = mapGraph_;
+    initialize(mapGraph_);
     trips = &trips_;
+}
+
+void HiddenMarkovModelMany::initialize(const MapGraph *mapGraph_){
+    mapGraph = mapGraph_;
+    trips = nullptr;
 
     // Get distGraph
     distGraph = mapGraph->getDistanceGraph();
@@ -56,37 +76,45 @@ void HiddenMarkovModelMany::initialize(
         }
     }
 
-    auto nodes = distGraph.getNodes();
+    nodes.clear();
     list<Coord> l;
-    for(const node_t &u: nodes) l.push_back(mapGraph->nodeToCoord(u));
+    for(const node_t &u: distGraph.getNodes()){
+        nodes.push_back(u);
+        l.push_back(mapGraph->nodeToCoord(u));
+    }
     cout << "Initializing closest points with " << l.size() << " points out of " << mapGraph->getNodes().size() << endl;
     closestPointsInRadius.initialize(l, d);
 }
 
-void HiddenMarkovModelMany::candidatesWorker(HiddenMarkovModelMany *hmm, size_t idx){
-    set<DWGraph::node_t> &cands = hmm->candidates.at(idx);
-    while(true){
-        hmm->candidatesMutex.lock();
-        if(hmm->observations.size() <= 0){
-            hmm->candidatesMutex.unlock();
-            break;
-        }
-
-        cout << "Thread " << idx << ", " << hmm->observations.size() << endl;
-
-        list<Coord> *obs = hmm->observations.front();
-        hmm->observations.pop_front();
-        hmm->candidatesMutex.unlock();
-
-        for(const Coord &p: *obs){
-            vector<Coord> candsCoord = hmm->closestPointsInRadius.getClosestPoints(p);
-            for(const Coord &c: candsCoord){
-                cands.insert(hmm->mapGraph->coordToNode(c));
-            }
+vector<size_t> HiddenMarkovModelMany::getCandidates() const {
+    vector<bool> isCandidate(nodes.size(), false);
+    mutex isCandidateMutex;
+    parallelFor(trips->size(), nThreads, [this, &isCandidate, &isCandidateMutex](size_t l, size_t r){
+        vector<bool> found(nodes.size(), false);
+        vector<size_t> offsets, idxs;
+        for(size_t i = l; i < r; ++i){
+            closestPointsInRadius.getClosestPointsMany(trips->at(i).coords, offsets, idxs);
+            for(const size_t &c: idxs) found[c] = true;
         }
+        lock_guard<mutex> lock(isCandidateMutex);
+        for(size_t c = 0; c < found.size(); ++c)
+            if(found[c]) isCandidate[c] = true;
+    });
+
+    vector<size_t> ret;
+    for(size_t c = 0; c < isCandidate.size(); ++c)
+        if(isCandidate[c]) ret.push_back(c);
+    return ret;
+}
 
-        delete obs;
+void HiddenMarkovModelMany::getPathWeights(node_t u, const vector<node_t> &v, vector<DWGraph::weight_t> &res) const {
+    if(shortestPathAll != nullptr){
+        shortestPathAll->getPathWeights(u, v, res);
+        return;
     }
+    const DijkstraDist &dijkstra = dijkstras.at(u);
+    res.resize(v.size());
+    for(size_t j = 0; j < v.size(); ++j) res[j] = dijkstra.getPathWeight(v[j]);
 }
 
 class DijkstraDistTask: public ThreadPool::Task {
@@ -97,88 +125,130 @@ public:
     virtual void run(){ dijkstraDist.run(); }
 };
 
-HiddenMarkovModelMany::TripTask::TripTask(
-    const HiddenMarkovModelMany &hmm_,
-    const Trip &trip_,
-    size_t index_
-):hmm(hmm_), trip(trip_), index(index_){}
-HiddenMarkovModelMany::TripTask::~TripTask(){}
-void HiddenMarkovModelMany::TripTask::run(){
-    if(index % 1000 == 0) cout << "Index: " << index << endl;
-    try {
-        const vector<Coord> &Y = trip.coords;
-        const size_t &T = Y.size();
-
-        map<Coord, long, bool (*)(const Vector2&, const Vector2&)> Sv(Vector2::compXY);
-        vector<Coord> S;
-        vector<node_t> idxToNode;
-        vector<set<long>> candidateStates(T);
-        for(size_t t = 0; t < T; ++t){
-            vector<Coord> v = hmm.closestPointsInRadius.getClosestPoints(Y.at(t));
-            if(v.empty()) throw runtime_error("Location t=" + to_string(t) + " has no candidates");
-            for(const Coord &c: v){
-                if(!Sv.count(c)){
-                    long id = Sv.size();
-                    Sv[c] = id;
-                    S.push_back(c);
-                    idxToNode.push_back(hmm.mapGraph->coordToNode(c));
-                }
-                candidateStates.at(t).insert(Sv.at(c));
+void HiddenMarkovModelMany::matchTrip(const Trip &trip, vector<node_t> &matches, atomic<size_t> *spareThreads) const {
+    const vector<Coord> &Y = trip.coords;
+    const size_t &T = Y.size();
+
+    vector<size_t> offsets, idxs;
+    closestPointsInRadius.getClosestPointsMany(Y, offsets, idxs);
+
+    unordered_map<size_t, long> Sv;
+    vector<Coord> S;
+    vector<node_t> idxToNode;
+    vector<set<long>> candidateStates(T);
+    for(size_t t = 0; t < T; ++t){
+        if(offsets[t] == offsets[t+1]) throw runtime_error("Location t=" + to_string(t) + " has no candidates");
+        for(size_t k = offsets[t]; k < offsets[t+1]; ++k){
+            const size_t &c = idxs[k];
+            auto it = Sv.find(c);
+            if(it == Sv.end()){
+                it = Sv.emplace(c, Sv.size()).first;
+                idxToNode.push_back(nodes[c]);
+                S.push_back(mapGraph->nodeToCoord(nodes[c]));
             }
+            candidateStates.at(t).insert(it->second);
+        }
+    }
+    const size_t &K = Sv.size();
+
+    // ======== DISTANCE MATRIX (A*) ========
+    const vector<long long> timestamps = trip.getTimestamps();
+    VVF distMatrix(K, VF(K, fINF));
+    for(size_t t = 0; t+1 < T; ++t){
+        // Longest route that can be travelled between both observations;
+        // longer routes are dropped after the search, which is not bounded
+        // by it, since searches are shared by all trips (and cached with
+        // their own bound)
+        double dMax = fINF;
+        if(maxSpeed < fINF){
+            const double dArc = Coord::getDistanceArc(Y[t], Y[t+1]);
+            dMax = max(dArc, maxSpeed*double(timestamps[t+1] - timestamps[t])) + 2*d;
         }
-        const size_t &K = Sv.size();
-
-        // ======== DISTANCE MATRIX (A*) ========
-        VVF distMatrix(K, VF(K, fINF));
-        for(size_t t = 0; t+1 < T; ++t){
-            list<node_t> l;
-            for(size_t j: candidateStates.at(t+1)) l.push_back(idxToNode.at(j));
 
-            for(size_t i: candidateStates.at(t)){
-                for(size_t j: candidateStates.at(t+1)){
-                    const node_t
-                        &u = idxToNode.at(i),
-                        &v = idxToNode.at(j);
-                    DWGraph::weight_t d = hmm.dijkstras.at(u).getPathWeight(v);
-                    double df = double(d)*MILLIMS_TO_METERS;
-                    distMatrix[i][j] = (d == iINF ? fINF : df);
-                }
+        vector<node_t> to;
+        for(size_t j: candidateStates.at(t+1)) to.push_back(idxToNode.at(j));
+
+        vector<DWGraph::weight_t> w;
+        for(size_t i: candidateStates.at(t)){
+            getPathWeights(idxToNode.at(i), to, w);
+            size_t k = 0;
+            for(size_t j: candidateStates.at(t+1)){
+                const DWGraph::weight_t &dij = w[k++];
+                double df = double(dij)*MILLIMS_TO_METERS;
+                distMatrix[i][j] = (dij == iINF || df > dMax ? fINF : df);
             }
+        }
 
-            for(
-                auto it = candidateStates.at(t+1).begin();
-                it != candidateStates.at(t+1).end();
-            ){
-                size_t j = *it;
-
-                double dBest = fINF;
-                for(size_t i: candidateStates.at(t)){
-                    dBest = min(dBest, distMatrix[i][j]);
-                }
+        for(
+            auto it = candidateStates.at(t+1).begin();
+            it != candidateStates.at(t+1).end();
+        ){
+            size_t j = *it;
 
-                if(dBest >= fINF) it = candidateStates.at(t+1).erase(it);
-                else ++it;
+            double dBest = fINF;
+            for(size_t i: candidateStates.at(t)){
+                dBest = min(dBest, distMatrix[i][j]);
             }
+
+            if(dBest >= fINF) it = candidateStates.at(t+1).erase(it);
+            else ++it;
         }
+    }
 
-        // ======== HIDDEN MARKOV MODEL (VITERBI) ========
-        HiddenMarkovModel::MyPi Pi(hmm.sigma_z, S, Y[0]);
-        HiddenMarkovModel::MyA A(hmm.beta, Y, distMatrix);
-        HiddenMarkovModel::MyB B(hmm.sigma_z, S, Y);
+    // ======== HIDDEN MARKOV MODEL (VITERBI) ========
+    HiddenMarkovModel::MyPi Pi(sigma_z, S, Y[0]);
+    HiddenMarkovModel::MyA A(beta, Y, distMatrix);
+    HiddenMarkovModel::MyB B(sigma_z, S, Y);
 
-        ViterbiOptimized viterbi;
-        viterbi.initialize(T, K, &Pi, &A, &B, candidateStates);
-        viterbi.run();
+    // Long trips are split in time over idle threads, if there are any
+    size_t extraThreads = 0;
+    if(spareThreads != nullptr && T >= ViterbiParallel::DEFAULT_MIN_STEPS)
+        extraThreads = spareThreads->exchange(0);
 
-        vector<long> v = viterbi.getLikeliestPath();
+    vector<long> v;
+    if(extraThreads == 0){
+        ViterbiSparse viterbi;
+        viterbi.initialize(&Pi, &A, &B, candidateStates);
+        viterbi.run();
 
-        // Final processing
-        assert(v.size() == Y.size());
-        
-        matches = vector<node_t>(v.size());
-        for(size_t i = 0; i < v.size(); ++i){
-            matches[i] = idxToNode[v[i]];
+        v = viterbi.getLikeliestPath();
+    } else {
+        try {
+            ViterbiLog::Scores scores = ViterbiLog::Scores::fromGenerators(&Pi, &A, &B, candidateStates);
+            ViterbiParallel viterbi(1 + extraThreads);
+            viterbi.initialize(&scores);
+            viterbi.run();
+
+            vector<size_t> local = viterbi.getLikeliestPath();
+            v.resize(local.size());
+            for(size_t t = 0; t < T; ++t)
+                v[t] = *next(candidateStates.at(t).begin(), long(local[t]));
+        } catch(...) {
+            *spareThreads += extraThreads;
+            throw;
         }
+        *spareThreads += extraThreads;
+    }
+
+    // Final processing
+    assert(v.size() == Y.size());
+    
+    matches = vector<node_t>(v.size());
+    for(size_t i = 0; i < v.size(); ++i){
+        matches[i] = idxToNode[v[i]];
+    }
+}
+
+HiddenMarkovModelMany::TripTask::TripTask(
+    const HiddenMarkovModelMany &hmm_,
+    const Trip &trip_,
+    size_t index_
+):hmm(hmm_), trip(trip_), index(index_){}
+HiddenMarkovModelMany::TripTask::~TripTask(){}
+void HiddenMarkovModelMany::TripTask::run(){
+    if(index % 1000 == 0) cout << "Index: " << index << endl;
+    try {
+        hmm.matchTrip(trip, matches);
         success = true;
     } catch(const exception &e){
         success = false;
@@ -188,21 +258,26 @@ const Trip &HiddenMarkovModelMany::TripTask::getTrip() const { return trip; }
 bool HiddenMarkovModelMany::TripTask::succeeded() const { return success; }
 const vector<node_t> &HiddenMarkovModelMany::TripTask::getMatches() const { return matches; }
 
-void HiddenMarkovModelMany::run(){
-    cout << "Total number of trips: " << trips->size() << endl;
-
+void HiddenMarkovModelMany::precompute(){
     hrc::time_point begin, end; double dt;
 
-    // Run closest points
-    closestPointsInRadius.run();
+    // Only nodes that are candidates of some observation are ever searched from
+    cout << "Finding candidates..." << endl;
+    begin = hrc::now();
+
+    const vector<size_t> sources = getCandidates();
+
+    end = hrc::now();
+    dt = double(chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count())*NANOS_TO_SECS;
+    cout << "Found " << sources.size() << " candidates out of " << nodes.size() << " nodes, took " << dt << "s" << endl;
 
     // Run shortest paths
     cout << "Calculating paths..." << endl;
     begin = hrc::now();
 
-    dijkstras.clear();
     list<DijkstraDistTask> dijkstraTasks;
-    for(const DWGraph::node_t &s: distGraph.getNodes()){
+    for(const size_t &c: sources){
+        const node_t &s = nodes[c];
         dijkstras.emplace(s, 650*METERS_TO_MILLIMS);
         dijkstras.at(s).initialize(&distGraph, s);
         dijkstraTasks.emplace_back(dijkstras.at(s));
@@ -217,6 +292,34 @@ void HiddenMarkovModelMany::run(){
     end = hrc::now();
     dt = double(chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count())*NANOS_TO_SECS;
     cout << "Calculated paths, took " << dt << "s" << endl;
+}
+
+void HiddenMarkovModelMany::prepare(){
+    // Run closest points
+    closestPointsInRadius.run();
+
+    dijkstras.clear();
+    if(shortestPathAll != nullptr){
+        // Route distances are found on request and shared by all trips
+        shortestPathAll->initialize(&distGraph);
+        shortestPathAll->run();
+    } else if(trips != nullptr){
+        precompute();
+    } else {
+        throw logic_error("HiddenMarkovModelMany needs the trips to precompute paths, or a ShortestPathAll");
+    }
+}
+
+double HiddenMarkovModelMany::getCost(const Trip &trip){
+    return double(trip.coords.size());
+}
+
+void HiddenMarkovModelMany::run(){
+    cout << "Total number of trips: " << trips->size() << endl;
+
+    hrc::time_point begin, end; double dt;
+
+    prepare();
 
     // Process all trips
     cout << "Matching trips..." << endl;
@@ -226,10 +329,29 @@ void HiddenMarkovModelMany::run(){
     size_t index = 0;
     for(const Trip &trip: *trips) tripTasks[trip.id] = new TripTask(*this, trip, index++);
 
+    // Longest trips first, so no long trip is left running alone at the end
+    vector<TripTask*> tasks;
+    tasks.reserve(tripTasks.size());
+    for(auto &p: tripTasks) tasks.push_back(p.second);
+    vector<double> costs(tasks.size());
+    for(size_t i = 0; i < tasks.size(); ++i) costs[i] = getCost(tasks[i]->getTrip());
+    vector<size_t> order(tasks.size());
+    iota(order.begin(), order.end(), 0);
+    stable_sort(order.begin(), order.end(), [&costs](size_t i, size_t j){
+        return costs[i] > costs[j];
+    });
+
     cout << "Matching trips in parallel..." << endl;
 
-    for(auto &p: tripTasks) threadPool.submit(p.second);
-    for(auto &p: tripTasks) p.second->wait();
+    hrc::time_point beginMatch = hrc::now();
+    threadPool.resetBusyTimes();
+    for(size_t i: order) threadPool.submit(tasks[i]);
+    for(TripTask *task: tasks) task->wait();
+    const double dtMatch = double(chrono::duration_cast<std::chrono::nanoseconds>(hrc::now()-beginMatch).count())*NANOS_TO_SECS;
+    const vector<double> busy = threadPool.getBusyTimes();
+    for(size_t i = 0; i < busy.size(); ++i)
+        cout << "Thread " << i << ": busy " << busy[i] << "s (" << 100.0*busy[i]/dtMatch << "%)" << endl;
+    cout << "Mean utilization: " << 100.0*accumulate(busy.begin(), busy.end(), 0.0)/(double(busy.size())*dtMatch) << "%" << endl;
     for(auto it = tripTasks.begin(); it != tripTasks.end();){
         if(it->second->succeeded()) ++it;
         else it = tripTasks.erase(it);
@@ -243,3 +365,274 @@ void HiddenMarkovModelMany::run(){
 const vector<node_t> &HiddenMarkovModelMany::getMatches(long long tripId) const{
     return tripTasks.at(tripId)->getMatches();
 }
+
+HiddenMarkovModelMany::Pipeline::Pipeline(
+    const HiddenMarkovModelMany &hmm_,
+    size_t nThreads_, size_t chunkSize_, size_t maxChunks_,
+    double reportPeriod_
+):
+    hmm(hmm_),
+    nThreads(nThreads_), chunkSize(chunkSize_), maxChunks(maxChunks_),
+    reportPeriod(reportPeriod_)
+{}
+
+size_t HiddenMarkovModelMany::Pipeline::run(Trip::Reader &reader, ostream &os){
+    return run(reader, [&os](const Trip &trip, const vector<node_t> *matches){
+        if(matches == nullptr) return;
+        os << trip.id << " " << matches->size() << "\n";
+        for(const node_t &u: *matches) os << u << "\n";
+    });
+}
+
+size_t HiddenMarkovModelMany::Pipeline::run(Trip::Reader &reader, Checkpoint &checkpoint){
+    const size_t skipped = reader.skip(checkpoint.getMatchedTrips());
+    if(skipped > 0) cout << "Resuming after " << skipped << " trips already matched" << endl;
+
+    const size_t written = run(reader, [&checkpoint](const Trip &trip, const vector<node_t> *matches){
+        checkpoint.write(trip, matches);
+    });
+    checkpoint.commit();
+
+    return written;
+}
+
+size_t HiddenMarkovModelMany::Pipeline::run(Trip::Reader &reader, const writer_t &write){
+    typedef shared_ptr<chunk_t> chunk_ptr;
+    BoundedQueue<job_t> todo(maxChunks*chunkSize);
+    BoundedQueue<chunk_ptr> done(maxChunks);
+
+    // Chunks read but not written yet
+    mutex inFlightMutex;
+    condition_variable inFlightCv;
+    size_t inFlight = 0;
+    atomic<bool> stopped(false);
+
+    const size_t tripsBefore = reader.tell();
+
+    exception_ptr readError = nullptr;
+    thread readerThread([this, &reader, &todo, &inFlightMutex, &inFlightCv, &inFlight, &stopped, &readError](){
+        try {
+            for(size_t index = 0; ; ++index){
+                {
+                    unique_lock<mutex> lk(inFlightMutex);
+                    while(inFlight >= maxChunks && !stopped) inFlightCv.wait(lk);
+                    if(stopped) break;
+                }
+                chunk_ptr chunk(new chunk_t());
+                chunk->index = index;
+                Trip trip;
+                while(chunk->trips.size() < chunkSize && reader.next(trip))
+                    chunk->trips.push_back(move(trip));
+                if(chunk->trips.empty()) break;
+
+                const size_t n = chunk->trips.size();
+                chunk->matches.resize(n);
+                chunk->success.assign(n, false);
+                chunk->left = n;
+                {
+                    lock_guard<mutex> lock(inFlightMutex);
+                    ++inFlight;
+                }
+
+                // Longest trips first
+                vector<double> costs(n);
+                for(size_t i = 0; i < n; ++i) costs[i] = getCost(chunk->trips[i]);
+                vector<size_t> order(n);
+                iota(order.begin(), order.end(), 0);
+                stable_sort(order.begin(), order.end(), [&costs](size_t i, size_t j){
+                    return costs[i] > costs[j];
+                });
+                for(size_t i: order) todo.push(job_t{chunk, i});
+            }
+        } catch(...) {
+            readError = current_exception();
+        }
+        todo.close();
+    });
+
+    // Workers that ran out of trips lend their thread to the long trips still
+    // being matched
+    vector<atomic<long long>> busy(nThreads);
+    atomic<size_t> workersLeft(nThreads);
+    atomic<size_t> spareThreads(0);
+    list<thread> workers;
+    for(size_t k = 0; k < nThreads; ++k){
+        workers.emplace_back([this, k, &todo, &done, &busy, &workersLeft, &spareThreads, &stopped](){
+            job_t job;
+            while(!stopped && todo.pop(job)){
+                chunk_t &chunk = *job.chunk;
+                const hrc::time_point begin = hrc::now();
+                try {
+                    hmm.matchTrip(chunk.trips[job.i], chunk.matches[job.i], &spareThreads);
+                    chunk.success[job.i] = true;
+                } catch(const exception &e){}
+                busy[k] += chrono::duration_cast<chrono::nanoseconds>(hrc::now() - begin).count();
+                if(--chunk.left == 0) done.push(move(job.chunk));
+            }
+            ++spareThreads;
+            if(--workersLeft == 0) done.close();
+        });
+    }
+
+    auto getBusyTimes = [&busy](){
+        vector<double> ret(busy.size());
+        for(size_t k = 0; k < busy.size(); ++k) ret[k] = double(busy[k])*NANOS_TO_SECS;
+        return ret;
+    };
+
+    // Write chunks in order
+    hrc::time_point begin = hrc::now(), lastReport = begin;
+    map<size_t, chunk_ptr> pending;
+    size_t nextIndex = 0, tripsDone = 0, written = 0;
+    exception_ptr writeError = nullptr;
+    try {
+        chunk_ptr chunk;
+        while(done.pop(chunk)){
+            const size_t index = chunk->index;
+            pending[index] = move(chunk);
+            for(auto it = pending.find(nextIndex); it != pending.end(); it = pending.find(nextIndex)){
+                const chunk_t &c = *it->second;
+                for(size_t i = 0; i < c.trips.size(); ++i){
+                    if(!c.success[i]){
+                        write(c.trips[i], nullptr);
+                        continue;
+                    }
+                    write(c.trips[i], &c.matches[i]);
+                    ++written;
+                }
+                tripsDone += c.trips.size();
+                pending.erase(it);
+                ++nextIndex;
+                {
+                    lock_guard<mutex> lock(inFlightMutex);
+                    --inFlight;
+                }
+                inFlightCv.notify_all();
+            }
+
+            const hrc::time_point now = hrc::now();
+            if(double(chrono::duration_cast<chrono::nanoseconds>(now-lastReport).count())*NANOS_TO_SECS >= reportPeriod){
+                const double dt = double(chrono::duration_cast<chrono::nanoseconds>(now-begin).count())*NANOS_TO_SECS;
+                const vector<double> b = getBusyTimes();
+                cout << "Matched " << tripsBefore + tripsDone << "/" << reader.size() << " trips, "
+                     << double(tripsDone)/dt << " trips/s, "
+                     << 100.0*accumulate(b.begin(), b.end(), 0.0)/(double(nThreads)*dt) << "% worker utilization, "
+                     << pending.size() << " chunks waiting to be written" << endl;
+                lastReport = now;
+            }
+        }
+    } catch(...) {
+        writeError = current_exception();
+
+        // Wake up and stop the reader and the workers, so they can be joined
+        {
+            lock_guard<mutex> lock(inFlightMutex);
+            stopped = true;
+        }
+        inFlightCv.notify_all();
+        todo.close();
+        done.close();
+    }
+
+    readerThread.join();
+    for(thread &t: workers) t.join();
+    busyTimes = getBusyTimes();
+    if(writeError) rethrow_exception(writeError);
+    if(readError) rethrow_exception(readError);
+
+    const double dt = double(chrono::duration_cast<chrono::nanoseconds>(hrc::now()-begin).count())*NANOS_TO_SECS;
+    cout << "Matched " << tripsDone << " trips (" << written << " successfully), took " << dt << "s, "
+         << double(tripsDone)/dt << " trips/s" << endl;
+    for(size_t k = 0; k < nThreads; ++k)
+        cout << "Worker " << k << ": busy " << busyTimes[k] << "s (" << 100.0*busyTimes[k]/dt << "%)" << endl;
+    cout << "Mean utilization: " << 100.0*accumulate(busyTimes.begin(), busyTimes.end(), 0.0)/(double(nThreads)*dt) << "%" << endl;
+
+    return written;
+}
+
+const vector<double> &HiddenMarkovModelMany::Pipeline::getBusyTimes() const {
+    return busyTimes;
+}
+
+const string HiddenMarkovModelMany::Checkpoint::MANIFEST = "manifest.txt";
+
+HiddenMarkovModelMany::Checkpoint::Checkpoint(const string &dir_, size_t segmentSize_, const string &input_, size_t inputTrips_):
+    dir(dir_), segmentSize(segmentSize_), input(input_), inputTrips(inputTrips_)
+{
+    ifstream is(dir + "/" + MANIFEST);
+    if(!is) return;
+    // A line that was cut short (even within its last number, so without a
+    // newline) is ignored, along with everything after it
+    string line;
+    if(!getline(is, line) || is.eof()) return;
+    {
+        stringstream ss(line);
+        string tag, manifestInput;
+        size_t manifestTrips, manifestSegmentSize;
+        if(!(ss >> tag >> manifestTrips >> manifestSegmentSize) || tag != "input" || !getline(ss >> ws, manifestInput))
+            throw runtime_error("Invalid manifest header in " + dir);
+        if(manifestInput != input || manifestTrips != inputTrips || manifestSegmentSize != segmentSize)
+            throw runtime_error(
+                "Checkpoint in " + dir + " is of " + manifestInput + " (" + to_string(manifestTrips) + " trips, segments of " + to_string(manifestSegmentSize) + "), " +
+                "not of " + input + " (" + to_string(inputTrips) + " trips, segments of " + to_string(segmentSize) + ")"
+            );
+    }
+    while(getline(is, line) && !is.eof()){
+        stringstream ss(line);
+        segment_t segment;
+        if(!(ss >> segment.index >> segment.firstTrip >> segment.trips >> segment.written)) break;
+        if(segment.index != segments.size() || segment.firstTrip != matchedTrips) break;
+        segments.push_back(segment);
+        matchedTrips += segment.trips;
+    }
+}
+
+string HiddenMarkovModelMany::Checkpoint::getSegmentPath(size_t index) const {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "segment-%06zu.txt", index);
+    return dir + "/" + buf;
+}
+
+size_t HiddenMarkovModelMany::Checkpoint::getMatchedTrips() const {
+    return matchedTrips;
+}
+
+const vector<HiddenMarkovModelMany::Checkpoint::segment_t> &HiddenMarkovModelMany::Checkpoint::getSegments() const {
+    return segments;
+}
+
+void HiddenMarkovModelMany::Checkpoint::write(const Trip &trip, const vector<node_t> *matches){
+    if(!os.is_open()){
+        os.exceptions(ofstream::failbit | ofstream::badbit);
+        os.open(dir + "/segment.tmp");
+        current = segment_t{segments.size(), matchedTrips, 0, 0};
+    }
+    ++current.trips;
+    if(matches != nullptr){
+        os << trip.id << " " << matches->size() << "\n";
+        for(const node_t &u: *matches) os << u << "\n";
+        ++current.written;
+    }
+    if(current.trips >= segmentSize) commit();
+}
+
+void HiddenMarkovModelMany::Checkpoint::commit(){
+    if(!os.is_open()) return;
+    os.close();
+    if(rename((dir + "/segment.tmp").c_str(), getSegmentPath(current.index).c_str()) != 0)
+        throw runtime_error("Failed to commit segment " + to_string(current.index));
+
+    segments.push_back(current);
+    matchedTrips += current.trips;
+
+    // Manifest is replaced as a whole, so it always lists complete segments
+    {
+        ofstream manifest; manifest.exceptions(ofstream::failbit | ofstream::badbit);
+        manifest.open(dir + "/manifest.tmp");
+        manifest << "input " << inputTrips << " " << segmentSize << " " << input << "\n";
+        for(const segment_t &segment: segments)
+            manifest << segment.index << " " << segment.firstTrip << " " << segment.trips << " " << segment.written << "\n";
+    }
+    if(rename((dir + "/manifest.tmp").c_str(), (dir + "/" + MANIFEST).c_str()) != 0)
+        throw runtime_error("Failed to update manifest");
+}
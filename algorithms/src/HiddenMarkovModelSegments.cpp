@@ -0,0 +1,210 @@
+#include "HiddenMarkovModelSegments.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <list>
+#include <map>
+#include <set>
+
+#include "DUGraph.h"
+#include "HiddenMarkovModel.h"
+#include "Kosaraju.h"
+#include "utils.h"
+
+using namespace std;
+
+typedef std::vector<double> VF;
+typedef std::vector<VF> VVF;
+
+typedef DWGraph::node_t node_t;
+
+using hrc = std::chrono::high_resolution_clock;
+
+const double NANOS_TO_SECS = (1.0/1000000000.0);
+const double MILLIMS_TO_METERS = (1.0/1000.0);
+
+HiddenMarkovModelSegments::HiddenMarkovModelSegments(
+    ClosestSegmentsInRadius &closestSegmentsInRadius_,
+    ShortestPathFew &shortestPathFew_,
+    double d_, double sigma_z_, double beta_
+):
+    closestSegmentsInRadius(closestSegmentsInRadius_),
+    shortestPathFew(shortestPathFew_),
+    d(d_), sigma_z(sigma_z_), beta(beta_)
+{}
+
+void HiddenMarkovModelSegments::initialize(const MapGraph *mapGraph_){
+    mapGraph = mapGraph_;
+
+    cout << "Calculating SCC..." << endl;
+    distGraph = mapGraph->getDistanceGraph();
+    DUGraph duDistGraph = (DUGraph)distGraph;
+    Kosaraju kosaraju;
+    kosaraju.initialize(&duDistGraph);
+    kosaraju.run();
+    node_t root = kosaraju.get_scc(4523960191);
+    for(const node_t &u: duDistGraph.getNodes()){
+        if(kosaraju.get_scc(u) != root){
+            distGraph.removeNode(u);
+        }
+    }
+    cout << "Calculated SCC" << endl;
+
+    set<pair<node_t, node_t>> edgesSet;
+    for(const MapGraph::way_t &w: mapGraph->getWays()){
+        if(w.nodes.size() < 2) continue;
+        auto it1 = w.nodes.begin();
+        for(auto it2 = it1++; it1 != w.nodes.end(); ++it1, ++it2){
+            if(distGraph.hasNode(*it2) && distGraph.hasNode(*it1))
+                edgesSet.insert(make_pair(*it2, *it1));
+        }
+    }
+
+    edges = vector<pair<node_t, node_t>>(edgesSet.begin(), edgesSet.end());
+    lengths.resize(edges.size());
+    vector<ClosestSegmentsInRadius::segment_t> segments(edges.size());
+    for(size_t i = 0; i < edges.size(); ++i){
+        const Coord &a = mapGraph->nodeToCoord(edges[i].first);
+        const Coord &b = mapGraph->nodeToCoord(edges[i].second);
+        segments[i] = make_pair(a, b);
+        lengths[i] = Coord::getDistanceArc(a, b);
+    }
+    closestSegmentsInRadius.initialize(segments, d);
+}
+
+void HiddenMarkovModelSegments::run(){
+    closestSegmentsInRadius.run();
+    cout << "Idx\tID                \tR-tree (s)\tT\tK\tA* (s)   \tViterbi (s)\t" << endl;
+}
+
+HiddenMarkovModelSegments::MyA::MyA(double beta_, const vector<Coord> &Y_, const vector<size_t> &first_, const VVF &D_):
+beta(beta_), Y(Y_), first(first_), D(D_){}
+
+double HiddenMarkovModelSegments::MyA::operator()(long i, long j, long t) const {
+    const Coord &zt0 = Y.at(t-1);
+    const Coord &zt1 = Y.at(t);
+    double dArc = Coord::getDistanceArc(zt0, zt1);
+
+    const size_t n = first.at(t+1) - first.at(t);
+    const double &dRoute = D.at(t-1).at((i-first.at(t-1))*n + (j-first.at(t)));
+
+    double dt = fabs(dArc-dRoute);
+    return exp(-dt/beta)/beta;
+}
+
+vector<HiddenMarkovModelSegments::match_t> HiddenMarkovModelSegments::getMatchesOnEdges(const vector<Coord> &trip) const {
+    const vector<Coord> &Y = trip;
+    const size_t &T = Y.size();
+
+    hrc::time_point begin, end; double dt;
+
+    // ======== CANDIDATE STATES (R-TREE) ========
+    // States of step t are first[t], ..., first[t+1]-1
+    begin = hrc::now();
+    vector<ClosestSegmentsInRadius::result_t> states;
+    vector<size_t> first(T+1, 0);
+    for(size_t t = 0; t < T; ++t){
+        closestSegmentsInRadius.getClosestSegments(Y.at(t), states);
+        first[t+1] = states.size();
+        if(first[t+1] == first[t]) throw std::runtime_error("Location t=" + to_string(t) + " has no candidates");
+    }
+    const size_t K = states.size();
+
+    vector<Coord> S(K);
+    for(size_t i = 0; i < K; ++i) S[i] = states[i].projection;
+
+    end = hrc::now();
+    dt = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count())*NANOS_TO_SECS;
+    cout << dt << "\t" << T << "\t" << K << "\t";
+
+    // ======== DISTANCE MATRIX (A*) ========
+    // A route leaves edge (u1, v1) at v1 and enters edge (u2, v2) at u2,
+    // unless both states are on the same edge and the second is ahead.
+    begin = hrc::now();
+    vector<set<long>> candidateStates(T);
+    for(size_t i = first[0]; i < first[1]; ++i) candidateStates[0].insert(i);
+    VVF D(T > 0 ? T-1 : 0);
+    for(size_t t = 0; t+1 < T; ++t){
+        const size_t n = first[t+2] - first[t+1];
+        D[t] = VF((first[t+1]-first[t])*n, fINF);
+
+        set<node_t> targetsSet;
+        for(size_t j = first[t+1]; j < first[t+2]; ++j) targetsSet.insert(edges[states[j].idx].first);
+        list<node_t> targets(targetsSet.begin(), targetsSet.end());
+
+        map<node_t, list<size_t>> sources;
+        for(long i: candidateStates[t]) sources[edges[states[i].idx].second].push_back(i);
+
+        for(const auto &p: sources){
+            shortestPathFew.initialize(&distGraph, p.first, targets);
+            shortestPathFew.run();
+            for(const size_t &i: p.second){
+                const ClosestSegmentsInRadius::result_t &si = states[i];
+                for(size_t j = first[t+1]; j < first[t+2]; ++j){
+                    const ClosestSegmentsInRadius::result_t &sj = states[j];
+                    double &dRoute = D[t][(i-first[t])*n + (j-first[t+1])];
+                    if(si.idx == sj.idx && si.offset <= sj.offset){
+                        dRoute = sj.offset - si.offset;
+                    } else {
+                        DWGraph::weight_t w = shortestPathFew.getPathWeight(edges[sj.idx].first);
+                        if(w != iINF)
+                            dRoute = (lengths[si.idx] - si.offset) + double(w)*MILLIMS_TO_METERS + sj.offset;
+                    }
+                }
+            }
+        }
+
+        for(size_t j = first[t+1]; j < first[t+2]; ++j){
+            for(long i: candidateStates[t]){
+                if(D[t][(i-first[t])*n + (j-first[t+1])] < fINF){
+                    candidateStates[t+1].insert(j);
+                    break;
+                }
+            }
+        }
+    }
+    end = hrc::now();
+    dt = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count())*NANOS_TO_SECS;
+    cout << dt << "\t" << flush;
+
+    // ======== HIDDEN MARKOV MODEL (VITERBI) ========
+    HiddenMarkovModel::MyPi Pi(sigma_z, S, Y[0]);
+    MyA A(beta, Y, first, D);
+    HiddenMarkovModel::MyB B(sigma_z, S, Y);
+
+    begin = hrc::now();
+    ViterbiSparse viterbi;
+    viterbi.initialize(&Pi, &A, &B, candidateStates);
+    viterbi.run();
+
+    vector<long> v = viterbi.getLikeliestPath();
+    end = hrc::now();
+    dt = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count())*NANOS_TO_SECS;
+    cout << dt << "\t";
+
+    cout << endl;
+
+    // Final processing
+    assert(v.size() == Y.size());
+
+    vector<match_t> matches(v.size());
+    for(size_t t = 0; t < v.size(); ++t){
+        const ClosestSegmentsInRadius::result_t &s = states[v[t]];
+        matches[t] = match_t{edges[s.idx].first, edges[s.idx].second, s.offset, s.projection};
+    }
+    return matches;
+}
+
+vector<node_t> HiddenMarkovModelSegments::getMatches(const vector<Coord> &trip) const {
+    vector<match_t> matchesOnEdges = getMatchesOnEdges(trip);
+
+    vector<node_t> matches(matchesOnEdges.size());
+    for(size_t t = 0; t < matches.size(); ++t){
+        const match_t &m = matchesOnEdges[t];
+        const Coord &cu = mapGraph->nodeToCoord(m.u);
+        const Coord &cv = mapGraph->nodeToCoord(m.v);
+        matches[t] = (Coord::getDistanceArc(m.coord, cu) <= Coord::getDistanceArc(m.coord, cv) ? m.u : m.v);
+    }
+    return matches;
+}
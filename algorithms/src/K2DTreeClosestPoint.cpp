@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <bitset>
+#include <numeric>
 #include "utils.h"
 
 using namespace std;
@@ -14,15 +15,19 @@ K2DTreeClosestPoint::K2DTreeClosestPoint(){}
 
 void K2DTreeClosestPoint::initialize(const list<Vector2> &points){
     size_t N = utils::nextPow2(points.size());
+    v = vector<Vector2>(points.begin(), points.end());
+    ids.resize(N);
     c.resize(N);
     split.resize(N);
-    copy(points.begin(), points.end(), c.begin());
-    sort(c.begin(), c.begin() + points.size(), Vector2::compX);
-    fill(c.begin() + points.size(), c.end(), *(c.begin() + points.size() - 1));
+    iota(ids.begin(), ids.begin() + points.size(), 0);
+    sort(ids.begin(), ids.begin() + points.size(), [this](size_t i, size_t j){ return Vector2::compX(v[i], v[j]); });
+    fill(ids.begin() + points.size(), ids.end(), *(ids.begin() + points.size() - 1));
 }
 
 void K2DTreeClosestPoint::run(){
-    const size_t N = c.size();
+    const size_t N = ids.size();
+    auto compX = [this](size_t i, size_t j){ return Vector2::compX(v[i], v[j]); };
+    auto compY = [this](size_t i, size_t j){ return Vector2::compY(v[i], v[j]); };
     for(size_t i = 1; i < N; ++i){
         size_t level = size_bits(N) - size_bits(i);
         size_t prefix = i & (~(1uL << (size_bits(i) - 1)));
@@ -30,33 +35,41 @@ void K2DTreeClosestPoint::run(){
         size_t r = (prefix+1) << level;
         size_t m = l + (r-l)/2;
         bool xAxisActive = (level%2 == 1); // Active axis is X if level is odd
-        if(xAxisActive) nth_element(c.begin() + l, c.begin() + m, c.begin() + r, Vector2::compX);
-        else            nth_element(c.begin() + l, c.begin() + m, c.begin() + r, Vector2::compY);
+        if(xAxisActive) nth_element(ids.begin() + l, ids.begin() + m, ids.begin() + r, compX);
+        else            nth_element(ids.begin() + l, ids.begin() + m, ids.begin() + r, compY);
 
-        const Vector2 &medianCoord = c[m];
+        const Vector2 &medianCoord = v[ids[m]];
         const double &median = (xAxisActive ? medianCoord.x : medianCoord.y);
         split[i] = median;
     }
+
+    // Store leaves contiguously, so searching does not go through ids
+    for(size_t i = 0; i < N; ++i) c[i] = v[ids[i]];
 }
 
 Vector2 K2DTreeClosestPoint::getClosestPoint(const Vector2 p) const {
-    Vector2 cbest;
+    return v[getClosestPointIdx(p)];
+}
+
+size_t K2DTreeClosestPoint::getClosestPointIdx(const Vector2 p) const {
+    size_t ibest = 0;
     double dbest = fINF;
-    search(p, 1, cbest, dbest);
-    return cbest;
+    search(p, 1, ibest, dbest);
+    return ibest;
 }
 
-void K2DTreeClosestPoint::search(const Vector2 &p, size_t r, Vector2 &cbest, double &dbest) const {
+void K2DTreeClosestPoint::search(const Vector2 &p, size_t r, size_t &ibest, double &dbest) const {
     const size_t &N = c.size();
     size_t level = size_bits(N) - size_bits(r);
     bool xAxisActive = (level%2 == 1);
 
     if(level <= 0){
         // If bin only has 1 element
-        const Vector2 &candidate = c[r & ~(1uL << (size_bits(r)-1))];
+        size_t j = r & ~(1uL << (size_bits(r)-1));
+        const Vector2 &candidate = c[j];
         double d = p.getDistance(candidate);
         if(d < dbest){
-            cbest = candidate;
+            ibest = ids[j];
             dbest = d;
         }
     } else {
@@ -65,7 +78,7 @@ void K2DTreeClosestPoint::search(const Vector2 &p, size_t r, Vector2 &cbest, dou
         size_t i = (r << 1) + (v < median ? 0 : 1);
 
         // Search in the child where p should be
-        search(p, i, cbest, dbest);
+        search(p, i, ibest, dbest);
         
         Vector2 median_coord = (xAxisActive ?
             Vector2(median, p.y) :
@@ -77,7 +90,7 @@ void K2DTreeClosestPoint::search(const Vector2 &p, size_t r, Vector2 &cbest, dou
         // if(fabs(v-median) < dbest){
             // The brother of current tree node i is i^1, because we just flip
             // the least significant bit
-            search(p, i^1, cbest, dbest);
+            search(p, i^1, ibest, dbest);
         }
     }
 }
@@ -30,9 +30,12 @@ void MapMatching::FromClosestPoint::initialize(
     }
     cout << "Calculated SCC" << endl;
 
-    auto nodes = distGraph.getNodes();
+    nodes.clear();
     list<Vector2> l;
-    for(const node_t &u: nodes) l.push_back(mapGraph->nodeToCoord(u));
+    for(const node_t &u: distGraph.getNodes()){
+        nodes.push_back(u);
+        l.push_back(mapGraph->nodeToCoord(u));
+    }
 
     closestPoint = closestPointFactory.factoryMethod();
     closestPoint->initialize(l);
@@ -46,10 +49,13 @@ void MapMatching::FromClosestPoint::run(){
 vector<node_t> MapMatching::FromClosestPoint::getMatches(
     const vector<Coord> &trip_
 ) const {
+    vector<Vector2> queries(trip_.begin(), trip_.end());
+    vector<size_t> idxs;
+    closestPoint->getClosestPointMany(queries, idxs);
+
     vector<node_t> ret(trip_.size());
     for(size_t i = 0; i < trip_.size(); ++i){
-        ret[i] = mapGraph->coordToNode(Coord(closestPoint->getClosestPoint(trip_[i])));
+        ret[i] = nodes[idxs[i]];
     }
-    cout << endl;
     return ret;
 }
@@ -0,0 +1,146 @@
+#include "SegmentRTree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+using namespace std;
+
+void SegmentRTree::box_t::add(const box_t &b){
+    xMin = min(xMin, b.xMin); yMin = min(yMin, b.yMin);
+    xMax = max(xMax, b.xMax); yMax = max(yMax, b.yMax);
+}
+
+bool SegmentRTree::box_t::intersects(const box_t &b) const {
+    return xMin <= b.xMax && b.xMin <= xMax &&
+           yMin <= b.yMax && b.yMin <= yMax;
+}
+
+SegmentRTree::box_t SegmentRTree::getBox(const segment_t &s){
+    return box_t{
+        min(s.first.x, s.second.x), min(s.first.y, s.second.y),
+        max(s.first.x, s.second.x), max(s.first.y, s.second.y)
+    };
+}
+
+SegmentRTree::SegmentRTree(size_t B_): B(B_){}
+
+void SegmentRTree::initialize(const vector<segment_t> &segments_, double d_){
+    segments = segments_;
+    d = d_;
+    ids.clear();
+    lengths.clear();
+    tree.clear();
+}
+
+/**
+ * Sort boxes by x-center, cut them into sqrt(N/B) vertical slices and sort
+ * each slice by y-center, so that consecutive groups of B boxes are close
+ * together. Slices have a multiple of B boxes, so groups never span two
+ * slices.
+ */
+vector<size_t> SegmentRTree::sortTileRecursive(const vector<box_t> &boxes, size_t B){
+    const size_t N = boxes.size();
+    vector<size_t> order(N);
+    iota(order.begin(), order.end(), 0);
+
+    sort(order.begin(), order.end(), [&boxes](size_t i, size_t j){
+        return boxes[i].xMin+boxes[i].xMax < boxes[j].xMin+boxes[j].xMax;
+    });
+
+    size_t nGroups = (N+B-1)/B;
+    size_t nSlices = size_t(ceil(sqrt(double(nGroups))));
+    size_t sliceSize = ((nGroups+nSlices-1)/nSlices)*B;
+    for(size_t l = 0; l < N; l += sliceSize){
+        size_t r = min(N, l+sliceSize);
+        sort(order.begin()+l, order.begin()+r, [&boxes](size_t i, size_t j){
+            return boxes[i].yMin+boxes[i].yMax < boxes[j].yMin+boxes[j].yMax;
+        });
+    }
+    return order;
+}
+
+void SegmentRTree::run(){
+    const size_t N = segments.size();
+
+    // Leaves
+    vector<box_t> boxes(N);
+    for(size_t i = 0; i < N; ++i) boxes[i] = getBox(segments[i]);
+    ids = sortTileRecursive(boxes, B);
+
+    vector<segment_t> segmentsSorted(N);
+    lengths.resize(N);
+    for(size_t k = 0; k < N; ++k){
+        segmentsSorted[k] = segments[ids[k]];
+        lengths[k] = Coord::getDistanceArc(segmentsSorted[k].first, segmentsSorted[k].second);
+    }
+    segments = move(segmentsSorted);
+
+    vector<tree_node_t> level;
+    for(size_t l = 0; l < N; l += B){
+        tree_node_t u{boxes[ids[l]], l, min(B, N-l), true};
+        for(size_t k = l+1; k < l+u.count; ++k) u.box.add(boxes[ids[k]]);
+        level.push_back(u);
+    }
+
+    // Internal nodes; each level is appended to the tree in packing order,
+    // so the children of each parent are consecutive
+    while(level.size() > 1){
+        vector<box_t> levelBoxes(level.size());
+        for(size_t i = 0; i < level.size(); ++i) levelBoxes[i] = level[i].box;
+        vector<size_t> order = sortTileRecursive(levelBoxes, B);
+
+        const size_t base = tree.size();
+        for(const size_t &i: order) tree.push_back(level[i]);
+
+        vector<tree_node_t> parents;
+        for(size_t l = 0; l < order.size(); l += B){
+            tree_node_t u{tree[base+l].box, base+l, min(B, order.size()-l), false};
+            for(size_t k = l+1; k < l+u.count; ++k) u.box.add(tree[base+k].box);
+            parents.push_back(u);
+        }
+        level = move(parents);
+    }
+
+    if(level.empty()) level.push_back(tree_node_t{box_t{0, 0, 0, 0}, 0, 0, true});
+    tree.push_back(level[0]);
+    root = tree.size()-1;
+}
+
+void SegmentRTree::getClosestSegments(Coord p, vector<result_t> &res) const {
+    const double dLon = d*Coord::MetersToLonDegrees();
+    const double dLat = d*Coord::MetersToLatDegrees();
+    const box_t q{p.x-dLon, p.y-dLat, p.x+dLon, p.y+dLat};
+
+    const double kx = Coord::LonDegreesToMeters();
+    const double ky = Coord::LatDegreesToMeters();
+
+    vector<size_t> stack = {root};
+    while(!stack.empty()){
+        const tree_node_t &u = tree[stack.back()]; stack.pop_back();
+        if(!u.box.intersects(q)) continue;
+
+        if(!u.leaf){
+            for(size_t k = u.first; k < u.first+u.count; ++k) stack.push_back(k);
+            continue;
+        }
+
+        for(size_t k = u.first; k < u.first+u.count; ++k){
+            const Coord &a = segments[k].first;
+            const Coord &b = segments[k].second;
+
+            // Project in a local planar approximation, in metres
+            double abx = (b.x-a.x)*kx, aby = (b.y-a.y)*ky;
+            double apx = (p.x-a.x)*kx, apy = (p.y-a.y)*ky;
+            double ab2 = abx*abx + aby*aby;
+            double t = (ab2 > 0.0 ? (apx*abx + apy*aby)/ab2 : 0.0);
+            t = max(0.0, min(1.0, t));
+
+            Coord proj = a + (b-a)*t;
+            double dist = Coord::getDistanceArcSimple(p, proj);
+            if(dist < d){
+                res.push_back(result_t{ids[k], proj, t*lengths[k], dist});
+            }
+        }
+    }
+}
@@ -1,6 +1,9 @@
 #include "ShortestPathAll.h"
 
 #include <chrono>
+#include <functional>
+#include <stdexcept>
+#include "DijkstraFew.h"
 #include "utils.h"
 
 #include <iostream>
@@ -21,6 +24,11 @@ std::list<node_t> ShortestPathAll::getPath(node_t s, node_t d) const{
     return res;
 }
 
+void ShortestPathAll::getPathWeights(node_t s, const std::vector<node_t> &d, std::vector<weight_t> &res) const{
+    res.resize(d.size());
+    for(size_t i = 0; i < d.size(); ++i) res[i] = getPathWeight(s, d[i]);
+}
+
 ShortestPathAll::FromOneMany::FromOneMany(ShortestPathOneManyFactory &oneManyFactory_, size_t nthreads_):
     oneManyFactory(oneManyFactory_), nthreads(nthreads_)
 {}
@@ -75,3 +83,116 @@ node_t ShortestPathAll::FromOneMany::getPrev(node_t, node_t) const{
 weight_t ShortestPathAll::FromOneMany::getPathWeight(node_t s, node_t d) const{
     return dist.at(s).at(d);
 }
+
+// Ring slot, index entry with its node and bucket pointers
+const size_t ShortestPathAll::Cache::ENTRY_BYTES = sizeof(entry_t) + sizeof(key_t) + 4*sizeof(size_t);
+
+size_t ShortestPathAll::Cache::keyHash::operator()(const key_t &k) const {
+    return std::hash<node_t>()(k.first) * 0x9E3779B97F4A7C15ULL ^ std::hash<node_t>()(k.second);
+}
+
+ShortestPathAll::Cache::Cache(weight_t dMax_, size_t maxBytes):
+    dMax(dMax_),
+    shardCapacity(std::max(size_t(1), maxBytes/NUM_SHARDS/ENTRY_BYTES)),
+    shards(NUM_SHARDS),
+    hits(0), misses(0), searches(0), evictions(0)
+{}
+
+void ShortestPathAll::Cache::initialize(const DWGraph::DWGraph *G_){
+    if(G_ == G) return;
+    G = G_;
+    for(shard_t &shard: shards){
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.index.clear();
+        shard.ring.clear();
+        shard.hand = 0;
+    }
+}
+
+void ShortestPathAll::Cache::run(){}
+
+ShortestPathAll::Cache::shard_t &ShortestPathAll::Cache::getShard(const key_t &key) const {
+    return shards[keyHash()(key) % NUM_SHARDS];
+}
+
+bool ShortestPathAll::Cache::find(const key_t &key, weight_t &w) const {
+    shard_t &shard = getShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if(it == shard.index.end()) return false;
+    entry_t &e = shard.ring[it->second];
+    e.referenced = true;
+    w = e.w;
+    return true;
+}
+
+void ShortestPathAll::Cache::insert(const key_t &key, weight_t w) const {
+    shard_t &shard = getShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if(shard.index.count(key)) return;
+
+    if(shard.ring.size() < shardCapacity){
+        shard.index.emplace(key, shard.ring.size());
+        shard.ring.push_back(entry_t{key, w, false});
+        return;
+    }
+
+    // Second chance: skip and clear referenced entries
+    while(shard.ring[shard.hand].referenced){
+        shard.ring[shard.hand].referenced = false;
+        shard.hand = (shard.hand+1) % shard.ring.size();
+    }
+    entry_t &e = shard.ring[shard.hand];
+    shard.index.erase(e.key);
+    e = entry_t{key, w, false};
+    shard.index.emplace(key, shard.hand);
+    shard.hand = (shard.hand+1) % shard.ring.size();
+    ++evictions;
+}
+
+node_t ShortestPathAll::Cache::getPrev(node_t, node_t) const{
+    throw std::logic_error("ShortestPathAll::Cache::getPrev is not implemented");
+}
+
+weight_t ShortestPathAll::Cache::getPathWeight(node_t s, node_t d) const{
+    std::vector<weight_t> res;
+    getPathWeights(s, std::vector<node_t>(1, d), res);
+    return res[0];
+}
+
+void ShortestPathAll::Cache::getPathWeights(node_t s, const std::vector<node_t> &d, std::vector<weight_t> &res) const{
+    res.resize(d.size());
+
+    std::list<node_t> missing;
+    std::vector<size_t> missingIdx;
+    for(size_t i = 0; i < d.size(); ++i){
+        if(d[i] == s) res[i] = 0;
+        else if(!find(key_t(s, d[i]), res[i])){
+            missing.push_back(d[i]);
+            missingIdx.push_back(i);
+        }
+    }
+    hits += d.size() - missingIdx.size();
+    misses += missingIdx.size();
+    if(missing.empty()) return;
+
+    DijkstraFew dijkstra(dMax);
+    dijkstra.initialize(G, s, missing);
+    dijkstra.run();
+    ++searches;
+    for(const size_t &i: missingIdx){
+        weight_t w = dijkstra.getPathWeight(d[i]);
+        if(w > dMax) w = iINF;
+        res[i] = w;
+        insert(key_t(s, d[i]), w);
+    }
+}
+
+ShortestPathAll::Cache::stats_t ShortestPathAll::Cache::getStats() const {
+    return stats_t{hits, misses, searches, evictions};
+}
+
+void ShortestPathAll::Cache::resetStats(){
+    hits = 0; misses = 0;
+    searches = 0; evictions = 0;
+}
@@ -5,6 +5,10 @@ typedef DWGraph::weight_t   weight_t;
 
 ShortestPathFew::~ShortestPathFew(){}
 
+void ShortestPathFew::initialize(const DWGraph::DWGraph *G, node_t s, std::list<node_t> d, weight_t){
+    initialize(G, s, d);
+}
+
 std::list<node_t> ShortestPathFew::getPath(node_t u) const{
     std::list<node_t> res;
     node_t d = u;
@@ -20,13 +24,20 @@ ShortestPathFew::FromAll::FromAll(ShortestPathAll &shortestPathAll_):
 shortestPathAll(shortestPathAll_)
 {}
 
-void ShortestPathFew::FromAll::initialize(const DWGraph::DWGraph *G, DWGraph::node_t s_, std::list<DWGraph::node_t> d){
+void ShortestPathFew::FromAll::initialize(const DWGraph::DWGraph *G, DWGraph::node_t s_, std::list<DWGraph::node_t> d_){
     shortestPathAll.initialize(G);
     s = s_;
+    d = std::vector<node_t>(d_.begin(), d_.end());
+    dist.clear();
 }
 
 void ShortestPathFew::FromAll::run(){
     shortestPathAll.run();
+
+    // Ask for all destinations at once
+    std::vector<weight_t> w;
+    shortestPathAll.getPathWeights(s, d, w);
+    for(size_t i = 0; i < d.size(); ++i) dist[d[i]] = w[i];
 }
 
 DWGraph::node_t ShortestPathFew::FromAll::getStart() const{
@@ -41,8 +52,10 @@ DWGraph::node_t ShortestPathFew::FromAll::getPrev(DWGraph::node_t d) const{
     return shortestPathAll.getPrev(s, d);
 }
 
-DWGraph::weight_t ShortestPathFew::FromAll::getPathWeight(DWGraph::node_t d) const{
-    return shortestPathAll.getPathWeight(s, d);
+DWGraph::weight_t ShortestPathFew::FromAll::getPathWeight(DWGraph::node_t u) const{
+    auto it = dist.find(u);
+    if(it != dist.end()) return it->second;
+    return shortestPathAll.getPathWeight(s, u);
 }
 
 bool ShortestPathFew::FromAll::hasVisited(DWGraph::node_t u) const{
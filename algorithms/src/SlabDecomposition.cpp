@@ -5,24 +5,18 @@
 
 using namespace std;
 
-void SlabDecomposition::initialize(const std::list<Edge> &es){
-    edges.clear();
-    auto it = es.begin();
-    while(it != es.end()) edges.push_back(&*(it++));
+void SlabDecomposition::initialize(const VoronoiDiagram &diagram){
+    edges = diagram.getEdges();
+    sites = diagram.sites;
+    events.clear();
+    slabs.clear();
 }
 
-struct cmp_t {
-    double x;
-    bool operator()(const Edge *lhs, const Edge *rhs) const {
-        return lhs->evaluateY(x) < rhs->evaluateY(x);
-    }
-};
-
 void SlabDecomposition::run(){
     // map<double, list<Event>> events;
-    for(const Edge *e: edges){
-        double xl = e->start.x;
-        double xr = e->end.x;
+    for(Voronoi::idx_t e = 0; e < edges.size(); ++e){
+        double xl = edges[e].start.x;
+        double xr = edges[e].end.x;
         if(xl == xr) continue;
         if(xl > xr) swap(xl, xr);
 
@@ -31,7 +25,7 @@ void SlabDecomposition::run(){
     }
 
     // map<double, set<const Edge*, cmp_t>> slabs;
-    set<const Edge*, cmp_t> prev;
+    set<Voronoi::idx_t, cmp_t> prev(cmp_t{&edges, 0});
 
     auto it1 = events.begin(),
          it2 = ++events.begin();
@@ -40,14 +34,17 @@ void SlabDecomposition::run(){
               xr = it2->first;
         double xm = xl + (xr-xl)/2.0;
 
-        set<const Edge*, cmp_t> cur = set<const Edge*, cmp_t>({xm});
+        // Edges ending at xl do not span this slab, so they are removed
+        // using the order of the slab they leave
+        for(const Event &ev: it1->second) if(!ev.start) prev.erase(ev.e);
+
+        set<Voronoi::idx_t, cmp_t> cur = set<Voronoi::idx_t, cmp_t>(cmp_t{&edges, xm});
         cur.insert(prev.begin(), prev.end());
 
-        for(const Event &ev: it1->second) if(!ev.start) cur.erase(ev.e);
         for(const Event &ev: it1->second) if(ev.start) cur.insert(ev.e);
 
-        auto &slab = slabs[xl] = vector<const Edge*>(cur.begin(), cur.end());
-        sort(slab.begin(), slab.end(), cmp_t{xm});
+        auto &slab = slabs[xl] = vector<Voronoi::idx_t>(cur.begin(), cur.end());
+        sort(slab.begin(), slab.end(), cmp_t{&edges, xm});
 
         ++it1; ++it2; prev = cur;
     }
@@ -60,14 +57,17 @@ Vector2 SlabDecomposition::getClosestPoint(Vector2 p) const {
     --it1;
 
     double x = p.x;
-    auto slab = it1->second;
-    auto it2 = lower_bound(slab.begin(), slab.end(), p.y, [x](const Edge *e, double y){
-        return e->evaluateY(x) < y;
+    const auto &slab = it1->second;
+    auto it2 = lower_bound(slab.begin(), slab.end(), p.y, [this, x](Voronoi::idx_t e, double y){
+        return edges[e].evaluateY(x) < y;
     });
-    if(it2 == slab.end()) throw runtime_error("y-coordinate too high");
+    if(it2 != slab.end() && edges[*it2].site_down != Voronoi::INVALID_IDX)
+        return sites[edges[*it2].site_down].point;
 
-    const Edge *eRet = *it2;
-    if(eRet->site_down == nullptr) throw runtime_error("y-coordinate too low");
+    // Above the topmost edge between two sites the next edge is the bounding
+    // box, so p is in the region above the edge below it
+    if(it2 == slab.begin() || edges[*prev(it2)].site_up == Voronoi::INVALID_IDX)
+        throw runtime_error(it2 == slab.end() ? "y-coordinate too high" : "y-coordinate too low");
 
-    return eRet->site_down->point;
+    return sites[edges[*prev(it2)].site_up].point;
 }
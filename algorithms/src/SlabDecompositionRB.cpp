@@ -5,24 +5,18 @@
 
 using namespace std;
 
-void SlabDecompositionRB::initialize(const std::list<Edge> &es){
-    edges.clear();
-    auto it = es.begin();
-    while(it != es.end()) edges.push_back(&*(it++));
+void SlabDecompositionRB::initialize(const VoronoiDiagram &diagram){
+    edges = diagram.getEdges();
+    sites = diagram.sites;
+    events.clear();
+    slabs.clear();
 }
 
-struct cmp_t {
-    double x;
-    bool operator()(const Edge *lhs, const Edge *rhs) const {
-        return lhs->evaluateY(x) < rhs->evaluateY(x);
-    }
-};
-
 void SlabDecompositionRB::run(){
     // map<double, list<Event>> events;
-    for(const Edge *e: edges){
-        double xl = e->start.x;
-        double xr = e->end.x;
+    for(Voronoi::idx_t e = 0; e < edges.size(); ++e){
+        double xl = edges[e].start.x;
+        double xr = edges[e].end.x;
         if(xl == xr) continue;
         if(xl > xr) swap(xl, xr);
 
@@ -31,7 +25,11 @@ void SlabDecompositionRB::run(){
     }
 
     // map<double, set<const Edge*, cmp_t>> slabs;
-    RBTree<const Edge*> prev;
+    RBTree<Voronoi::idx_t> prev;
+
+    // Edges ending at xl do not span the slab starting there, so they are
+    // removed using the order of the slab they leave
+    double xmPrev = 0;
 
     auto it1 = events.begin(),
          it2 = ++events.begin();
@@ -40,11 +38,11 @@ void SlabDecompositionRB::run(){
               xr = it2->first;
         double xm = xl + (xr-xl)/2.0;
 
-        RBTree<const Edge*> &cur = slabs[xl] = prev;
-        for(const Event &ev: it1->second) if(!ev.start) cur = cur.remove(ev.e, cmp_t{xm});
-        for(const Event &ev: it1->second) if( ev.start) cur = cur.insert(ev.e, cmp_t{xm});
+        RBTree<Voronoi::idx_t> &cur = slabs[xl] = prev;
+        for(const Event &ev: it1->second) if(!ev.start) cur = cur.remove(ev.e, cmp_t{&edges, xmPrev});
+        for(const Event &ev: it1->second) if( ev.start) cur = cur.insert(ev.e, cmp_t{&edges, xm});
 
-        ++it1; ++it2; prev = cur;
+        ++it1; ++it2; prev = cur; xmPrev = xm;
     }
 
 }
@@ -55,14 +53,19 @@ Vector2 SlabDecompositionRB::getClosestPoint(Vector2 p) const {
     --it1;
 
     double x = p.x;
-    auto slab = it1->second;
-    auto it2 = slab.lower_bound(p.y, [x](const Edge *e, double y){
-        return e->evaluateY(x) < y;
-    });
-    if(it2 == nullptr) throw runtime_error("y-coordinate too high");
+    const auto &slab = it1->second;
+    auto below = [this, x](Voronoi::idx_t e, double y){
+        return edges[e].evaluateY(x) < y;
+    };
+    auto it2 = slab.lower_bound(p.y, below);
+    if(it2 != nullptr && edges[*it2].site_down != Voronoi::INVALID_IDX)
+        return sites[edges[*it2].site_down].point;
 
-    const Edge *eRet = *it2;
-    if(eRet->site_down == nullptr) throw runtime_error("y-coordinate too low");
+    // Above the topmost edge between two sites the next edge is the bounding
+    // box, so p is in the region above the edge below it
+    auto it3 = slab.predecessor(p.y, below);
+    if(it3 == nullptr || edges[*it3].site_up == Voronoi::INVALID_IDX)
+        throw runtime_error(it2 == nullptr ? "y-coordinate too high" : "y-coordinate too low");
 
-    return eRet->site_down->point;
+    return sites[edges[*it3].site_up].point;
 }
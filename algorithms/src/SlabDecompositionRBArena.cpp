@@ -0,0 +1,74 @@
+#include "SlabDecompositionRBArena.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+void SlabDecompositionRBArena::initialize(const VoronoiDiagram &diagram){
+    edges = diagram.getEdges();
+    sites = diagram.sites;
+    events.clear();
+    slabs.clear();
+    arena.clear();
+}
+
+void SlabDecompositionRBArena::run(){
+    for(Voronoi::idx_t e = 0; e < edges.size(); ++e){
+        double xl = edges[e].start.x;
+        double xr = edges[e].end.x;
+        if(xl == xr) continue;
+        if(xl > xr) swap(xl, xr);
+
+        events[xl].push_back({true , e});
+        events[xr].push_back({false, e});
+    }
+
+    RBTreeArena<Voronoi::idx_t> prev(arena);
+
+    // Edges ending at xl do not span the slab starting there, so they are
+    // removed using the order of the slab they leave
+    double xmPrev = 0;
+
+    auto it1 = events.begin(),
+         it2 = ++events.begin();
+    while(it2 != events.end()){
+        double xl = it1->first,
+              xr = it2->first;
+        double xm = xl + (xr-xl)/2.0;
+
+        RBTreeArena<Voronoi::idx_t> cur = prev;
+        for(const Event &ev: it1->second) if(!ev.start) cur = cur.remove(ev.e, cmp_t{&edges, xmPrev});
+        for(const Event &ev: it1->second) if( ev.start) cur = cur.insert(ev.e, cmp_t{&edges, xm});
+        slabs.emplace_hint(slabs.end(), xl, cur);
+
+        ++it1; ++it2; prev = cur; xmPrev = xm;
+    }
+}
+
+Vector2 SlabDecompositionRBArena::getClosestPoint(Vector2 p) const {
+    auto it1 = slabs.lower_bound(p.x);
+    if(it1 == slabs.begin()) throw runtime_error("x-coordinate too low");
+    --it1;
+
+    double x = p.x;
+    const auto &slab = it1->second;
+    auto below = [this, x](Voronoi::idx_t e, double y){
+        return edges[e].evaluateY(x) < y;
+    };
+    auto it2 = slab.lower_bound(p.y, below);
+    if(it2 != nullptr && edges[*it2].site_down != Voronoi::INVALID_IDX)
+        return sites[edges[*it2].site_down].point;
+
+    // Above the topmost edge between two sites the next edge is the bounding
+    // box, so p is in the region above the edge below it
+    auto it3 = slab.predecessor(p.y, below);
+    if(it3 == nullptr || edges[*it3].site_up == Voronoi::INVALID_IDX)
+        throw runtime_error(it2 == nullptr ? "y-coordinate too high" : "y-coordinate too low");
+
+    return sites[edges[*it3].site_up].point;
+}
+
+size_t SlabDecompositionRBArena::getTreeMemoryUsage() const {
+    return arena.getMemoryUsage();
+}
@@ -0,0 +1,355 @@
+#include "TrapezoidalMap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace std;
+
+using Voronoi::idx_t;
+using Voronoi::INVALID_IDX;
+
+namespace {
+bool samePoint(Vector2 a, Vector2 b){
+    return a.x == b.x && a.y == b.y;
+}
+}
+
+double TrapezoidalMap::orientation(const Segment &s, Vector2 r){
+    return (s.q.x - s.p.x)*(r.y - s.p.y) - (s.q.y - s.p.y)*(r.x - s.p.x);
+}
+
+bool TrapezoidalMap::isAbove(idx_t s, Vector2 r) const {
+    return orientation(segments[s], r) > 0;
+}
+
+idx_t TrapezoidalMap::newTrapezoid(idx_t top, idx_t bottom, Vector2 leftp, Vector2 rightp){
+    Trapezoid t;
+    t.top = top; t.bottom = bottom;
+    t.leftp = leftp; t.rightp = rightp;
+    trapezoids.push_back(t);
+    return idx_t(trapezoids.size() - 1);
+}
+
+idx_t TrapezoidalMap::leafOf(idx_t t){
+    if(trapezoids[t].node == INVALID_IDX){
+        nodes.push_back(Node{Node::LEAF, t, INVALID_IDX, INVALID_IDX, Vector2()});
+        trapezoids[t].node = idx_t(nodes.size() - 1);
+    }
+    return trapezoids[t].node;
+}
+
+void TrapezoidalMap::initialize(const VoronoiDiagram &diagram){
+    sites = diagram.sites;
+    segments.clear();
+    trapezoids.clear();
+    nodes.clear();
+    root = INVALID_IDX;
+
+    const vector<Edge> &edges = diagram.getEdges();
+
+    double xmin = +numeric_limits<double>::infinity(), xmax = -numeric_limits<double>::infinity(),
+           ymin = +numeric_limits<double>::infinity(), ymax = -numeric_limits<double>::infinity();
+    for(const Edge &e: edges){
+        for(const Vector2 &v: {e.start, e.end}){
+            xmin = min(xmin, v.x); xmax = max(xmax, v.x);
+            ymin = min(ymin, v.y); ymax = max(ymax, v.y);
+        }
+    }
+
+    // Vertices of degenerate diagrams (e.g. four cocircular sites) may be
+    // computed more than once, differing in the last bits, and the tiny
+    // edges between them cross their neighbours. Snap endpoints closer
+    // than eps together, so that edges meeting there share an endpoint.
+    const double eps = 1e-9 * max({xmax-xmin, ymax-ymin, 1e-300});
+    unordered_map<uint64_t, Vector2> cells;
+    auto cellKey = [](int64_t cx, int64_t cy){
+        return uint64_t(cx) * 0x9E3779B97F4A7C15ull ^ uint64_t(cy);
+    };
+    auto snap = [&](Vector2 v){
+        const int64_t cx = int64_t(floor(v.x/eps)),
+                      cy = int64_t(floor(v.y/eps));
+        for(int64_t dx = -1; dx <= 1; ++dx){
+            for(int64_t dy = -1; dy <= 1; ++dy){
+                auto it = cells.find(cellKey(cx+dx, cy+dy));
+                if(it != cells.end() && fabs(it->second.x - v.x) < eps && fabs(it->second.y - v.y) < eps)
+                    return it->second;
+            }
+        }
+        cells.emplace(cellKey(cx, cy), v);
+        return v;
+    };
+
+    for(const Edge &e: edges){
+        if(e.site_up == INVALID_IDX && e.site_down == INVALID_IDX) continue;
+
+        Segment s{snap(e.start), snap(e.end), e.site_up, e.site_down};
+        if(samePoint(s.p, s.q)) continue;
+        if(Vector2::compXY(s.q, s.p)) swap(s.p, s.q);
+        segments.push_back(s);
+    }
+
+    // Degenerate diagrams may have the same edge more than once
+    sort(segments.begin(), segments.end(), [](const Segment &a, const Segment &b){
+        if(!samePoint(a.p, b.p)) return Vector2::compXY(a.p, b.p);
+        return Vector2::compXY(a.q, b.q);
+    });
+    segments.erase(unique(segments.begin(), segments.end(), [](const Segment &a, const Segment &b){
+        return samePoint(a.p, b.p) && samePoint(a.q, b.q);
+    }), segments.end());
+}
+
+void TrapezoidalMap::run(){
+    const idx_t n = idx_t(segments.size());
+
+    // Insertion order is what makes the expected bounds hold
+    shuffle(segments.begin(), segments.end(), mt19937(1));
+
+    double xmin = -1, xmax = +1, ymin = -1, ymax = +1;
+    if(n > 0){
+        xmin = xmax = segments[0].p.x;
+        ymin = ymax = segments[0].p.y;
+        for(const Segment &s: segments){
+            xmin = min(xmin, s.p.x); xmax = max(xmax, s.q.x);
+            ymin = min(ymin, min(s.p.y, s.q.y));
+            ymax = max(ymax, max(s.p.y, s.q.y));
+        }
+    }
+    const double margin = max(1.0, max(xmax-xmin, ymax-ymin));
+    xmin -= margin; xmax += margin;
+    ymin -= margin; ymax += margin;
+
+    // Frame, with no sites on either side
+    segments.push_back(Segment{Vector2(xmin, ymax), Vector2(xmax, ymax), INVALID_IDX, INVALID_IDX});
+    segments.push_back(Segment{Vector2(xmin, ymin), Vector2(xmax, ymin), INVALID_IDX, INVALID_IDX});
+
+    trapezoids.reserve(6*size_t(n) + 1);
+    nodes.reserve(7*size_t(n) + 1);
+
+    idx_t t = newTrapezoid(n, n+1, Vector2(xmin, ymin), Vector2(xmax, ymax));
+    root = leafOf(t);
+
+    for(idx_t s = 0; s < n; ++s)
+        insertSegment(s);
+
+    crossed.clear(); crossed.shrink_to_fit();
+    upper  .clear(); upper  .shrink_to_fit();
+    lower  .clear(); lower  .shrink_to_fit();
+
+    compact();
+}
+
+idx_t TrapezoidalMap::locate(Vector2 p) const {
+    idx_t u = root;
+    while(nodes[u].type != Node::LEAF){
+        const Node &node = nodes[u];
+        if(node.type == Node::X) u = (Vector2::compXY(p, node.point) ? node.left : node.right);
+        else                     u = (isAbove(node.i, p)             ? node.left : node.right);
+    }
+    return nodes[u].i;
+}
+
+idx_t TrapezoidalMap::locateSegment(const Segment &s) const {
+    idx_t u = root;
+    while(nodes[u].type != Node::LEAF){
+        const Node &node = nodes[u];
+        if(node.type == Node::X){
+            u = (Vector2::compXY(s.p, node.point) ? node.left : node.right);
+        } else {
+            // If s starts on this segment they share the left endpoint; compare slopes
+            double o = orientation(segments[node.i], s.p);
+            if(o == 0) o = orientation(segments[node.i], s.q);
+            u = (o > 0 ? node.left : node.right);
+        }
+    }
+    return nodes[u].i;
+}
+
+void TrapezoidalMap::insertSegment(idx_t s){
+    const Segment seg = segments[s];
+
+    // Trapezoids crossed by s, from left to right
+    crossed.clear();
+    crossed.push_back(locateSegment(seg));
+    while(Vector2::compXY(trapezoids[crossed.back()].rightp, seg.q)){
+        const Trapezoid &t = trapezoids[crossed.back()];
+        idx_t next = (isAbove(s, t.rightp) ? t.lower_right : t.upper_right);
+        if(next == INVALID_IDX) throw runtime_error("edges of the Voronoi diagram intersect");
+        crossed.push_back(next);
+    }
+    const size_t k = crossed.size() - 1;
+
+    const Trapezoid first = trapezoids[crossed[0]];
+    const Trapezoid last  = trapezoids[crossed[k]];
+
+    // Parts left of p and right of q, unless p or q are already in the map
+    idx_t A = INVALID_IDX, D = INVALID_IDX;
+    if(!samePoint(first.leftp, seg.p)){
+        A = newTrapezoid(first.top, first.bottom, first.leftp, seg.p);
+        trapezoids[A].upper_left = first.upper_left;
+        trapezoids[A].lower_left = first.lower_left;
+        if(first.upper_left != INVALID_IDX) trapezoids[first.upper_left].upper_right = A;
+        if(first.lower_left != INVALID_IDX) trapezoids[first.lower_left].lower_right = A;
+    }
+    if(!samePoint(last.rightp, seg.q)){
+        D = newTrapezoid(last.top, last.bottom, seg.q, last.rightp);
+        trapezoids[D].upper_right = last.upper_right;
+        trapezoids[D].lower_right = last.lower_right;
+        if(last.upper_right != INVALID_IDX) trapezoids[last.upper_right].upper_left = D;
+        if(last.lower_right != INVALID_IDX) trapezoids[last.lower_right].lower_left = D;
+    }
+
+    // Split crossed trapezoids by s. Walls through points above s still
+    // separate the parts above s, but the parts below s merge, and
+    // conversely for points below s.
+    upper.assign(k+1, INVALID_IDX);
+    lower.assign(k+1, INVALID_IDX);
+    for(size_t j = 0; j <= k; ++j){
+        const Trapezoid t = trapezoids[crossed[j]];
+        const bool wallLeftAbove  = (j > 0 && isAbove(s, t.leftp));
+        const bool wallRightAbove = (j < k && isAbove(s, t.rightp));
+
+        // Part above s
+        if(j == 0 || wallLeftAbove){
+            idx_t u = upper[j] = newTrapezoid(t.top, s, (j == 0 ? seg.p : t.leftp), seg.q);
+            if(j == 0 && A != INVALID_IDX){
+                trapezoids[u].upper_left = A;
+                trapezoids[A].upper_right = u;
+            } else {
+                if(j > 0){
+                    trapezoids[u].lower_left = upper[j-1];
+                    trapezoids[upper[j-1]].lower_right = u;
+                }
+                trapezoids[u].upper_left = t.upper_left;
+                if(t.upper_left != INVALID_IDX) trapezoids[t.upper_left].upper_right = u;
+            }
+        } else upper[j] = upper[j-1];
+
+        if(j == k || wallRightAbove){
+            idx_t u = upper[j];
+            if(j == k && D != INVALID_IDX){
+                trapezoids[u].upper_right = D;
+                trapezoids[D].upper_left = u;
+            } else {
+                trapezoids[u].rightp = (j == k ? seg.q : t.rightp);
+                trapezoids[u].upper_right = t.upper_right;
+                if(t.upper_right != INVALID_IDX) trapezoids[t.upper_right].upper_left = u;
+            }
+        }
+
+        // Part below s
+        if(j == 0 || !wallLeftAbove){
+            idx_t l = lower[j] = newTrapezoid(s, t.bottom, (j == 0 ? seg.p : t.leftp), seg.q);
+            if(j == 0 && A != INVALID_IDX){
+                trapezoids[l].lower_left = A;
+                trapezoids[A].lower_right = l;
+            } else {
+                if(j > 0){
+                    trapezoids[l].upper_left = lower[j-1];
+                    trapezoids[lower[j-1]].upper_right = l;
+                }
+                trapezoids[l].lower_left = t.lower_left;
+                if(t.lower_left != INVALID_IDX) trapezoids[t.lower_left].lower_right = l;
+            }
+        } else lower[j] = lower[j-1];
+
+        if(j == k || !wallRightAbove){
+            idx_t l = lower[j];
+            if(j == k && D != INVALID_IDX){
+                trapezoids[l].lower_right = D;
+                trapezoids[D].lower_left = l;
+            } else {
+                trapezoids[l].rightp = (j == k ? seg.q : t.rightp);
+                trapezoids[l].lower_right = t.lower_right;
+                if(t.lower_right != INVALID_IDX) trapezoids[t.lower_right].lower_left = l;
+            }
+        }
+    }
+
+    // Replace the leaves of crossed trapezoids in the search DAG
+    for(size_t j = 0; j <= k; ++j){
+        const idx_t leaf = trapezoids[crossed[j]].node;
+
+        idx_t above = leafOf(upper[j]),
+              below = leafOf(lower[j]);
+        nodes.push_back(Node{Node::Y, s, above, below, Vector2()});
+        idx_t sub = idx_t(nodes.size() - 1);
+        if(j == k && D != INVALID_IDX){
+            idx_t right = leafOf(D);
+            nodes.push_back(Node{Node::X, INVALID_IDX, sub, right, seg.q});
+            sub = idx_t(nodes.size() - 1);
+        }
+        if(j == 0 && A != INVALID_IDX){
+            idx_t left = leafOf(A);
+            nodes.push_back(Node{Node::X, INVALID_IDX, left, sub, seg.p});
+            sub = idx_t(nodes.size() - 1);
+        }
+
+        // The top of the new subtree takes the place of the leaf
+        nodes[leaf] = nodes[sub];
+        nodes.pop_back();
+        trapezoids[crossed[j]].node = INVALID_IDX;
+    }
+}
+
+idx_t TrapezoidalMap::siteOf(const Trapezoid &t) const {
+    // Vertical segments only bound trapezoids of zero width
+    const Segment &top = segments[t.top];
+    if(top.p.x != top.q.x && top.site_down != INVALID_IDX) return top.site_down;
+
+    const Segment &bottom = segments[t.bottom];
+    if(bottom.p.x != bottom.q.x && bottom.site_up != INVALID_IDX) return bottom.site_up;
+
+    return INVALID_IDX;
+}
+
+void TrapezoidalMap::compact(){
+    // Lay out nodes reachable from the root in depth-first order, so that
+    // a query mostly moves forward in memory and the top levels share
+    // cache lines; leaves refer directly to their site
+    vector<idx_t> order(nodes.size(), INVALID_IDX);
+    vector<Node> compacted;
+    vector<idx_t> stack = {root};
+    while(!stack.empty()){
+        idx_t u = stack.back(); stack.pop_back();
+        if(order[u] != INVALID_IDX) continue;
+
+        order[u] = idx_t(compacted.size());
+        compacted.push_back(nodes[u]);
+        if(nodes[u].type != Node::LEAF){
+            stack.push_back(nodes[u].right);
+            stack.push_back(nodes[u].left);
+        }
+    }
+
+    for(Node &node: compacted){
+        if(node.type == Node::LEAF){
+            node.i = siteOf(trapezoids[node.i]);
+        } else {
+            node.left  = order[node.left];
+            node.right = order[node.right];
+        }
+    }
+
+    nodes.swap(compacted);
+    root = 0;
+
+    trapezoids.clear(); trapezoids.shrink_to_fit();
+}
+
+Vector2 TrapezoidalMap::getClosestPoint(Vector2 p) const {
+    idx_t site = locate(p);
+    if(site == INVALID_IDX) throw runtime_error("point outside of the diagram");
+
+    return sites[site].point;
+}
+
+size_t TrapezoidalMap::getMemoryUsage() const {
+    return
+        segments  .capacity()*sizeof(Segment) +
+        trapezoids.capacity()*sizeof(Trapezoid) +
+        nodes     .capacity()*sizeof(Node);
+}
@@ -1,6 +1,7 @@
 #include "VStripes.h"
 
 #include <algorithm>
+#include <numeric>
 #include <stdexcept>
 
 #include "utils.h"
@@ -12,60 +13,80 @@ d(width){}
 
 void VStripes::initialize(const list<Vector2> &points){
     stripes.clear();
+    stripesIdx.clear();
 
     v.resize(points.size());
     copy(points.begin(), points.end(), v.begin());
 }
 
 void VStripes::run(){
-    sort(v.begin(), v.end(), Vector2::compX);
+    vector<size_t> idx(v.size());
+    iota(idx.begin(), idx.end(), 0);
+    sort(idx.begin(), idx.end(), [this](size_t i, size_t j){ return Vector2::compX(v[i], v[j]); });
 
-    xMin = v.begin()->x;
-    double xMax = v.rbegin()->x;
+    xMin = v[*idx.begin()].x;
+    double xMax = v[*idx.rbegin()].x;
 
     double l = xMin, r = xMin+d;
     size_t i = 0;
     while(l <= xMax){
-        size_t N = 0;
-        for(size_t j = i; j < v.size() && v[j].x < r; ++j) ++N;
-        stripes.push_back(vector<Vector2>(N));
-
-        vector<Vector2> &stripe = *stripes.rbegin();
-        for(size_t j = 0; i < v.size() && v[i].x < r; ++i, ++j){
-            stripe[j] = v[i];
-        }
+        size_t j = i;
+        while(j < idx.size() && v[idx[j]].x < r) ++j;
+        stripesIdx.push_back(vector<size_t>(idx.begin()+i, idx.begin()+j));
+        i = j;
 
         l = r;
         r += d;
     }
 
-    for(vector<Vector2> &stripe: stripes)
-        sort(stripe.begin(), stripe.end(), Vector2::compY);
+    stripes.resize(stripesIdx.size());
+    for(size_t k = 0; k < stripesIdx.size(); ++k){
+        vector<size_t> &stripeIdx = stripesIdx[k];
+        sort(stripeIdx.begin(), stripeIdx.end(), [this](size_t i, size_t j){ return Vector2::compY(v[i], v[j]); });
+
+        vector<Vector2> &stripe = stripes[k];
+        stripe.resize(stripeIdx.size());
+        for(size_t j = 0; j < stripeIdx.size(); ++j)
+            stripe[j] = v[stripeIdx[j]];
+    }
 }
 
 Vector2 VStripes::getClosestPoint(Vector2 p) const {
-    pair<bool,Vector2> ret = getClosestPoint_success(p);
+    return v[getClosestPointIdx(p)];
+}
+
+size_t VStripes::getClosestPointIdx(Vector2 p) const {
+    pair<bool,size_t> ret = getClosestPointIdx_success(p);
     if(!ret.first)
         throw runtime_error("Could not find a solution");
     return ret.second;
 }
 
 pair<bool,Vector2> VStripes::getClosestPoint_success(Vector2 p) const {
+    pair<bool,size_t> ret = getClosestPointIdx_success(p);
+    return pair<bool,Vector2>(ret.first, (ret.first ? v[ret.second] : Vector2()));
+}
+
+size_t VStripes::getStripe(const Vector2 &p) const {
     double fi = (p.x - xMin)/d;
     long li = (long)fi;
-    size_t i = min(long(stripes.size()-1), max(long(0), li));
+    return min(long(stripes.size()-1), max(long(0), li));
+}
+
+pair<bool,size_t> VStripes::getClosestPointIdx_success(Vector2 p) const {
+    size_t i = getStripe(p);
     
-    Vector2 cBest;
+    size_t iBest = 0;
     double dBest = fINF;
 
-    checkStripe(p, i, dBest, cBest);
-    if(long(i-1) >= 0      ) checkStripe(p, i-1, dBest, cBest);
-    if(i+1 < stripes.size()) checkStripe(p, i+1, dBest, cBest);
+    checkStripe(p, i, dBest, iBest);
+    if(long(i-1) >= 0      ) checkStripe(p, i-1, dBest, iBest);
+    if(i+1 < stripes.size()) checkStripe(p, i+1, dBest, iBest);
 
-    return pair<bool,Vector2>(dBest <= d, cBest);
+    return pair<bool,size_t>(dBest <= d, iBest);
 }
 
-void VStripes::checkStripe(const Vector2 &p, size_t i, double &dBest, Vector2 &cBest) const {
+void VStripes::checkStripe(const Vector2 &p, size_t i, double &dBest, size_t &iBest) const {
     const vector<Vector2> &stripe = stripes[i];
     auto l = lower_bound(stripe.begin(), stripe.end(), p.y-d, [](const Vector2 &c, const double &y){ return c.y < y; });
     for(; l != stripe.end() && l->y < p.y+d; ++l){
@@ -73,7 +94,21 @@ void VStripes::checkStripe(const Vector2 &p, size_t i, double &dBest, Vector2 &c
         double d = c.getDistance(p);
         if(d < dBest){
             dBest = d;
-            cBest = c;
+            iBest = stripesIdx[i][l - stripe.begin()];
         }
     }
 }
+
+vector<size_t> VStripes::getQueryOrder(const vector<Vector2> &queries) const {
+    vector<size_t> order(queries.size());
+    vector<size_t> stripeOf(queries.size());
+    for(size_t i = 0; i < queries.size(); ++i){
+        order[i] = i;
+        stripeOf[i] = getStripe(queries[i]);
+    }
+    sort(order.begin(), order.end(), [&queries, &stripeOf](size_t i, size_t j){
+        if(stripeOf[i] != stripeOf[j]) return stripeOf[i] < stripeOf[j];
+        return queries[i].y < queries[j].y;
+    });
+    return order;
+}
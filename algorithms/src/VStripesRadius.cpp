@@ -1,12 +1,14 @@
 #include "VStripesRadius.h"
 
 #include <algorithm>
+#include <numeric>
 #include <stdexcept>
 
 using namespace std;
 
 void VStripesRadius::initialize(const list<Coord> &points, double width){
     stripes.clear();
+    stripesIdx.clear();
 
     v.resize(points.size());
     copy(points.begin(), points.end(), v.begin());
@@ -15,53 +17,89 @@ void VStripesRadius::initialize(const list<Coord> &points, double width){
 }
 
 void VStripesRadius::run(){
-    sort(v.begin(), v.end(), Coord::compX);
+    vector<size_t> idx(v.size());
+    iota(idx.begin(), idx.end(), 0);
+    sort(idx.begin(), idx.end(), [this](size_t i, size_t j){ return Coord::compX(v[i], v[j]); });
 
-    xMin = v.begin()->x;
-    double xMax = v.rbegin()->x;
+    xMin = v[*idx.begin()].x;
+    double xMax = v[*idx.rbegin()].x;
 
     double l = xMin, r = xMin+d;
     size_t i = 0;
     while(l <= xMax){
-        size_t N = 0;
-        for(size_t j = i; j < v.size() && v[j].x < r; ++j) ++N;
-        stripes.push_back(vector<Coord>(N));
-
-        vector<Coord> &stripe = *stripes.rbegin();
-        for(size_t j = 0; i < v.size() && v[i].x < r; ++i, ++j){
-            stripe[j] = v[i];
-        }
+        size_t j = i;
+        while(j < idx.size() && v[idx[j]].x < r) ++j;
+        stripesIdx.push_back(vector<size_t>(idx.begin()+i, idx.begin()+j));
+        i = j;
 
         l = r;
         r += d*Coord::MetersToLonDegrees();
     }
 
-    for(vector<Coord> &stripe: stripes)
-        sort(stripe.begin(), stripe.end(), Coord::compY);
+    stripes.resize(stripesIdx.size());
+    for(size_t k = 0; k < stripesIdx.size(); ++k){
+        vector<size_t> &stripeIdx = stripesIdx[k];
+        sort(stripeIdx.begin(), stripeIdx.end(), [this](size_t i, size_t j){ return Coord::compY(v[i], v[j]); });
+
+        vector<Coord> &stripe = stripes[k];
+        stripe.resize(stripeIdx.size());
+        for(size_t j = 0; j < stripeIdx.size(); ++j)
+            stripe[j] = v[stripeIdx[j]];
+    }
 }
 
 vector<Coord> VStripesRadius::getClosestPoints(Coord p) const {
-    vector<Coord> sols;
+    vector<size_t> idxs;
+    getClosestPointsIdx(p, idxs);
+
+    vector<Coord> sols(idxs.size());
+    for(size_t i = 0; i < idxs.size(); ++i) sols[i] = v[idxs[i]];
+    return sols;
+}
 
+size_t VStripesRadius::getStripe(const Coord &p) const {
     double fi = (p.x - xMin)/(d*Coord::MetersToLonDegrees());
     long li = (long)fi;
-    size_t i = min(long(stripes.size()-1), max(long(0), li));
+    return min(long(stripes.size()-1), max(long(0), li));
+}
 
-    checkStripe(p, i, sols);
-    if(long(i-1) >= 0      ) checkStripe(p, i-1, sols);
-    if(i+1 < stripes.size()) checkStripe(p, i+1, sols);
+void VStripesRadius::getClosestPointsIdx(Coord p, vector<size_t> &res) const {
+    size_t i = getStripe(p);
 
-    return sols;
+    checkStripe(p, i, res);
+    if(long(i-1) >= 0      ) checkStripe(p, i-1, res);
+    if(i+1 < stripes.size()) checkStripe(p, i+1, res);
 }
 
-void VStripesRadius::checkStripe(const Coord &p, size_t i, vector<Coord> &sols) const {
+void VStripesRadius::checkStripe(const Coord &p, size_t i, vector<size_t> &sols) const {
     const vector<Coord> &stripe = stripes[i];
     auto l = lower_bound(stripe.begin(), stripe.end(), p.y-d*Coord::MetersToLatDegrees(), [](const Coord &c, const double &y){ return c.y < y; });
     for(; l != stripe.end() && l->y < p.y+d*Coord::MetersToLatDegrees(); ++l){
         const Coord &c = *l;
         double dist = Coord::getDistanceArcSimple(c, p);
         if(dist < d){
-            sols.push_back(c);
+            sols.push_back(stripesIdx[i][l - stripe.begin()]);
         }
     }
 }
+
+vector<size_t> VStripesRadius::getQueryOrder(const vector<Coord> &queries) const {
+    vector<size_t> order(queries.size());
+    vector<size_t> stripeOf(queries.size());
+    for(size_t i = 0; i < queries.size(); ++i){
+        order[i] = i;
+        stripeOf[i] = getStripe(queries[i]);
+    }
+    sort(order.begin(), order.end(), [&queries, &stripeOf](size_t i, size_t j){
+        if(stripeOf[i] != stripeOf[j]) return stripeOf[i] < stripeOf[j];
+        return queries[i].y < queries[j].y;
+    });
+    return order;
+}
+
+size_t VStripesRadius::getMemoryUsage() const {
+    size_t mem = v.size()*sizeof(Coord);
+    for(const vector<Coord> &stripe: stripes) mem += sizeof(stripe) + stripe.size()*sizeof(Coord);
+    for(const vector<size_t> &stripeIdx: stripesIdx) mem += sizeof(stripeIdx) + stripeIdx.size()*sizeof(size_t);
+    return mem;
+}
@@ -0,0 +1,246 @@
+#include "ViterbiLog.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include <sstream>
+
+using namespace std;
+
+typedef ViterbiLog::local_t local_t;
+
+typedef double  vd __attribute__((vector_size(ViterbiLog::LANES*sizeof(double))));
+typedef int64_t vl __attribute__((vector_size(ViterbiLog::LANES*sizeof(int64_t))));
+
+const local_t NO_PREV = numeric_limits<local_t>::max();
+
+// Scores that are sums with a LOG_ZERO term are at most this
+const double DEAD = ViterbiLog::LOG_ZERO/2;
+
+// By reference, so no vector crosses a function boundary by value
+inline void load(vd &r, const double *p){
+    memcpy(&r, p, sizeof(vd));
+}
+
+inline void store(double *p, const vd &v){
+    memcpy(p, &v, sizeof(vd));
+}
+
+inline double toLog(double p){
+    return (p > 0.0 ? log(p) : ViterbiLog::LOG_ZERO);
+}
+
+void ViterbiLog::Scores::clear(){
+    sz.clear();
+    emissionBegin.clear();
+    transitionBegin.clear();
+    emissions.clear();
+    transitions.clear();
+}
+
+void ViterbiLog::Scores::addStep(size_t n){
+    const size_t stride = (n + LANES-1)/LANES*LANES;
+    emissionBegin.push_back(emissions.size());
+    emissions.resize(emissions.size() + stride, LOG_ZERO);
+    transitionBegin.push_back(transitions.size());
+    if(!sz.empty()) transitions.resize(transitions.size() + sz.back()*stride, LOG_ZERO);
+    sz.push_back(n);
+}
+
+size_t ViterbiLog::Scores::getSteps() const { return sz.size(); }
+size_t ViterbiLog::Scores::getSize(size_t t) const { return sz.at(t); }
+size_t ViterbiLog::Scores::getStride(size_t t) const { return (sz.at(t) + LANES-1)/LANES*LANES; }
+
+double *ViterbiLog::Scores::emission(size_t t){ return emissions.data() + emissionBegin.at(t); }
+const double *ViterbiLog::Scores::emission(size_t t) const { return emissions.data() + emissionBegin.at(t); }
+double *ViterbiLog::Scores::transition(size_t t){ return transitions.data() + transitionBegin.at(t); }
+const double *ViterbiLog::Scores::transition(size_t t) const { return transitions.data() + transitionBegin.at(t); }
+
+ViterbiLog::Scores ViterbiLog::Scores::fromGenerators(
+    const Viterbi::InitialProbabilitiesGenerator *Pi,
+    const Viterbi::TransitionMatrixGenerator *A,
+    const Viterbi::EmissionMatrixGenerator *B,
+    const vector<set<long>> &candidates
+){
+    Scores scores;
+    vector<long> prevStates, states;
+    for(size_t t = 0; t < candidates.size(); ++t){
+        prevStates.swap(states);
+        states.assign(candidates[t].begin(), candidates[t].end());
+        scores.addStep(states.size());
+
+        double *b = scores.emission(t);
+        if(t == 0){
+            for(size_t j = 0; j < states.size(); ++j)
+                b[j] = toLog((*Pi)(states[j]));
+            continue;
+        }
+        for(size_t j = 0; j < states.size(); ++j)
+            b[j] = toLog((*B)(states[j], long(t)));
+
+        const size_t stride = scores.getStride(t);
+        double *a = scores.transition(t);
+        for(size_t i = 0; i < prevStates.size(); ++i)
+            for(size_t j = 0; j < states.size(); ++j)
+                a[i*stride + j] = toLog((*A)(prevStates[i], states[j], long(t)));
+    }
+    return scores;
+}
+
+void ViterbiLog::initialize(const Scores *scores_){
+    scores = scores_;
+    first = 0;
+    last = numeric_limits<size_t>::max();
+    initial.clear();
+    begin.assign(1, 0);
+    score.clear();
+    prev.clear();
+}
+
+void ViterbiLog::initialize(const Scores *scores_, size_t first_, size_t last_, const double *initial_){
+    initialize(scores_);
+    first = first_;
+    last = last_;
+    if(initial_ != nullptr) initial.assign(initial_, initial_ + scores->getSize(first));
+}
+
+/**
+ * @brief Compute states [k*LANES, (k+V)*LANES) of step t.
+ */
+template<size_t V>
+void ViterbiLog::runBlocks(size_t t, size_t k){
+    const size_t m = scores->getSize(t-1);
+    const size_t stride = scores->getStride(t);
+    const double *p = score.data() + begin[t-first-1];
+    const double *a = scores->transition(t) + k*LANES;
+
+    vd best[V];
+    vl arg[V];
+    for(size_t v = 0; v < V; ++v){
+        best[v] = vd{} + LOG_ZERO;
+        arg [v] = vl{} + int64_t(NO_PREV);
+    }
+
+    for(size_t i = 0; i < m; ++i, a += stride){
+        if(p[i] <= DEAD) continue;
+        const vd pi = vd{} + p[i];
+        const vl ii = vl{} + int64_t(i);
+        for(size_t v = 0; v < V; ++v){
+            vd c;
+            load(c, a + v*LANES);
+            c += pi;
+            const vl better = (c > best[v]);
+            best[v] = (better ? c  : best[v]);
+            arg [v] = (better ? ii : arg [v]);
+        }
+    }
+
+    const double *b = scores->emission(t) + k*LANES;
+    double  *s  = score.data() + begin[t-first] + k*LANES;
+    local_t *pr = prev .data() + begin[t-first] + k*LANES;
+    for(size_t v = 0; v < V; ++v){
+        vd x;
+        load(x, b + v*LANES);
+        x += best[v];
+        store(s + v*LANES, x);
+        for(size_t l = 0; l < LANES; ++l){
+            double &sj = s[v*LANES + l];
+            if(sj <= DEAD){
+                sj = LOG_ZERO;
+                pr[v*LANES + l] = NO_PREV;
+            } else {
+                pr[v*LANES + l] = local_t(arg[v][l]);
+            }
+        }
+    }
+}
+
+void ViterbiLog::run(){
+    const size_t end = min(last, scores->getSteps());
+    for(size_t t = first + begin.size()-1; t < end; ++t){
+        if(scores->getSize(t) >= NO_PREV){
+            stringstream ss;
+            ss << "Too many candidates at t=" << t << ": " << scores->getSize(t);
+            throw invalid_argument(ss.str());
+        }
+        begin.push_back(begin.back() + scores->getStride(t));
+        score.resize(begin.back(), LOG_ZERO);
+        prev.resize(begin.back(), NO_PREV);
+
+        if(t == first){
+            // Initialize with the given scores, or the scores of the first step
+            if(initial.empty()) copy(scores->emission(t), scores->emission(t) + scores->getStride(t), score.begin());
+            else copy(initial.begin(), initial.end(), score.begin());
+            for(size_t j = begin[0]; j < begin[1]; ++j)
+                if(score[j] <= DEAD) score[j] = LOG_ZERO;
+            continue;
+        }
+
+        const size_t blocks = scores->getStride(t)/LANES;
+        for(size_t k = 0; k < blocks; k += 4){
+            switch(min(blocks - k, size_t(4))){
+                case 1: runBlocks<1>(t, k); break;
+                case 2: runBlocks<2>(t, k); break;
+                case 3: runBlocks<3>(t, k); break;
+                default: runBlocks<4>(t, k); break;
+            }
+        }
+    }
+}
+
+const double *ViterbiLog::getStepScores(size_t t) const {
+    return score.data() + begin.at(t-first);
+}
+
+bool ViterbiLog::isReachable(double s){
+    return s > DEAD;
+}
+
+vector<size_t> ViterbiLog::getLikeliestPath() const {
+    const size_t T = begin.size()-1;
+    if(T == 0) return vector<size_t>();
+
+    size_t jBest = NO_PREV;
+    double sBest = DEAD;
+    for(size_t j = 0; j < scores->getSize(first+T-1); ++j){
+        if(score[begin[T-1] + j] > sBest){
+            sBest = score[begin[T-1] + j];
+            jBest = j;
+        }
+    }
+
+    if(jBest == NO_PREV){
+        // Report the last step some path reaches
+        long t = long(T)-1;
+        for(; t >= 0; --t){
+            if(any_of(score.begin() + long(begin[size_t(t)]), score.begin() + long(begin[size_t(t)+1]), [](double s){ return s > DEAD; }))
+                break;
+        }
+        stringstream ss;
+        ss << "Could not find any path, t=" << long(first) + t;
+        throw runtime_error(ss.str());
+    }
+
+    return getLikeliestPath(jBest);
+}
+
+vector<size_t> ViterbiLog::getLikeliestPath(size_t j) const {
+    const size_t T = begin.size()-1;
+    if(T == 0) return vector<size_t>();
+
+    if(j >= scores->getSize(first+T-1) || score[begin[T-1] + j] <= DEAD){
+        stringstream ss;
+        ss << "Could not find any path to state " << j << " of t=" << first+T-1;
+        throw runtime_error(ss.str());
+    }
+
+    vector<size_t> ret(T);
+    ret[T-1] = j;
+    for(size_t t = T-1; t > 0; --t)
+        ret[t-1] = prev[begin[t] + ret[t]];
+
+    return ret;
+}
@@ -0,0 +1,163 @@
+#include "ViterbiParallel.h"
+
+#include "parallelFor.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include <sstream>
+
+using namespace std;
+
+typedef vector<double> VF;
+
+ViterbiParallel::ViterbiParallel(size_t nThreads_, size_t minSteps_):
+    nThreads(nThreads_), minSteps(minSteps_)
+{}
+
+void ViterbiParallel::initialize(const ViterbiLog::Scores *scores_){
+    scores = scores_;
+    path.clear();
+}
+
+void ViterbiParallel::run(){
+    const size_t T = scores->getSteps();
+    parallel = (nThreads > 1 && T >= max(minSteps, size_t(4)));
+    if(!parallel){
+        sequential.initialize(scores);
+        sequential.run();
+        return;
+    }
+    runParallel();
+}
+
+void ViterbiParallel::runParallel(){
+    const size_t T = scores->getSteps();
+    const size_t C = min(nThreads, T/2);
+
+    // Chunk c is steps [b[c], b[c+1]); chunks c > 0 start from the states of
+    // step b[c]-1
+    vector<size_t> b(C+1);
+    for(size_t c = 0; c <= C; ++c) b[c] = c*T/C;
+
+    // M[c][i*n + j]: transfer matrix of chunk c > 0, from state i of step
+    // b[c]-1 to state j of step b[c+1]-1
+    // v[c][j]: log score of state j of step b[c+1]-1
+    vector<VF> M(C), v(C);
+    vector<pair<size_t, size_t>> tasks;
+    tasks.emplace_back(0, 0);
+    for(size_t c = 1; c < C; ++c){
+        const size_t m = scores->getSize(b[c]-1), n = scores->getSize(b[c+1]-1);
+        M[c].assign(m*n, ViterbiLog::LOG_ZERO);
+        for(size_t i = 0; i < m; ++i) tasks.emplace_back(c, i);
+    }
+
+    // Transfer matrices
+    utils::parallelFor(tasks.size(), nThreads, [this, &tasks, &b, &M, &v](size_t l, size_t r){
+        ViterbiLog viterbi;
+        VF initial;
+        for(size_t k = l; k < r; ++k){
+            const size_t &c = tasks[k].first, &i = tasks[k].second;
+            const size_t n = scores->getSize(b[c+1]-1);
+            if(c == 0){
+                viterbi.initialize(scores, 0, b[1], nullptr);
+            } else {
+                initial.assign(scores->getSize(b[c]-1), ViterbiLog::LOG_ZERO);
+                initial[i] = 0.0;
+                viterbi.initialize(scores, b[c]-1, b[c+1], initial.data());
+            }
+            viterbi.run();
+            const double *s = viterbi.getStepScores(b[c+1]-1);
+            if(c == 0) v[0].assign(s, s + n);
+            else copy(s, s + n, M[c].begin() + long(i*n));
+        }
+    });
+
+    // Scores at chunk boundaries
+    found = true;
+    for(size_t c = 0; c < C; ++c){
+        if(c > 0){
+            const size_t m = scores->getSize(b[c]-1), n = scores->getSize(b[c+1]-1);
+            v[c].assign(n, ViterbiLog::LOG_ZERO);
+            for(size_t i = 0; i < m; ++i){
+                if(!ViterbiLog::isReachable(v[c-1][i])) continue;
+                const double *Mi = M[c].data() + i*n;
+                for(size_t j = 0; j < n; ++j){
+                    const double x = v[c-1][i] + Mi[j];
+                    if(ViterbiLog::isReachable(x) && x > v[c][j]) v[c][j] = x;
+                }
+            }
+        }
+        if(none_of(v[c].begin(), v[c].end(), ViterbiLog::isReachable)){
+            // Find the last step some path reaches, as ViterbiLog reports it
+            ViterbiLog viterbi;
+            viterbi.initialize(scores, (c == 0 ? 0 : b[c]-1), b[c+1], (c == 0 ? nullptr : v[c-1].data()));
+            viterbi.run();
+            long t = long(b[c+1])-1;
+            for(; t >= 0; --t){
+                const double *s = viterbi.getStepScores(size_t(t));
+                if(any_of(s, s + scores->getSize(size_t(t)), ViterbiLog::isReachable)) break;
+            }
+            found = false;
+            tFail = t;
+            return;
+        }
+    }
+
+    // States of the likeliest path at chunk boundaries
+    vector<size_t> e(C);
+    {
+        double best = ViterbiLog::LOG_ZERO;
+        for(size_t j = 0; j < v[C-1].size(); ++j){
+            if(ViterbiLog::isReachable(v[C-1][j]) && v[C-1][j] > best){
+                best = v[C-1][j];
+                e[C-1] = j;
+            }
+        }
+    }
+    for(size_t c = C-1; c > 0; --c){
+        const size_t n = scores->getSize(b[c+1]-1);
+        double best = ViterbiLog::LOG_ZERO;
+        for(size_t i = 0; i < v[c-1].size(); ++i){
+            const double x = v[c-1][i] + M[c][i*n + e[c]];
+            if(ViterbiLog::isReachable(v[c-1][i]) && ViterbiLog::isReachable(x) && x > best){
+                best = x;
+                e[c-1] = i;
+            }
+        }
+    }
+
+    // Decode and backtrack each chunk between its boundary states
+    path.assign(T, 0);
+    utils::parallelFor(C, nThreads, [this, &b, &e](size_t l, size_t r){
+        ViterbiLog viterbi;
+        VF initial;
+        for(size_t c = l; c < r; ++c){
+            if(c == 0){
+                viterbi.initialize(scores, 0, b[1], nullptr);
+            } else {
+                initial.assign(scores->getSize(b[c]-1), ViterbiLog::LOG_ZERO);
+                initial[e[c-1]] = 0.0;
+                viterbi.initialize(scores, b[c]-1, b[c+1], initial.data());
+            }
+            viterbi.run();
+            const vector<size_t> p = viterbi.getLikeliestPath(e[c]);
+            copy(p.begin() + (c == 0 ? 0 : 1), p.end(), path.begin() + long(b[c]));
+        }
+    });
+}
+
+bool ViterbiParallel::ranInParallel() const {
+    return parallel;
+}
+
+vector<size_t> ViterbiParallel::getLikeliestPath() const {
+    if(!parallel) return sequential.getLikeliestPath();
+    if(!found){
+        stringstream ss;
+        ss << "Could not find any path, t=" << tFail;
+        throw runtime_error(ss.str());
+    }
+    return path;
+}
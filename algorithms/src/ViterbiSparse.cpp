@@ -0,0 +1,109 @@
+#include "ViterbiSparse.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include <sstream>
+
+using namespace std;
+
+typedef ViterbiSparse::local_t local_t;
+
+const local_t NO_PREV = numeric_limits<local_t>::max();
+
+void ViterbiSparse::initialize(
+    Viterbi::InitialProbabilitiesGenerator *Pi_,
+    Viterbi::TransitionMatrixGenerator *A_,
+    Viterbi::EmissionMatrixGenerator *B_,
+    const vector<set<long>> &candidates_
+){
+    Pi = Pi_;
+    A  = A_;
+    B  = B_;
+
+    layer.assign(1, 0);
+    layer.reserve(candidates_.size()+1);
+    for(const set<long> &c: candidates_){
+        if(c.size() >= NO_PREV){
+            stringstream ss;
+            ss << "Too many candidates at t=" << layer.size()-1 << ": " << c.size();
+            throw invalid_argument(ss.str());
+        }
+        layer.push_back(layer.back() + c.size());
+    }
+
+    states.clear();
+    states.reserve(layer.back());
+    for(const set<long> &c: candidates_)
+        states.insert(states.end(), c.begin(), c.end());
+
+    prob.assign(layer.back(), 0.0);
+    prev.assign(layer.back(), NO_PREV);
+}
+
+void ViterbiSparse::run(){
+    if(states.empty()) return;
+    const size_t T = layer.size()-1;
+
+    // Initialize with Pi
+    double maxProb = 0.0;
+    for(size_t i = layer[0]; i < layer[1]; ++i){
+        prob[i] = (*Pi)(states[i]);
+        maxProb = max(maxProb, prob[i]);
+    }
+    if(maxProb > 0.0) for(size_t i = layer[0]; i < layer[1]; ++i) prob[i] /= maxProb;
+
+    for(size_t t = 1; t < T; ++t){
+        const size_t l0 = layer[t-1], l1 = layer[t], l2 = layer[t+1];
+        maxProb = 0.0;
+        for(size_t i = l0; i < l1; ++i){
+            if(prob[i] <= 0.0) continue;
+            for(size_t j = l1; j < l2; ++j){
+                double p = prob[i] * (*A)(states[i], states[j], long(t)) * (*B)(states[j], long(t));
+                if(p > prob[j]){
+                    prob[j] = p;
+                    prev[j] = local_t(i - l0);
+                    maxProb = max(maxProb, p);
+                }
+            }
+        }
+        if(maxProb > 0.0) for(size_t j = l1; j < l2; ++j) prob[j] /= maxProb;
+    }
+}
+
+vector<long> ViterbiSparse::getLikeliestPath() const {
+    const size_t T = layer.size()-1;
+    if(T == 0) return vector<long>();
+
+    size_t jBest = layer[T];
+    double pBest = 0.0;
+    for(size_t j = layer[T-1]; j < layer[T]; ++j){
+        if(prob[j] > pBest){
+            pBest = prob[j];
+            jBest = j;
+        }
+    }
+
+    if(jBest == layer[T]){
+        // Report the last step some path reaches
+        long t = long(T)-1;
+        for(; t >= 0; --t){
+            if(any_of(prob.begin() + long(layer[size_t(t)]), prob.begin() + long(layer[size_t(t)+1]), [](double p){ return p > 0.0; }))
+                break;
+        }
+        stringstream ss;
+        ss << "Could not find any path, t=" << t;
+        throw runtime_error(ss.str());
+    }
+
+    vector<long> ret(T);
+    size_t j = jBest;
+    for(size_t t = T-1; t > 0; --t){
+        ret[t] = states[j];
+        j = layer[t-1] + prev[j];
+    }
+    ret[0] = states[j];
+
+    return ret;
+}
@@ -0,0 +1,215 @@
+#include "VoronoiGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "FortuneAlgorithm.h"
+#include "utils.h"
+
+using namespace std;
+
+/**
+ * @brief Call f(i) for every cell i of an nx*ny grid with bottom-left
+ * corner (xl, yl) and cells of size w*h that segment ab may cross, with the
+ * segment widened by margin.
+ */
+template<class F>
+void forEachCell(const Vector2 &a, const Vector2 &b, double xl, double yl, double w, double h, long nx, long ny, double margin, const F &f){
+    auto col = [xl, w, nx](double x){ return min(nx-1, max(0L, long(floor((x-xl)/w)))); };
+    auto row = [yl, h, ny](double y){ return min(ny-1, max(0L, long(floor((y-yl)/h)))); };
+
+    const double sxl = min(a.x, b.x), sxr = max(a.x, b.x);
+    const double syl = min(a.y, b.y), syr = max(a.y, b.y);
+    if(sxr + margin < xl || sxl - margin > xl + w*double(nx)) return;
+    if(syr + margin < yl || syl - margin > yl + h*double(ny)) return;
+
+    const double slope = (b.y - a.y)/(b.x - a.x);
+    for(long cx = col(sxl - margin); cx <= col(sxr + margin); ++cx){
+        double l = max(sxl, xl + w*double(cx  ));
+        double r = min(sxr, xl + w*double(cx+1));
+        double ya = syl, yb = syr;
+        // Otherwise the segment is vertical, or only touches this column
+        if(sxl < sxr && l <= r){
+            ya = min(syr, max(syl, a.y + (l - a.x)*slope));
+            yb = min(syr, max(syl, a.y + (r - a.x)*slope));
+            if(ya > yb) swap(ya, yb);
+        }
+        // In this column the segment may pass above or below the grid
+        if(yb + margin < yl || ya - margin > yl + h*double(ny)) continue;
+        for(long cy = row(ya - margin); cy <= row(yb + margin); ++cy)
+            f(cy*nx + cx);
+    }
+}
+
+VoronoiGrid::VoronoiGrid(double cellsPerSite_, size_t maxCandidates_, size_t maxDepth_):
+    cellsPerSite(cellsPerSite_),
+    maxCandidates(maxCandidates_),
+    maxDepth(maxDepth_)
+{}
+
+void VoronoiGrid::initialize(const list<Vector2> &points){
+    v = vector<Vector2>(points.begin(), points.end());
+    fallback.initialize(points);
+    cells.clear();
+    candidates.clear();
+    candidateIds.clear();
+}
+
+void VoronoiGrid::run(){
+    fallback.run();
+
+    double x1 = -fINF, y1 = -fINF;
+    x0 = +fINF; y0 = +fINF;
+    for(const Vector2 &p: v){
+        x0 = min(x0, p.x); x1 = max(x1, p.x);
+        y0 = min(y0, p.y); y1 = max(y1, p.y);
+    }
+    const double W = max(x1-x0, 1e-12), H = max(y1-y0, 1e-12);
+
+    // Cells about square, cellsPerSite per site
+    const double nCells = max(1.0, double(v.size())*cellsPerSite);
+    nx = max(1L, long(round(sqrt(nCells*W/H))));
+    ny = max(1L, long(ceil(nCells/double(nx))));
+    cellW = W/double(nx);
+    cellH = H/double(ny);
+
+    Segments segments;
+    {
+        VoronoiDiagram diagram = FortuneAlgorithm(v).construct();
+        for(const Edge &e: diagram.getEdges()){
+            if(e.site_up == Voronoi::INVALID_IDX) continue;
+            segments.a.push_back(e.start);
+            segments.b.push_back(e.end);
+            segments.sites.push_back(make_pair(e.site_up, e.site_down));
+        }
+    }
+
+    // Cells are widened by the rounding error of the diagram, so a site is
+    // a candidate of every cell its Voronoi cell might touch
+    const double margin = 1e-9*max(W, H);
+
+    // Edges crossing each top-level cell
+    const size_t nTop = size_t(nx*ny);
+    vector<uint32_t> cellStart(nTop+1, 0);
+    vector<uint32_t> cellEdges;
+    for(int pass = 0; pass < 2; ++pass){
+        for(uint32_t e = 0; e < segments.a.size(); ++e){
+            forEachCell(segments.a[e], segments.b[e], x0, y0, cellW, cellH, nx, ny, margin, [&](long c){
+                if(pass == 0) ++cellStart[c+1];
+                else cellEdges[cellStart[c]++] = e;
+            });
+        }
+        if(pass == 0){
+            for(size_t c = 0; c < nTop; ++c) cellStart[c+1] += cellStart[c];
+            cellEdges.resize(cellStart[nTop]);
+        } else {
+            for(size_t c = nTop; c > 0; --c) cellStart[c] = cellStart[c-1];
+            cellStart[0] = 0;
+        }
+    }
+
+    cells.resize(nTop);
+    for(long cy = 0; cy < ny; ++cy){
+        for(long cx = 0; cx < nx; ++cx){
+            const size_t c = size_t(cy*nx + cx);
+            vector<uint32_t> edges(cellEdges.begin() + cellStart[c], cellEdges.begin() + cellStart[c+1]);
+            build(uint32_t(c), x0 + cellW*double(cx), y0 + cellH*double(cy), cellW, cellH, segments, edges, vector<uint32_t>(), 0);
+        }
+    }
+
+    cells.shrink_to_fit();
+    candidates.shrink_to_fit();
+    candidateIds.shrink_to_fit();
+}
+
+void VoronoiGrid::build(uint32_t cell, double xl, double yl, double w, double h, const Segments &segments, const vector<uint32_t> &edges, const vector<uint32_t> &parentIds, size_t depth){
+    // Every site whose Voronoi cell meets this cell either has an edge
+    // crossing it, or is the only one and owns its center
+    vector<uint32_t> ids;
+    if(edges.empty()){
+        const Vector2 center(xl + w/2, yl + h/2);
+        if(parentIds.empty()) ids.push_back(uint32_t(fallback.getClosestPointIdx(center)));
+        else ids.push_back(*min_element(parentIds.begin(), parentIds.end(), [this, &center](uint32_t i, uint32_t j){
+            return Vector2::getDistance(v[i], center) < Vector2::getDistance(v[j], center);
+        }));
+    }
+    for(const uint32_t &e: edges){
+        ids.push_back(segments.sites[e].first);
+        ids.push_back(segments.sites[e].second);
+    }
+    sort(ids.begin(), ids.end());
+    ids.erase(unique(ids.begin(), ids.end()), ids.end());
+
+    if(ids.size() == 1){
+        cells[cell] = Cell{ids[0], 1};
+        return;
+    }
+
+    if(ids.size() <= maxCandidates || depth >= maxDepth){
+        cells[cell] = Cell{uint32_t(candidates.size()), uint32_t(ids.size())};
+        for(const uint32_t &i: ids){
+            candidates.push_back(v[i]);
+            candidateIds.push_back(i);
+        }
+        return;
+    }
+
+    const uint32_t children = uint32_t(cells.size());
+    cells.resize(cells.size() + 4);
+    cells[cell] = Cell{children, INTERNAL};
+
+    const double margin = 1e-9*max(cellW*double(nx), cellH*double(ny));
+    vector<uint32_t> childEdges[4];
+    for(const uint32_t &e: edges){
+        forEachCell(segments.a[e], segments.b[e], xl, yl, w/2, h/2, 2, 2, margin, [&childEdges, &e](long c){
+            childEdges[c].push_back(e);
+        });
+    }
+    for(uint32_t q = 0; q < 4; ++q)
+        build(children + q, xl + w/2*double(q%2), yl + h/2*double(q/2), w/2, h/2, segments, childEdges[q], ids, depth+1);
+}
+
+Vector2 VoronoiGrid::getClosestPoint(const Vector2 p) const {
+    return v[getClosestPointIdx(p)];
+}
+
+size_t VoronoiGrid::getClosestPointIdx(const Vector2 p) const {
+    double fx = (p.x - x0)/cellW;
+    double fy = (p.y - y0)/cellH;
+    if(!(fx >= 0 && fx <= double(nx) && fy >= 0 && fy <= double(ny)))
+        return fallback.getClosestPointIdx(p);
+
+    const long cx = min(nx-1, long(fx));
+    const long cy = min(ny-1, long(fy));
+    fx -= double(cx);
+    fy -= double(cy);
+
+    const Cell *cell = &cells[size_t(cy*nx + cx)];
+    while(cell->count == INTERNAL){
+        fx *= 2; fy *= 2;
+        const uint32_t qx = (fx >= 1), qy = (fy >= 1);
+        fx -= qx; fy -= qy;
+        cell = &cells[cell->begin + qy*2 + qx];
+    }
+
+    if(cell->count == 1) return cell->begin;
+
+    uint32_t ibest = cell->begin;
+    double dbest = fINF;
+    for(uint32_t i = cell->begin; i < cell->begin + cell->count; ++i){
+        const double dx = candidates[i].x - p.x, dy = candidates[i].y - p.y;
+        const double d = dx*dx + dy*dy;
+        if(d < dbest){
+            dbest = d;
+            ibest = i;
+        }
+    }
+    return candidateIds[ibest];
+}
+
+size_t VoronoiGrid::getMemoryUsage() const {
+    return
+        cells.capacity()*sizeof(Cell) +
+        candidates.capacity()*sizeof(Vector2) +
+        candidateIds.capacity()*sizeof(uint32_t);
+}
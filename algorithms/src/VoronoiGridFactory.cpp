@@ -0,0 +1,9 @@
+#include "VoronoiGridFactory.h"
+
+VoronoiGridFactory::VoronoiGridFactory(double cellsPerSite_, size_t maxCandidates_, size_t maxDepth_):
+cellsPerSite(cellsPerSite_), maxCandidates(maxCandidates_), maxDepth(maxDepth_)
+{}
+
+ClosestPoint *VoronoiGridFactory::factoryMethod(){
+    return new VoronoiGrid(cellsPerSite, maxCandidates, maxDepth);
+}
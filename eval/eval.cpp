@@ -7,15 +7,30 @@
 
 #include "DeepVStripes.h"
 #include "DeepVStripesFactory.h"
+#include "DelaunayWalk.h"
 #include "DijkstraFew.h"
 #include "DijkstraOnRequest.h"
 #include "EdgeType.h"
+#include "FortuneAlgorithm.h"
+#include "FortuneAlgorithmTiled.h"
+#include "GridRadius.h"
 #include "HiddenMarkovModel.h"
+#include "HiddenMarkovModelHybrid.h"
 #include "Kosaraju.h"
 #include "MapGraph.h"
 #include "K2DTreeClosestPoint.h"
+#include "SegmentRTree.h"
+#include "SlabDecomposition.h"
+#include "SlabDecompositionRB.h"
+#include "SlabDecompositionRBArena.h"
+#include "TrapezoidalMap.h"
 #include "Trip.h"
 #include "VStripesRadius.h"
+#include "ViterbiLog.h"
+#include "ViterbiOptimized.h"
+#include "ViterbiParallel.h"
+#include "ViterbiSparse.h"
+#include "VoronoiGrid.h"
 
 #include "utils.h"
 
@@ -27,11 +42,24 @@ const double NANOS_TO_SECONDS = 1.0 / 1000000000.0;
 
 #include "eval_2dtree.h"
 #include "eval_deepvstripes.h"
+#include "eval_delaunaywalk.h"
 #include "eval_hmm.h"
+#include "eval_hmm_beam.h"
+#include "eval_hmm_hybrid.h"
+#include "eval_hmm_lazy.h"
+#include "eval_hmm_online.h"
 #include "eval_hmm_precalc.h"
+#include "eval_hmm_segments.h"
+#include "eval_hmm_temporal.h"
 #include "eval_error.h"
+#include "eval_gridradius.h"
 #include "eval_hierarchical.h"
 #include "eval_kmeans.h"
+#include "eval_slab.h"
+#include "eval_trapezoidalmap.h"
+#include "eval_viterbi_parallel.h"
+#include "eval_voronoi.h"
+#include "eval_voronoigrid.h"
 
 int main(int argc, char* argv[]) {
     srand(1234);
@@ -41,6 +69,7 @@ int main(int argc, char* argv[]) {
         std::string opt = argv[1];
 
         if (opt == "2d-tree-buildmem") { eval2DTree_BuildMemory(); return 0; }
+        if (opt == "viterbi-parallel") { evalViterbiParallel(); return 0; }
 
         std::cout << "Loading map..." << std::endl;
         MapGraph M("res/map/processed/AMP");
@@ -48,19 +77,26 @@ int main(int argc, char* argv[]) {
 
         if (opt == "2d-tree-buildtime") { eval2DTree_BuildTime(M); return 0; }
         if (opt == "deepvstripes-buildtime") { evalDeepVStripes_BuildTime(M); return 0; }
+        if (opt == "voronoi-buildtime") { evalVoronoi_BuildTime(M); return 0; }
+        if (opt == "voronoi-tiled") { evalVoronoi_Tiled(M); return 0; }
+        if (opt == "slab-rb-arena") { evalSlab_RBArena(M); return 0; }
+        if (opt == "trapezoidal-map") { evalTrapezoidalMap(M); return 0; }
 
         std::cout << "Loading trips..." << std::endl;
         std::vector<Trip> trips = Trip::loadTripsBin("res/data/pkdd15-i/pkdd15-i.trips.bin");
         std::cout << "Loaded trips" << std::endl;
 
         if (opt == "2d-tree-querytime") eval2DTree_QueryTime(M, trips);
+        if (opt == "delaunay-walk-querytime") evalDelaunayWalk_QueryTime(M, trips);
 
         if (opt == "deepvstripes-querytime-d") evalDeepVStripes_QueryTime_d(M, trips);
         if (opt == "deepvstripes-querytime") evalDeepVStripes_QueryTime(M, trips);
         if (opt == "deepvstripes-querytime-nd") evalDeepVStripes_QueryTime_nd(M, trips);
+        if (opt == "voronoi-grid-querytime") evalVoronoiGrid_QueryTime(M, trips);
 
         // HMM
         if (opt == "hmm-vstripes") evalHMM_VStripes(M, trips);
+        if (opt == "hmm-grid") evalHMM_Grid(M, trips);
 
         if (opt == "hmm-dijkstra-s") evalHMM_Dijkstra_earlyStopping(M, trips);
         if (opt == "hmm-dijkstra-sd") evalHMM_Dijkstra_earlyStopping_dMax(M, trips);
@@ -71,6 +107,13 @@ int main(int argc, char* argv[]) {
 
         if (opt == "hmm-viterbi") evalHMM_Viterbi(M, trips);
         if (opt == "hmm-viterbi-o") evalHMM_ViterbiOptimized(M, trips);
+        if (opt == "hmm-viterbi-s") evalHMM_ViterbiSparse(M, trips);
+        if (opt == "hmm-online") evalHMM_Online(M, trips);
+        if (opt == "hmm-beam") evalHMM_Beam(M, trips);
+        if (opt == "hmm-lazy") evalHMM_Lazy(M, trips);
+        if (opt == "hmm-temporal") evalHMM_Temporal(M, trips);
+        if (opt == "hmm-hybrid") evalHMM_Hybrid(M, trips);
+        if (opt == "hmm-segments") evalHMM_Segments(M, trips);
 
         if (opt == "hmm-dijkstra-cache") evalHMM_DijkstraCache(M, trips);
 
@@ -0,0 +1,48 @@
+#pragma once
+
+void evalDelaunayWalk_QueryTime(const MapGraph &M, const std::vector<Trip> &trips){
+    std::ofstream os("eval/delaunay-walk-querytime.csv");
+    os << std::fixed << std::setprecision(3);
+
+    const size_t N = 10000;
+
+    std::list<Vector2> l;
+    for(const std::pair<const DWGraph::node_t, Coord> &p: M.getNodes())
+        l.push_back(p.second);
+
+    DeepVStripes deepVStripes(0.0003, 12);
+    deepVStripes.initialize(l);
+    deepVStripes.run();
+
+    DelaunayWalk delaunayWalk;
+    delaunayWalk.initialize(l);
+    delaunayWalk.run();
+
+    hrc::time_point begin, end;
+
+    os << "i,T,DeepVStripes,DelaunayWalk,DelaunayWalkCursor,CursorSteps\n";
+
+    for(size_t i = 0; i < N; ++i){
+        if(i%1000 == 0) std::cout << "i=" << i << "/" << N << std::endl;
+
+        const Trip &trip = trips[rand()%trips.size()];
+        os << i << "," << trip.coords.size();
+
+        begin = hrc::now();
+        for(const Coord &u: trip.coords) deepVStripes.getClosestPointIdx(u);
+        end = hrc::now();
+        os << "," << double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count());
+
+        begin = hrc::now();
+        for(const Coord &u: trip.coords) delaunayWalk.getClosestPointIdx(u);
+        end = hrc::now();
+        os << "," << double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count());
+
+        DelaunayWalk::Cursor cursor(delaunayWalk);
+        begin = hrc::now();
+        for(const Coord &u: trip.coords) cursor.next(u);
+        end = hrc::now();
+        os << "," << double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count());
+        os << "," << cursor.getSteps() << "\n";
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+void evalHMM_Grid(const MapGraph &M, const std::vector<Trip> &trips){
+    std::ofstream os("eval/hmm-grid.csv");
+    os << std::fixed;
+
+    const size_t N = 100000;
+    const double d = 50;
+    const size_t NUM_THREADS = 8;
+
+    hrc::time_point begin, end; double dt;
+
+    MapGraph G = M.splitLongEdges(30.0);
+    DWGraph::DWGraph distGraph = getSCC(G);
+
+    std::list<Coord> l;
+    for(const DWGraph::node_t &u: distGraph.getNodes()) l.push_back(G.nodeToCoord(u));
+
+    VStripesRadius vstripes;
+    begin = std::chrono::high_resolution_clock::now();
+    vstripes.initialize(l, d);
+    vstripes.run();
+    end = std::chrono::high_resolution_clock::now();
+    dt = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count())*NANOS_TO_SECONDS;
+    std::cout << "VStripesRadius: built in " << dt << "s, " << vstripes.getMemoryUsage() << "B" << std::endl;
+
+    GridRadius grid(NUM_THREADS);
+    begin = std::chrono::high_resolution_clock::now();
+    grid.initialize(l, d);
+    grid.run();
+    end = std::chrono::high_resolution_clock::now();
+    dt = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count())*NANOS_TO_SECONDS;
+    std::cout << "GridRadius: built in " << dt << "s, " << grid.getMemoryUsage() << "B" << std::endl;
+
+    os << "i,VStripes,Grid\n";
+
+    std::vector<size_t> offsets, idxs;
+    for(size_t i = 0; i < N; ++i){
+        os << i;
+        if(i%1000 == 0) std::cout << "i=" << i << "/" << N << std::endl;
+
+        const size_t idx = rand()%trips.size();
+        const std::vector<Coord> &Y = trips[idx].coords;
+
+        for(const ClosestPointsInRadius *q: std::vector<const ClosestPointsInRadius*>({&vstripes, &grid})){
+            begin = std::chrono::high_resolution_clock::now();
+            q->getClosestPointsMany(Y, offsets, idxs);
+            end = std::chrono::high_resolution_clock::now();
+            dt = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count());
+            os << "," << dt;
+        }
+        os << "\n";
+    }
+}
@@ -888,9 +888,13 @@ void evalHMM_ViterbiOptimized(const MapGraph &M, const std::vector<Trip> &trips)
     
     AstarFew shortestPathFew(G.getNodes(), METERS_TO_MILLIMS, 650*METERS_TO_MILLIMS);
 
-    size_t failed = 0;
+    const double sigma_z = 4.07;
+    const double beta = 3;
+    HiddenMarkovModel hmm(closestPointsInRadius, shortestPathFew, d, sigma_z, beta);
+
+    size_t failed = 0, disagree = 0;
 
-    os << "i,Viterbi-o\n";
+    os << "i,Viterbi-o,scores,Viterbi-log,scores-batched\n";
 
     begin0 = std::chrono::high_resolution_clock::now();
 
@@ -922,8 +926,6 @@ void evalHMM_ViterbiOptimized(const MapGraph &M, const std::vector<Trip> &trips)
             std::vector<std::vector<double>> distMatrix = getDistMatrix(K, T, candidateStates, idxToNode, shortestPathFew, distGraph);
 
             // ======== VITERBI ========
-            const double sigma_z = 4.07;
-            const double beta = 3;
 
             HiddenMarkovModel::MyPi Pi(sigma_z, S, Y[0]);
             HiddenMarkovModel::MyA A(beta, Y, distMatrix);
@@ -938,7 +940,141 @@ void evalHMM_ViterbiOptimized(const MapGraph &M, const std::vector<Trip> &trips)
 
             end = std::chrono::high_resolution_clock::now();
             dt = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count());
-            os << n << "," << dt << "\n";
+            os << n << "," << dt;
+
+            // Log-space kernel, on scores computed beforehand
+            begin = std::chrono::high_resolution_clock::now();
+            ViterbiLog::Scores scores = ViterbiLog::Scores::fromGenerators(&Pi, &A, &B, candidateStates);
+            end = std::chrono::high_resolution_clock::now();
+            dt = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count());
+            os << "," << dt;
+
+            begin = std::chrono::high_resolution_clock::now();
+            ViterbiLog viterbiLog;
+            viterbiLog.initialize(&scores);
+            viterbiLog.run();
+            std::vector<size_t> vLog = viterbiLog.getLikeliestPath();
+            end = std::chrono::high_resolution_clock::now();
+            dt = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count());
+            os << "," << dt;
+
+            // Scores computed by the HMM's batched scoring stage
+            begin = std::chrono::high_resolution_clock::now();
+            std::vector<std::vector<Coord>> candidates(T);
+            std::vector<std::vector<double>> dRoute(T);
+            for(size_t t = 0; t < T; ++t){
+                for(long j: candidateStates[t]) candidates[t].push_back(S[j]);
+                if(t == 0) continue;
+                for(long i: candidateStates[t-1])
+                    for(long j: candidateStates[t])
+                        dRoute[t].push_back(distMatrix[i][j]);
+            }
+            ViterbiLog::Scores scoresBatched;
+            hmm.getScores(Y, candidates, dRoute, scoresBatched);
+            end = std::chrono::high_resolution_clock::now();
+            dt = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count());
+            os << "," << dt << "\n";
+
+            for(size_t t = 0; t < T; ++t){
+                if(*std::next(candidateStates[t].begin(), long(vLog[t])) != v[t]){
+                    ++disagree;
+                    std::cout << "Log-space Viterbi disagrees, n=" << n << ", disagreements=" << disagree << std::endl;
+                    break;
+                }
+            }
+        } catch(const std::exception &e){
+            std::cout << "Failed: " << e.what() << std::endl;
+            --n;
+            ++failed;
+            // throw e;
+        }
+    }
+}
+
+void evalHMM_ViterbiSparse(const MapGraph &M, const std::vector<Trip> &trips){
+    std::ofstream os("eval/hmm-viterbi-s.csv");
+    os << std::fixed;
+
+    hrc::time_point begin, end;
+    hrc::time_point begin0, end0; double dt0;
+
+    const size_t N = 10000;
+    const double d = 50;
+
+    MapGraph G = M.splitLongEdges(30.0);
+    DWGraph::DWGraph distGraph = getSCC(G);
+
+    auto nodes = distGraph.getNodes();
+    std::list<Coord> l;
+    for(const DWGraph::node_t &u: nodes) l.push_back(G.nodeToCoord(u));
+
+    VStripesRadius closestPointsInRadius;
+    closestPointsInRadius.initialize(l, d);
+    closestPointsInRadius.run();
+
+    
+    AstarFew shortestPathFew(G.getNodes(), METERS_TO_MILLIMS, 650*METERS_TO_MILLIMS);
+
+    size_t failed = 0;
+
+    os << "i,T,K,Viterbi-o,Viterbi-s\n";
+
+    begin0 = std::chrono::high_resolution_clock::now();
+
+    for(size_t n = 0; n < N; ++n){
+        try {
+            const size_t idx = rand()%trips.size();
+            const auto &trip = trips[idx].coords;
+            const std::vector<Coord> &Y = trip;
+            const size_t &T = Y.size();
+
+            end0 = std::chrono::high_resolution_clock::now();
+            dt0 = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end0-begin0).count());
+            if(n%10 == 0)
+                std::cout << "n=" << n << "/" << N << ", idx=" << idx
+                          << ", tripId=" << trips[idx].id << ", failed=" << failed
+                          << ", Total time: " << dt0/n * NANOS_TO_SECONDS * N
+                          << ", ETA: " << dt0/n * NANOS_TO_SECONDS * (N - n) << "s"
+                          << std::endl;
+
+            // ======== CLOSEST POINTS/CANDIDATE STATES (VSTRIPES) ========
+            std::map<Coord, long, bool (*)(const Vector2&, const Vector2&)> Sv(Vector2::compXY);
+            std::vector<Coord> S;
+            std::vector<DWGraph::node_t> idxToNode;
+            std::vector<std::set<long>> candidateStates(T);
+            getCandidates(G, closestPointsInRadius, Y, S, Sv, idxToNode, candidateStates);
+            const size_t &K = S.size();
+
+            // ======== DISTANCE MATRIX ========
+            std::vector<std::vector<double>> distMatrix = getDistMatrix(K, T, candidateStates, idxToNode, shortestPathFew, distGraph);
+
+            // ======== VITERBI ========
+            const double sigma_z = 4.07;
+            const double beta = 3;
+
+            HiddenMarkovModel::MyPi Pi(sigma_z, S, Y[0]);
+            HiddenMarkovModel::MyA A(beta, Y, distMatrix);
+            HiddenMarkovModel::MyB B(sigma_z, S, Y);
+
+            begin = std::chrono::high_resolution_clock::now();
+            ViterbiOptimized viterbiOptimized;
+            viterbiOptimized.initialize(T, K, &Pi, &A, &B, candidateStates);
+            viterbiOptimized.run();
+            std::vector<long> vOptimized = viterbiOptimized.getLikeliestPath();
+            end = std::chrono::high_resolution_clock::now();
+            double dtOptimized = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count());
+
+            begin = std::chrono::high_resolution_clock::now();
+            ViterbiSparse viterbiSparse;
+            viterbiSparse.initialize(&Pi, &A, &B, candidateStates);
+            viterbiSparse.run();
+            std::vector<long> vSparse = viterbiSparse.getLikeliestPath();
+            end = std::chrono::high_resolution_clock::now();
+            double dtSparse = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count());
+
+            if(vSparse != vOptimized) throw std::logic_error("Sparse and optimized Viterbi disagree");
+
+            os << n << "," << T << "," << K << "," << dtOptimized << "," << dtSparse << "\n";
         } catch(const std::exception &e){
             std::cout << "Failed: " << e.what() << std::endl;
             --n;
@@ -0,0 +1,67 @@
+#pragma once
+
+void evalHMM_Beam(const MapGraph &M, const std::vector<Trip> &trips){
+    std::ofstream os("eval/hmm-beam.csv");
+    os << std::fixed;
+
+    const size_t N = 1000;
+    const double d = 50;
+    const double sigma_z = 5.925232;
+    const double beta = 6.677601;
+    const std::vector<size_t> beamWidths = {0, 1, 2, 4, 8, 16, 32};
+
+    MapGraph G = M.splitLongEdges(30.0);
+
+    VStripesRadius closestPointsInRadius;
+    AstarFew shortestPathFew(G.getNodes(), METERS_TO_MILLIMS, 650*METERS_TO_MILLIMS);
+    std::deque<HiddenMarkovModel> hmms;
+    for(const size_t &B: beamWidths){
+        hmms.emplace_back(closestPointsInRadius, shortestPathFew, d, sigma_z, beta, B);
+        hmms.back().initialize(&G);
+    }
+    // All models share the same closest points
+    hmms.front().run();
+
+    hrc::time_point begin, end;
+
+    // error: mean distance from observations to matches (as in error-pointwise-hmm)
+    // agree: matches equal to those without beam
+    os << "i,T,B,t,error,agree\n";
+
+    for(size_t i = 0; i < N; ++i){
+        std::cout << "i=" << i << "/" << N << std::endl;
+
+        const Trip &trip = trips[rand()%trips.size()];
+        const std::vector<Coord> &Y = trip.coords;
+
+        std::vector<DWGraph::node_t> full;
+        for(size_t k = 0; k < hmms.size(); ++k){
+            std::vector<DWGraph::node_t> matches;
+            double dt;
+            try {
+                begin = hrc::now();
+                matches = hmms[k].getMatches(Y);
+                end = hrc::now();
+                dt = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count());
+            } catch(const std::exception &e){
+                std::cout << "Failed: " << e.what() << std::endl;
+                if(k == 0) break;
+                continue;
+            }
+            if(k == 0) full = matches;
+
+            double error = 0;
+            size_t agree = 0;
+            for(size_t t = 0; t < Y.size(); ++t){
+                error += Coord::getDistanceArc(Y[t], G.nodeToCoord(matches[t]));
+                agree += (matches[t] == full[t]);
+            }
+            error /= double(Y.size());
+
+            os << i << "," << Y.size() << "," << beamWidths[k] << ","
+               << std::setprecision(0) << dt << ","
+               << std::setprecision(3) << error << ","
+               << agree << "\n";
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+void evalHMM_Hybrid(const MapGraph &M, const std::vector<Trip> &trips){
+    std::ofstream os("eval/hmm-hybrid.csv");
+    os << std::fixed;
+
+    const size_t N = 1000;
+    const double d = 50;
+    const double sigma_z = 4.07;
+    const double beta = 3;
+    const double maxDistance = 15;
+    const double maxDetour = 40;
+    const size_t context = 2;
+
+    MapGraph G = M.splitLongEdges(30.0);
+
+    VStripesRadius closestPointsInRadius;
+    AstarFew shortestPathFew(G.getNodes(), METERS_TO_MILLIMS, 650*METERS_TO_MILLIMS);
+    HiddenMarkovModel hmm(closestPointsInRadius, shortestPathFew, d, sigma_z, beta);
+    DeepVStripesFactory closestPointFactory(0.0003, 12);
+    MapMatching::FromClosestPoint nearestNeighbour(closestPointFactory);
+    HiddenMarkovModelHybrid hybrid(nearestNeighbour, hmm, shortestPathFew, maxDistance, maxDetour, context);
+    hybrid.initialize(&G);
+    hybrid.run();
+
+    hrc::time_point begin, end;
+    double tFullTotal = 0, tHybridTotal = 0;
+
+    // fast: points that kept their nearest-neighbour match
+    // agree: matches equal to those of the full HMM
+    os << "i,T,full,hybrid,fast,agree\n";
+
+    for(size_t i = 0; i < N; ++i){
+        std::cout << "i=" << i << "/" << N << std::endl;
+
+        const Trip &trip = trips[rand()%trips.size()];
+        const std::vector<Coord> &Y = trip.coords;
+
+        std::vector<DWGraph::node_t> matchesFull, matchesHybrid;
+        double tFull, tHybrid;
+        HiddenMarkovModelHybrid::stats_t stats0 = hybrid.getStats();
+        try {
+            begin = hrc::now();
+            matchesFull = hmm.getMatches(Y);
+            end = hrc::now();
+            tFull = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count());
+
+            begin = hrc::now();
+            matchesHybrid = hybrid.getMatches(Y);
+            end = hrc::now();
+            tHybrid = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count());
+        } catch(const std::exception &e){
+            std::cout << "Failed: " << e.what() << std::endl;
+            --i;
+            continue;
+        }
+        HiddenMarkovModelHybrid::stats_t stats1 = hybrid.getStats();
+        tFullTotal += tFull;
+        tHybridTotal += tHybrid;
+
+        size_t agree = 0;
+        for(size_t t = 0; t < Y.size(); ++t)
+            agree += (matchesFull[t] == matchesHybrid[t]);
+
+        os << i << "," << Y.size() << ","
+           << std::setprecision(0) << tFull << "," << tHybrid << ","
+           << stats1.fastPoints - stats0.fastPoints << "," << agree << "\n";
+    }
+
+    HiddenMarkovModelHybrid::stats_t stats = hybrid.getStats();
+    std::cout << "Fast path: " << 100.0*double(stats.fastPoints)/double(std::max(size_t(1), stats.points)) << "% of points, "
+        << stats.windows << " HMM windows; speedup " << tFullTotal/std::max(1.0, tHybridTotal) << "x" << std::endl;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+/**
+ * @brief Counts the searches of another ShortestPathFew.
+ */
+class CountingShortestPathFew : public ShortestPathFew {
+private:
+    ShortestPathFew &shortestPathFew;
+public:
+    size_t runs = 0;
+    CountingShortestPathFew(ShortestPathFew &shortestPathFew_): shortestPathFew(shortestPathFew_){}
+    virtual void initialize(const DWGraph::DWGraph *G, DWGraph::node_t s, std::list<DWGraph::node_t> d){ shortestPathFew.initialize(G, s, d); }
+    virtual void initialize(const DWGraph::DWGraph *G, DWGraph::node_t s, std::list<DWGraph::node_t> d, DWGraph::weight_t dMax){ shortestPathFew.initialize(G, s, d, dMax); }
+    virtual DWGraph::node_t getStart() const { return shortestPathFew.getStart(); }
+    virtual std::list<DWGraph::node_t> getDest() const { return shortestPathFew.getDest(); }
+    virtual void run(){ ++runs; shortestPathFew.run(); }
+    virtual DWGraph::node_t getPrev(DWGraph::node_t u) const { return shortestPathFew.getPrev(u); }
+    virtual DWGraph::weight_t getPathWeight(DWGraph::node_t u) const { return shortestPathFew.getPathWeight(u); }
+    virtual bool hasVisited(DWGraph::node_t u) const { return shortestPathFew.hasVisited(u); }
+};
+
+void evalHMM_Lazy(const MapGraph &M, const std::vector<Trip> &trips){
+    std::ofstream os("eval/hmm-lazy.csv");
+    os << std::fixed;
+
+    const size_t N = 1000;
+    const double d = 50;
+    const double sigma_z = 4.07;
+    const double beta = 3;
+
+    MapGraph G = M.splitLongEdges(30.0);
+
+    VStripesRadius closestPointsInRadius;
+    AstarFew astarFew(G.getNodes(), METERS_TO_MILLIMS, 650*METERS_TO_MILLIMS);
+    CountingShortestPathFew eagerSearches(astarFew), lazySearches(astarFew);
+    HiddenMarkovModel eager(closestPointsInRadius, eagerSearches, d, sigma_z, beta, 0, fINF, false);
+    HiddenMarkovModel lazy (closestPointsInRadius, lazySearches , d, sigma_z, beta, 0, fINF, true );
+    eager.initialize(&G);
+    lazy .initialize(&G);
+    lazy .run();
+
+    hrc::time_point begin, end;
+
+    os << "i,T,eager,lazy,searchesEager,searchesLazy,agree\n";
+
+    for(size_t i = 0; i < N; ++i){
+        std::cout << "i=" << i << "/" << N << std::endl;
+
+        const Trip &trip = trips[rand()%trips.size()];
+        const std::vector<Coord> &Y = trip.coords;
+
+        eagerSearches.runs = lazySearches.runs = 0;
+        std::vector<DWGraph::node_t> matchesEager, matchesLazy;
+        double tEager, tLazy;
+        try {
+            begin = hrc::now();
+            matchesEager = eager.getMatches(Y);
+            end = hrc::now();
+            tEager = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count());
+
+            begin = hrc::now();
+            matchesLazy = lazy.getMatches(Y);
+            end = hrc::now();
+            tLazy = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count());
+        } catch(const std::exception &e){
+            std::cout << "Failed: " << e.what() << std::endl;
+            --i;
+            continue;
+        }
+
+        size_t agree = 0;
+        for(size_t t = 0; t < Y.size(); ++t)
+            agree += (matchesEager[t] == matchesLazy[t]);
+
+        os << i << "," << Y.size() << ","
+           << std::setprecision(0) << tEager << "," << tLazy << ","
+           << eagerSearches.runs << "," << lazySearches.runs << "," << agree << "\n";
+    }
+}
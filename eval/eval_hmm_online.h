@@ -0,0 +1,71 @@
+#pragma once
+
+void evalHMM_Online(const MapGraph &M, const std::vector<Trip> &trips){
+    std::ofstream os("eval/hmm-online.csv");
+    os << std::fixed;
+
+    const size_t N = 1000;
+    const double d = 50;
+    const double sigma_z = 4.07;
+    const double beta = 3;
+    const std::vector<size_t> lags = {2, 5, 10, 20, 1000000};
+
+    MapGraph G = M.splitLongEdges(30.0);
+
+    VStripesRadius closestPointsInRadius;
+    AstarFew shortestPathFew(G.getNodes(), METERS_TO_MILLIMS, 650*METERS_TO_MILLIMS);
+    HiddenMarkovModel hmm(closestPointsInRadius, shortestPathFew, d, sigma_z, beta);
+    hmm.initialize(&G);
+    hmm.run();
+
+    hrc::time_point begin, end;
+
+    os << "i,T,lag,batch,online,maxPush,maxWindow,agree\n";
+
+    for(size_t i = 0; i < N; ++i){
+        std::cout << "i=" << i << "/" << N << std::endl;
+
+        const Trip &trip = trips[rand()%trips.size()];
+        const std::vector<Coord> &Y = trip.coords;
+
+        std::vector<DWGraph::node_t> batch;
+        double tBatch;
+        try {
+            begin = hrc::now();
+            batch = hmm.getMatches(Y);
+            end = hrc::now();
+            tBatch = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count());
+        } catch(const std::exception &e){
+            std::cout << "Failed: " << e.what() << std::endl;
+            --i;
+            continue;
+        }
+
+        for(const size_t &lag: lags){
+            HiddenMarkovModel::Session session(hmm, shortestPathFew, lag);
+            std::vector<DWGraph::node_t> online;
+            double tOnline = 0, maxPush = 0;
+            size_t maxWindow = 0;
+            for(const Coord &z: Y){
+                begin = hrc::now();
+                std::vector<DWGraph::node_t> matches = session.push(z);
+                end = hrc::now();
+                double dt = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count());
+                tOnline += dt;
+                maxPush = std::max(maxPush, dt);
+                maxWindow = std::max(maxWindow, session.getWindowSize());
+                online.insert(online.end(), matches.begin(), matches.end());
+            }
+            std::vector<DWGraph::node_t> matches = session.flush();
+            online.insert(online.end(), matches.begin(), matches.end());
+
+            size_t agree = 0;
+            for(size_t t = 0; t < Y.size(); ++t)
+                agree += (online.at(t) == batch.at(t));
+
+            os << i << "," << Y.size() << "," << lag << ","
+               << std::setprecision(0) << tBatch << "," << tOnline << "," << maxPush << ","
+               << maxWindow << "," << agree << "\n";
+        }
+    }
+}
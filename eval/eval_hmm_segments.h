@@ -0,0 +1,70 @@
+#pragma once
+
+void evalHMM_Segments(const MapGraph &M, const std::vector<Trip> &trips){
+    std::ofstream os("eval/hmm-segments.csv");
+    os << std::fixed;
+
+    const size_t N = 10000;
+    const double d = 50;
+
+    hrc::time_point begin, end; double dt;
+
+    // Candidates are nodes of the split graph
+    MapGraph G = M.splitLongEdges(30.0);
+    DWGraph::DWGraph distGraphNodes = getSCC(G);
+
+    std::list<Coord> l;
+    for(const DWGraph::node_t &u: distGraphNodes.getNodes()) l.push_back(G.nodeToCoord(u));
+
+    VStripesRadius closestPointsInRadius;
+    closestPointsInRadius.initialize(l, d);
+    closestPointsInRadius.run();
+
+    // Candidates are projections on segments of the original graph
+    DWGraph::DWGraph distGraphSegments = getSCC(M);
+
+    std::vector<ClosestSegmentsInRadius::segment_t> segments;
+    for(const MapGraph::way_t &w: M.getWays()){
+        if(w.nodes.size() < 2) continue;
+        auto it1 = w.nodes.begin();
+        for(auto it2 = it1++; it1 != w.nodes.end(); ++it1, ++it2){
+            if(distGraphSegments.hasNode(*it2) && distGraphSegments.hasNode(*it1))
+                segments.push_back(std::make_pair(M.nodeToCoord(*it2), M.nodeToCoord(*it1)));
+        }
+    }
+
+    SegmentRTree closestSegmentsInRadius;
+    closestSegmentsInRadius.initialize(segments, d);
+    closestSegmentsInRadius.run();
+
+    std::cout << "Nodes: " << distGraphNodes.getNodes().size() << " (split), "
+              << distGraphSegments.getNodes().size() << " (original); "
+              << "segments: " << segments.size() << std::endl;
+
+    os << "i,T,VStripes,K_VStripes,RTree,K_RTree\n";
+
+    for(size_t i = 0; i < N; ++i){
+        if(i%1000 == 0) std::cout << "i=" << i << "/" << N << std::endl;
+
+        const size_t idx = rand()%trips.size();
+        const std::vector<Coord> &Y = trips[idx].coords;
+        const size_t &T = Y.size();
+
+        os << i << "," << T;
+
+        std::vector<size_t> offsets, idxs;
+        begin = std::chrono::high_resolution_clock::now();
+        closestPointsInRadius.getClosestPointsMany(Y, offsets, idxs);
+        end = std::chrono::high_resolution_clock::now();
+        dt = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count());
+        os << "," << dt << "," << idxs.size();
+
+        std::vector<ClosestSegmentsInRadius::result_t> res;
+        begin = std::chrono::high_resolution_clock::now();
+        for(size_t t = 0; t < T; ++t)
+            closestSegmentsInRadius.getClosestSegments(Y.at(t), res);
+        end = std::chrono::high_resolution_clock::now();
+        dt = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count());
+        os << "," << dt << "," << res.size() << "\n";
+    }
+}
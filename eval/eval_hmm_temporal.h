@@ -0,0 +1,58 @@
+#pragma once
+
+void evalHMM_Temporal(const MapGraph &M, const std::vector<Trip> &trips){
+    std::ofstream os("eval/hmm-temporal.csv");
+    os << std::fixed;
+
+    const size_t N = 1000;
+    const double d = 50;
+    const double sigma_z = 4.07;
+    const double beta = 3;
+    const double maxSpeed = 120.0/3.6; // 120 km/h, in m/s
+
+    MapGraph G = M.splitLongEdges(30.0);
+
+    VStripesRadius closestPointsInRadius;
+    AstarFew shortestPathFew(G.getNodes(), METERS_TO_MILLIMS, 650*METERS_TO_MILLIMS);
+    HiddenMarkovModel hmm(closestPointsInRadius, shortestPathFew, d, sigma_z, beta, 0, fINF, true, maxSpeed);
+    hmm.initialize(&G);
+    hmm.run();
+
+    hrc::time_point begin, end;
+
+    os << "i,T,fixed,temporal,agree\n";
+
+    for(size_t i = 0; i < N; ++i){
+        std::cout << "i=" << i << "/" << N << std::endl;
+
+        const Trip &trip = trips[rand()%trips.size()];
+        const std::vector<Coord> &Y = trip.coords;
+
+        std::vector<DWGraph::node_t> matchesFixed, matchesTemporal;
+        double tFixed, tTemporal;
+        try {
+            // Without timestamps, searches are only capped at 650m
+            begin = hrc::now();
+            matchesFixed = hmm.getMatches(Y);
+            end = hrc::now();
+            tFixed = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count());
+
+            begin = hrc::now();
+            matchesTemporal = hmm.getMatches(Y, trip.getTimestamps());
+            end = hrc::now();
+            tTemporal = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count());
+        } catch(const std::exception &e){
+            std::cout << "Failed: " << e.what() << std::endl;
+            --i;
+            continue;
+        }
+
+        size_t agree = 0;
+        for(size_t t = 0; t < Y.size(); ++t)
+            agree += (matchesFixed[t] == matchesTemporal[t]);
+
+        os << i << "," << Y.size() << ","
+           << std::setprecision(0) << tFixed << "," << tTemporal << ","
+           << agree << "\n";
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+void evalSlab_RBArena(const MapGraph &M){
+    std::ofstream os("eval/slab-rb-arena.csv");
+    os << std::fixed;
+
+    std::unordered_map<DWGraph::node_t, Coord> nodes = M.getNodes();
+    std::vector<Vector2> points;
+    points.reserve(nodes.size());
+    for(const std::pair<const DWGraph::node_t, Coord> &p: nodes)
+        points.push_back(Vector2(p.second.lon(), p.second.lat()));
+    std::shuffle(points.begin(), points.end(), std::mt19937(4));
+
+    const size_t N = 100000;
+
+    std::vector<size_t> szs;
+    for(size_t sz = 1000; sz < points.size(); sz *= 2)
+        szs.push_back(sz);
+    szs.push_back(points.size());
+
+    os << "n,edges,buildRB,buildRBArena,queryRB,queryRBArena,arenaMem\n";
+
+    for(const size_t &sz: szs){
+        std::cout << "Size: " << sz << std::endl;
+
+        std::vector<Vector2> s(points.begin(), points.begin() + sz);
+        VoronoiDiagram diagram = FortuneAlgorithm(s).construct();
+
+        // Sites on the bounding box may not be answered, so queries are the
+        // sites both decompositions answer
+        std::vector<Vector2> queries;
+        {
+            SlabDecompositionRB slab;
+            slab.initialize(diagram);
+            slab.run();
+            for(size_t i = 0; i < N; ++i){
+                const Vector2 &q = s[i%s.size()];
+                try { slab.getClosestPoint(q); }
+                catch(const std::runtime_error &e) { continue; }
+                queries.push_back(q);
+            }
+        }
+
+        hrc::time_point begin, end;
+
+        os << sz << "," << diagram.getEdges().size() << std::setprecision(0);
+
+        double tBuildRB, tBuildRBArena, tQueryRB, tQueryRBArena;
+        size_t arenaMem;
+        {
+            SlabDecompositionRB slab;
+            begin = hrc::now();
+            slab.initialize(diagram);
+            slab.run();
+            end = hrc::now();
+            tBuildRB = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count());
+
+            begin = hrc::now();
+            for(const Vector2 &q: queries) slab.getClosestPoint(q);
+            end = hrc::now();
+            tQueryRB = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count())/double(queries.size());
+        }
+        {
+            SlabDecompositionRBArena slab;
+            begin = hrc::now();
+            slab.initialize(diagram);
+            slab.run();
+            end = hrc::now();
+            tBuildRBArena = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count());
+
+            begin = hrc::now();
+            for(const Vector2 &q: queries) slab.getClosestPoint(q);
+            end = hrc::now();
+            tQueryRBArena = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count())/double(queries.size());
+
+            arenaMem = slab.getTreeMemoryUsage();
+        }
+
+        os << "," << tBuildRB << "," << tBuildRBArena
+           << "," << tQueryRB << "," << tQueryRBArena
+           << "," << arenaMem << "\n";
+    }
+}
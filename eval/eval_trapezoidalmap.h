@@ -0,0 +1,96 @@
+#pragma once
+
+/**
+ * @brief Time building a decomposition and answering queries with it.
+ *
+ * @return Build time (ns) and mean query time (ns)
+ */
+template<class T>
+std::pair<double, double> evalTrapezoidalMap_Decomposition(T &decomposition, const VoronoiDiagram &diagram, const std::vector<Vector2> &queries){
+    hrc::time_point begin, end;
+
+    begin = hrc::now();
+    decomposition.initialize(diagram);
+    decomposition.run();
+    end = hrc::now();
+    double tBuild = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count());
+
+    begin = hrc::now();
+    for(const Vector2 &q: queries) decomposition.getClosestPoint(q);
+    end = hrc::now();
+    double tQuery = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count())/double(queries.size());
+
+    return std::make_pair(tBuild, tQuery);
+}
+
+void evalTrapezoidalMap(const MapGraph &M){
+    std::ofstream os("eval/trapezoidal-map.csv");
+    os << std::fixed << std::setprecision(0);
+
+    std::unordered_map<DWGraph::node_t, Coord> nodes = M.getNodes();
+    std::vector<Vector2> points;
+    points.reserve(nodes.size());
+    for(const std::pair<const DWGraph::node_t, Coord> &p: nodes)
+        points.push_back(Vector2(p.second.lon(), p.second.lat()));
+    std::shuffle(points.begin(), points.end(), std::mt19937(4));
+
+    const size_t N = 100000;
+    // SlabDecomposition keeps every slab in full, O(n^2) memory
+    const size_t MAX_SLAB = 32000;
+
+    std::vector<size_t> szs;
+    for(size_t sz = 1000; sz < points.size(); sz *= 2)
+        szs.push_back(sz);
+    szs.push_back(points.size());
+
+    os << "n,edges,"
+       << "buildSlab,querySlab,"
+       << "buildSlabRB,querySlabRB,"
+       << "buildSlabRBArena,querySlabRBArena,"
+       << "buildTrapezoidalMap,queryTrapezoidalMap,memTrapezoidalMap\n";
+
+    for(const size_t &sz: szs){
+        std::cout << "Size: " << sz << std::endl;
+
+        std::vector<Vector2> s(points.begin(), points.begin() + sz);
+        VoronoiDiagram diagram = FortuneAlgorithm(s).construct();
+
+        // Sites on the bounding box may not be answered by slabs, so queries
+        // are the sites every decomposition answers
+        std::vector<Vector2> queries;
+        {
+            SlabDecompositionRBArena slab;
+            slab.initialize(diagram);
+            slab.run();
+            for(size_t i = 0; i < N; ++i){
+                const Vector2 &q = s[i%s.size()];
+                try { slab.getClosestPoint(q); }
+                catch(const std::runtime_error &e) { continue; }
+                queries.push_back(q);
+            }
+        }
+
+        os << sz << "," << diagram.getEdges().size();
+
+        if(sz <= MAX_SLAB){
+            SlabDecomposition slab;
+            std::pair<double, double> t = evalTrapezoidalMap_Decomposition(slab, diagram, queries);
+            os << "," << t.first << "," << t.second;
+        } else os << ",,";
+        {
+            SlabDecompositionRB slab;
+            std::pair<double, double> t = evalTrapezoidalMap_Decomposition(slab, diagram, queries);
+            os << "," << t.first << "," << t.second;
+        }
+        {
+            SlabDecompositionRBArena slab;
+            std::pair<double, double> t = evalTrapezoidalMap_Decomposition(slab, diagram, queries);
+            os << "," << t.first << "," << t.second;
+        }
+        {
+            TrapezoidalMap map;
+            std::pair<double, double> t = evalTrapezoidalMap_Decomposition(map, diagram, queries);
+            os << "," << t.first << "," << t.second << "," << map.getMemoryUsage() << "\n";
+        }
+    }
+}
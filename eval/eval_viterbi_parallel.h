@@ -0,0 +1,59 @@
+#pragma once
+
+void evalViterbiParallel(){
+    std::ofstream os("eval/viterbi-parallel.csv");
+    os << std::fixed;
+
+    const std::vector<size_t> Ts = {500, 1000, 2000, 5000, 10000, 20000};
+    const std::vector<size_t> Ks = {4, 8, 16};
+    const std::vector<size_t> threads = {1, 2, 4, 8, 16};
+    const size_t REPS = 5;
+
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<double> logProb(-20.0, 0.0);
+
+    hrc::time_point begin, end;
+
+    // Random log scores, K states per step, as a very long trip would have
+    os << "T,K,threads,sequential,parallel,agree\n";
+
+    for(const size_t &K: Ks){
+        for(const size_t &T: Ts){
+            ViterbiLog::Scores scores;
+            for(size_t t = 0; t < T; ++t){
+                scores.addStep(K);
+                for(size_t j = 0; j < K; ++j) scores.emission(t)[j] = logProb(gen);
+                if(t == 0) continue;
+                const size_t stride = scores.getStride(t);
+                for(size_t i = 0; i < K; ++i)
+                    for(size_t j = 0; j < K; ++j)
+                        scores.transition(t)[i*stride + j] = logProb(gen);
+            }
+
+            for(const size_t &nThreads: threads){
+                std::cout << "K=" << K << ", T=" << T << ", threads=" << nThreads << std::endl;
+                for(size_t r = 0; r < REPS; ++r){
+                    begin = hrc::now();
+                    ViterbiLog viterbiLog;
+                    viterbiLog.initialize(&scores);
+                    viterbiLog.run();
+                    std::vector<size_t> expected = viterbiLog.getLikeliestPath();
+                    end = hrc::now();
+                    double tSequential = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count());
+
+                    begin = hrc::now();
+                    ViterbiParallel viterbiParallel(nThreads, 0);
+                    viterbiParallel.initialize(&scores);
+                    viterbiParallel.run();
+                    std::vector<size_t> path = viterbiParallel.getLikeliestPath();
+                    end = hrc::now();
+                    double tParallel = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count());
+
+                    os << T << "," << K << "," << nThreads << ","
+                       << std::setprecision(0) << tSequential << "," << tParallel << ","
+                       << (path == expected) << "\n";
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+void evalVoronoi_BuildTime(const MapGraph &M){
+    std::ofstream os("eval/voronoi-buildtime.csv");
+    os << std::fixed;
+
+    std::unordered_map<DWGraph::node_t, Coord> nodes = M.getNodes();
+    std::vector<Vector2> points;
+    points.reserve(nodes.size());
+    for(const std::pair<const DWGraph::node_t, Coord> &p: nodes)
+        points.push_back(Vector2(p.second.lon(), p.second.lat()));
+    std::shuffle(points.begin(), points.end(), std::mt19937(4));
+
+    const size_t REPEAT = 3;
+
+    std::vector<size_t> szs;
+    for(size_t sz = 1000; sz < points.size(); sz *= 2)
+        szs.push_back(sz);
+    szs.push_back(points.size());
+
+    os << "n,t,delaunay\n";
+
+    for(const size_t &sz: szs){
+        std::cout << "Size: " << sz << std::endl;
+
+        std::vector<Vector2> s(points.begin(), points.begin() + sz);
+
+        size_t delaunayEdges = 0;
+
+        hrc::time_point begin, end;
+
+        begin = hrc::now();
+        for(size_t i = 0; i < REPEAT; ++i){
+            VoronoiDiagram diagram = FortuneAlgorithm(s).construct();
+            delaunayEdges = diagram.getDelaunayEdges().size();
+        }
+        end = hrc::now();
+
+        double dt = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count())/double(REPEAT);
+        os << sz << "," << std::setprecision(0) << dt << "," << delaunayEdges << "\n";
+    }
+}
+
+void evalVoronoi_Tiled(const MapGraph &M){
+    std::ofstream os("eval/voronoi-tiled.csv");
+    os << std::fixed;
+
+    std::unordered_map<DWGraph::node_t, Coord> nodes = M.getNodes();
+    std::vector<Vector2> points;
+    points.reserve(nodes.size());
+    for(const std::pair<const DWGraph::node_t, Coord> &p: nodes)
+        points.push_back(Vector2(p.second.lon(), p.second.lat()));
+    std::shuffle(points.begin(), points.end(), std::mt19937(4));
+
+    const size_t REPEAT = 3;
+    const std::vector<size_t> threads = {1, 2, 4, 8, 16};
+
+    std::vector<size_t> szs;
+    for(size_t sz = 1000; sz < points.size(); sz *= 2)
+        szs.push_back(sz);
+    szs.push_back(points.size());
+
+    os << "n,threads,t,border\n";
+
+    for(const size_t &sz: szs){
+        std::cout << "Size: " << sz << std::endl;
+
+        std::vector<Vector2> s(points.begin(), points.begin() + sz);
+
+        for(const size_t &nThreads: threads){
+            size_t borderSites = 0;
+
+            hrc::time_point begin, end;
+
+            begin = hrc::now();
+            for(size_t i = 0; i < REPEAT; ++i){
+                FortuneAlgorithmTiled fortune(s, nThreads);
+                VoronoiDiagram diagram = fortune.construct();
+                borderSites = fortune.getBorderSites();
+            }
+            end = hrc::now();
+
+            double dt = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count())/double(REPEAT);
+            os << sz << "," << nThreads << "," << std::setprecision(0) << dt << "," << borderSites << "\n";
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+void evalVoronoiGrid_QueryTime(const MapGraph &M, const std::vector<Trip> &trips){
+    std::ofstream os("eval/voronoi-grid-querytime.csv");
+    os << std::fixed << std::setprecision(3);
+
+    const auto &nodes = M.getNodes();
+    std::vector<Coord> coords(nodes.size());
+    {
+        size_t i = 0;
+        for(const auto &p: nodes)
+            coords[i++] = p.second;
+    }
+    std::shuffle(coords.begin(), coords.end(), std::mt19937(4));
+
+    std::vector<Coord> candidates;
+    for(const Trip &r: trips)
+        for(const Coord &c: r.coords)
+            candidates.push_back(c);
+
+    const size_t N = 100000;
+    const size_t REPEAT = 10;
+
+    std::vector<Coord> test_coords(N);
+    for(size_t i = 0; i < N; ++i)
+        test_coords[i] = candidates[rand()%candidates.size()];
+
+    std::vector<size_t> szs;
+    for(size_t sz = 1000; sz < coords.size(); sz *= 2)
+        szs.push_back(sz);
+    szs.push_back(coords.size());
+
+    os << "n,DeepVStripes,K2DTree,VoronoiGrid,memVoronoiGrid\n";
+
+    for(const size_t &sz: szs){
+        std::cout << "Size: " << sz << std::endl;
+
+        std::list<Vector2> l(coords.begin(), coords.begin() + sz);
+
+        DeepVStripes deepVStripes(0.0003, 12);
+        deepVStripes.initialize(l);
+        deepVStripes.run();
+
+        K2DTreeClosestPoint k2DTree;
+        k2DTree.initialize(l);
+        k2DTree.run();
+
+        VoronoiGrid voronoiGrid;
+        voronoiGrid.initialize(l);
+        voronoiGrid.run();
+
+        os << sz;
+
+        for(const ClosestPoint *closestPoint: std::vector<const ClosestPoint*>{&deepVStripes, &k2DTree, &voronoiGrid}){
+            hrc::time_point begin = hrc::now();
+            for(size_t k = 0; k < REPEAT; ++k)
+                for(const Coord &u: test_coords)
+                    closestPoint->getClosestPointIdx(u);
+            hrc::time_point end = hrc::now();
+            double dt = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end-begin).count())/double(N*REPEAT);
+            os << "," << dt;
+        }
+
+        os << "," << voronoiGrid.getMemoryUsage() << "\n";
+    }
+}
@@ -14,9 +14,12 @@
 #include "FortuneAlgorithm.h"
 #include "HiddenMarkovModel.h"
 #include "HiddenMarkovModelMany.h"
+#include "HiddenMarkovModelSegments.h"
 #include "K2DTreeClosestPointFactory.h"
 #include "DeepVStripesFactory.h"
+#include "SegmentRTree.h"
 #include "VStripesRadius.h"
+#include "VoronoiGridFactory.h"
 
 #include "DraggableZoomableWindow.h"
 #include "MapView.h"
@@ -52,17 +55,17 @@ void view(const MapGraph& M, const std::vector<polygon_t>& polygons) {
 }
 
 VoronoiDiagram voronoi(const MapGraph& M) {
-    std::vector<Site*> sites;
-    Box box = Box(Vector2(-8.67188, 41.149), Vector2(-8.6715, 41.15));
+    std::vector<Vector2> sites;
 
-    for (std::pair<const DWGraph::node_t, Coord> node : M.getNodes()) {
-        Vector2 point = Vector2(node.second.lon(), node.second.lat());
-
-        if (box.contains(point))
-            sites.push_back(new Site{ point });
-    }
+    for (std::pair<const DWGraph::node_t, Coord> node : M.getNodes())
+        sites.push_back(Vector2(node.second.lon(), node.second.lat()));
 
+    std::cout << "Building Voronoi diagram of " << sites.size() << " sites..." << std::endl;
+    hrc::time_point begin = hrc::now();
     VoronoiDiagram diagram = FortuneAlgorithm(sites).construct();
+    hrc::time_point end = hrc::now();
+    double dt = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()) * double(NANOS_TO_SECS);
+    std::cout << "Took " << dt << "s to build Voronoi diagram" << std::endl;
 
     return diagram;
 }
@@ -112,9 +115,7 @@ void match_trip_nn(const MapGraph& M, const std::vector<polygon_t>& polygons, co
     std::cout << "Generated time graph" << std::endl;
 
     std::cout << "Computing map matching..." << std::endl;
-    const double delta = 0.0003;
-    const size_t L = 12;
-    DeepVStripesFactory closestPointFactory(delta, L);
+    VoronoiGridFactory closestPointFactory;
     MapMatching::FromClosestPoint mapMatching(closestPointFactory);
     mapMatching.initialize(&G);
     mapMatching.run();
@@ -172,41 +173,83 @@ void match_trip(const MapGraph& M, const std::vector<polygon_t>& polygons, const
     windowTripController.run();
 }
 
-void match_all_trips(const MapGraph& M, std::vector<Trip>& trips) {
+void match_trip_segments(const MapGraph& M, const std::vector<polygon_t>& polygons, const std::vector<Trip>& trips) {
+    std::cout << "Generating time graph..." << std::endl;
+    DWGraph::DWGraph dwG = M.getTimeGraph();
+    std::cout << "Generated time graph" << std::endl;
+
+    std::cout << "Computing map matching..." << std::endl;
+    double d = 50; // in meters
+    double sigma_z = 4.07; // in meters
+    double beta = 3; // From https://www.mapzen.com/blog/data-driven-map-matching/
+    SegmentRTree closestSegmentsInRadius;
+    AstarFew shortestPathFew(M.getNodes(), METERS_TO_MILLIMS, 650 * METERS_TO_MILLIMS);
+    HiddenMarkovModelSegments mapMatching(closestSegmentsInRadius, shortestPathFew, d, sigma_z, beta);
+    mapMatching.initialize(&M);
+    mapMatching.run();
+
+    DraggableZoomableWindow window(sf::Vector2f(0, 0)); window.setBackgroundColor(sf::Color(170, 211, 223));
+    MapView mapView(Coord(41.1594, -8.6199), 20000000);
+    MapTerrainOsmView mapTerrainOsmView(window, mapView, polygons);
+    MapGraphOsmView mapGraphOsmView(window, mapView, M);
+    MapTripMatchView mapTripMatchView(window, mapView);
+    mapView.addView(&mapTerrainOsmView);
+    mapView.addView(&mapGraphOsmView);
+    mapView.addView(&mapTripMatchView);
+    window.setDrawView(&mapView);
+
+    WindowTripController windowTripController(window, mapTripMatchView, M, dwG, trips, mapMatching);
+    windowTripController.run();
+}
+
+void match_all_trips(const MapGraph& M) {
     MapGraph G = M.splitLongEdges(30.0);
-    VStripesRadius closestPointsInRadius;
+    VStripesRadius vstripesRadius;
+    const double q = 2.0; // Cache cell size, in meters
+    const size_t cacheBytes = size_t(2) << 30;
+    ClosestPointsInRadius::Cache closestPointsInRadius(vstripesRadius, q, cacheBytes);
 
     const double d = 50.0;
     double sigma_z = 5.925232; // in meters
     double beta = 6.677601;
     const size_t nThreads = 8;
+    const double maxSpeed = 120.0 / 3.6; // 120 km/h, in m/s
 
-    HiddenMarkovModelMany hmm(closestPointsInRadius, d, sigma_z, beta, nThreads);
-    hmm.initialize(&G, trips);
-    hmm.run();
+    // Route distances between candidates, shared by all trips
+    const size_t distanceCacheBytes = size_t(4) << 30;
+    ShortestPathAll::Cache distanceCache(DWGraph::weight_t(650 * METERS_TO_MILLIMS), distanceCacheBytes);
 
-    if (!fs::exists("res/matched"))
-        fs::create_directories("res/matched");
+    HiddenMarkovModelMany hmm(closestPointsInRadius, d, sigma_z, beta, nThreads, maxSpeed, &distanceCache);
+    hmm.initialize(&G);
+    hmm.prepare();
 
-    std::ofstream os("res/matched/matched.txt");
-
-    size_t index = 0;
-    for (const Trip& trip : trips) {
-        if (index % 100000 == 0) std::cout << "Index: " << index << std::endl;
-        ++index;
-        try {
-            const std::vector<DWGraph::node_t>& matches = hmm.getMatches(trip.id);
-            os << trip.id << " " << matches.size() << "\n";
-            for (const DWGraph::node_t& u : matches) {
-                os << u << "\n";
-            }
-        }
-        catch (const std::exception& e) {
+    // Trips are streamed from disk, so only a few chunks are in memory at once
+    const std::string tripsPath = "res/data/pkdd15-i/pkdd15-i.trips.bin";
+    Trip::Reader reader(tripsPath);
+    std::cout << "Total number of trips: " << reader.size() << std::endl;
 
-        }
-    }
+    if (!fs::exists("res/matched"))
+        fs::create_directories("res/matched");
 
-    os.close();
+    // Matches are committed in segments; if a previous run was interrupted,
+    // the trips it committed are skipped
+    const size_t segmentSize = 20000;
+    HiddenMarkovModelMany::Checkpoint checkpoint("res/matched", segmentSize, tripsPath, reader.size());
+
+    const size_t chunkSize = 1000;
+    const size_t maxChunks = 4 * nThreads;
+    HiddenMarkovModelMany::Pipeline pipeline(hmm, nThreads, chunkSize, maxChunks);
+    pipeline.run(reader, checkpoint);
+
+    ClosestPointsInRadius::Cache::stats_t stats = closestPointsInRadius.getStats();
+    std::cout << "Candidate cache: " << stats.hits << " hits, " << stats.misses << " misses ("
+        << 100.0 * double(stats.hits) / double(std::max(size_t(1), stats.hits + stats.misses)) << "% hit rate), "
+        << stats.hitTime << "s in hits, " << stats.missTime << "s in misses" << std::endl;
+
+    ShortestPathAll::Cache::stats_t distanceStats = distanceCache.getStats();
+    std::cout << "Distance cache: " << distanceStats.hits << " hits, " << distanceStats.misses << " misses ("
+        << 100.0 * double(distanceStats.hits) / double(std::max(size_t(1), distanceStats.hits + distanceStats.misses)) << "% hit rate), "
+        << distanceStats.searches << " searches, " << distanceStats.evictions << " evictions" << std::endl;
 }
 
 void view_clusters(const MapGraph& map_graph) {
@@ -264,6 +307,7 @@ int main(int argc, char* argv[]) {
         if (opt == "view") { view(M, polygons); return 0; }
         if (opt == "voronoi") { voronoi(M); return 0; }
         if (opt == "voronoi-display") { voronoi_display(M); return 0; }
+        if (opt == "match-all-trips") { match_all_trips(M); return 0; }
 
         std::cout << "Loading trips..." << std::endl;
         begin = hrc::now();
@@ -275,8 +319,7 @@ int main(int argc, char* argv[]) {
         if (opt == "view-trips") { view_trips(trips); return 0; }
         if (opt == "match-trip-nn") { match_trip_nn(M, polygons, trips); return 0; }
         if (opt == "match-trip") { match_trip(M, polygons, trips); return 0; }
-
-        if (opt == "match-all-trips") { match_all_trips(M, trips); return 0; }
+        if (opt == "match-trip-segments") { match_trip_segments(M, polygons, trips); return 0; }
 
         if (opt == "view-clusters") {
             view_clusters(M);
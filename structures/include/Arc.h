@@ -2,29 +2,32 @@
 #define ARC
 
 #include "Edge.h"
-#include "Event.h"
 #include "Site.h"
 
-class Event;
-
 class Arc {
 public:
     // Double linked list
-    Arc* previous = nullptr;
-    Arc* next = nullptr;
+    Voronoi::idx_t previous = Voronoi::INVALID_IDX;
+    Voronoi::idx_t next = Voronoi::INVALID_IDX;
+
+    // Beach line search tree (see BeachLine)
+    Voronoi::idx_t parent = Voronoi::INVALID_IDX;
+    Voronoi::idx_t left = Voronoi::INVALID_IDX;
+    Voronoi::idx_t right = Voronoi::INVALID_IDX;
+    unsigned priority = 0;
 
-    Edge* s0 = nullptr; // Left edge
-    Edge* s1 = nullptr; // Right edge
+    Voronoi::idx_t s0 = Voronoi::INVALID_IDX; // Left edge
+    Voronoi::idx_t s1 = Voronoi::INVALID_IDX; // Right edge
 
-    Site* site;
-    Event* event = nullptr;
+    Voronoi::idx_t site;
+    Vector2 focus; // Position of site, kept here for the beach line search
+    Voronoi::idx_t event = Voronoi::INVALID_IDX;
 
-    Arc(Site* site);
-    Arc(Site* site, Arc* previous, Arc* next);
+    Arc(Voronoi::idx_t site, Vector2 focus);
 
-    Vector2 getPoint(double x, double sweep_line);
-    Vector2 intersect(Arc arc, double sweep_line);
-    Vector2 intersect(Edge edge, double sweep_line);
+    Vector2 getPoint(double x, double sweep_line) const;
+    Vector2 intersect(const Arc& arc, double sweep_line) const;
+    Vector2 intersect(const Edge &edge, double sweep_line) const;
 };
 
-#endif
\ No newline at end of file
+#endif
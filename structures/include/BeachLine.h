@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Arc.h"
+
+#include <vector>
+
+/**
+ * @brief Beach line of Fortune's algorithm.
+ *
+ * Arcs live in an arena owned by the beach line and are addressed by index;
+ * slots of removed arcs are reused. Arcs are kept both in a doubly linked
+ * list (Arc::previous, Arc::next) and in a treap (Arc::parent, Arc::left,
+ * Arc::right) with the same in-order sequence. The tree is not keyed by a
+ * stored value; the search compares x against the breakpoints of each arc
+ * with its neighbours at the current sweep line, which preserves the order
+ * of the arcs as the sweep advances. All operations take O(log n) expected
+ * time.
+ */
+class BeachLine {
+private:
+    std::vector<Arc> arcs;
+    std::vector<Voronoi::idx_t> free_arcs;
+    Voronoi::idx_t root = Voronoi::INVALID_IDX;
+    unsigned seed = 2463534242u;
+
+    unsigned nextPriority();
+
+    void rotateUp(Voronoi::idx_t arc);
+    void replaceChild(Voronoi::idx_t parent, Voronoi::idx_t old_child, Voronoi::idx_t new_child);
+    void siftUp(Voronoi::idx_t arc);
+public:
+    Arc& operator[](Voronoi::idx_t arc);
+    const Arc& operator[](Voronoi::idx_t arc) const;
+
+    /**
+     * @brief Allocate an arc, not yet in the beach line.
+     *
+     * May reallocate the arena, invalidating references to arcs.
+     */
+    Voronoi::idx_t createArc(Voronoi::idx_t site, Vector2 focus);
+
+    /**
+     * @brief Free an arc that is not in the beach line.
+     */
+    void destroyArc(Voronoi::idx_t arc);
+
+    bool empty() const;
+
+    /**
+     * @brief Set the first arc of an empty beach line.
+     */
+    void insert(Voronoi::idx_t arc);
+
+    /**
+     * @brief Insert arc right before/after pos.
+     */
+    void insertBefore(Voronoi::idx_t pos, Voronoi::idx_t arc);
+    void insertAfter(Voronoi::idx_t pos, Voronoi::idx_t arc);
+
+    /**
+     * @brief Put arc in the place of old_arc, which is removed from the
+     * beach line but not freed.
+     */
+    void replace(Voronoi::idx_t old_arc, Voronoi::idx_t arc);
+
+    /**
+     * @brief Remove arc from the beach line, linking its neighbours. The
+     * arc is not freed.
+     */
+    void erase(Voronoi::idx_t arc);
+
+    /**
+     * @brief Find the arc above x, for a sweep line at sweep_line.
+     */
+    Voronoi::idx_t locate(double x, double sweep_line) const;
+
+    /**
+     * @brief Leftmost arc, or Voronoi::INVALID_IDX if empty.
+     */
+    Voronoi::idx_t front() const;
+};
@@ -15,6 +15,6 @@ public:
     Box(Vector2 bottom_left, Vector2 upper_right);
     Box(double width, double height);
 
-    bool intersect(Edge edge, Vector2& intersection);
-    bool contains(Vector2 point);
+    bool intersect(const Edge &edge, Vector2& intersection) const;
+    bool contains(Vector2 point) const;
 };
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "Vector2.h"
 
+#include <cstddef>
 #include <functional>
 
 class Coord : public Vector2 {
@@ -23,6 +24,18 @@ public:
     static double getDistanceArc(const Coord   &p1, const Coord   &p2);
     static double getDistanceArc(const Vector2 &p1, const Vector2 &p2);
     static double getDistanceArcSimple(const Coord &p1, const Coord &p2);
+
+    /**
+     * @brief Get distances from one position to many, in meters; same as
+     * getDistanceArc, as one loop over contiguous arrays.
+     *
+     * @param p     Position
+     * @param lat   Latitudes of the other positions
+     * @param lon   Longitudes of the other positions
+     * @param n     Number of other positions
+     * @param d     Output distances
+     */
+    static void getDistanceArcMany(const Coord &p, const double *lat, const double *lon, size_t n, double *d);
     
     double &lat();
     double &lon();
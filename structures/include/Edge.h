@@ -3,6 +3,8 @@
 #include "Site.h"
 #include "Vector2.h"
 
+#include <vector>
+
 struct Site;
 
 class Edge {
@@ -13,18 +15,33 @@ public:
     double m; // Gradient
     double c; // Y-axis intercept
     Vector2 direction;
-    Edge* adjacent = nullptr;
-    Site* site_up;
-    Site* site_down;
+    Voronoi::idx_t adjacent = Voronoi::INVALID_IDX;  // Index of twin edge
+    Voronoi::idx_t site_up = Voronoi::INVALID_IDX;   // Index of site above
+    Voronoi::idx_t site_down = Voronoi::INVALID_IDX; // Index of site below
 
     Edge();
     Edge(Vector2 _start, Vector2 _end, bool _finished=true);
     Edge(Vector2 start, Vector2 leftpoint, Vector2 rightpoint);
-    Edge(Vector2 start, Site* site_1, Site* site_2);
 
-    bool intersect(Edge edge, Vector2& intersection);
-    Edge merge();
+    /**
+     * @brief Bisector of two sites, starting at start.
+     *
+     * @param start     Starting point
+     * @param sites     Sites of the diagram
+     * @param site_1    Index of the left site
+     * @param site_2    Index of the right site
+     */
+    Edge(Vector2 start, const std::vector<Site> &sites, Voronoi::idx_t site_1, Voronoi::idx_t site_2);
+
+    bool intersect(const Edge &edge, Vector2& intersection) const;
+
+    /**
+     * @brief Join this edge with its twin, if finished.
+     *
+     * @param edges     Edges this edge and its twin were taken from
+     */
+    Edge merge(const std::vector<Edge> &edges) const;
     double evaluateY(double x) const;
     
     bool operator==(const Edge& edge) const;
-};
\ No newline at end of file
+};
@@ -1,10 +1,8 @@
 #ifndef EVENT
 #define EVENT
 
-#include "Arc.h"
-#include "VoronoiDiagram.h"
-
-class Arc;
+#include "Site.h"
+#include "Vector2.h"
 
 class Event {
 public:
@@ -18,17 +16,17 @@ public:
     Vector2 point;
 
     // Site event
-    Site* site;
+    Voronoi::idx_t site = Voronoi::INVALID_IDX;
 
     // Circle event
-    Arc* arc;
-    double radius;
+    Voronoi::idx_t arc = Voronoi::INVALID_IDX;
+    double radius = 0;
 
     bool operator<(const Event &event) const;
     bool operator==(const Event &event) const;
 public:
-    Event(Site* site);                               // Site event
-    Event(Arc* arc, Vector2 point, double radius);   // Circle event
+    Event(Voronoi::idx_t site, Vector2 point);                // Site event
+    Event(Voronoi::idx_t arc, Vector2 point, double radius);  // Circle event
 };
 
-#endif
\ No newline at end of file
+#endif
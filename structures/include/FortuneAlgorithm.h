@@ -1,16 +1,32 @@
+#pragma once
+
+#include "BeachLine.h"
 #include "Event.h"
 #include "VoronoiDiagram.h"
 
-#include <set>
 #include <vector>
 
+/**
+ * @brief Fortune's sweep line algorithm for the Voronoi diagram.
+ *
+ * Arcs, edges and circle events are allocated from arrays owned by the
+ * algorithm and addressed by index, so tearing it down frees a handful of
+ * blocks regardless of the number of sites.
+ */
 class FortuneAlgorithm {
 private:
+    struct EventComparator {
+        const std::vector<Event>* circle_events;
+
+        bool operator()(Voronoi::idx_t lhs, Voronoi::idx_t rhs) const;
+    };
+
     VoronoiDiagram diagram;
-    std::vector<Edge*> edges;
-    std::priority_queue<Event> events;
-    std::set<Event> invalid_events;
-    std::vector<Arc*> arcs; // List of parabolas
+    std::vector<Edge> edges; // Unclipped edges
+    std::vector<Event> circle_events;
+    std::vector<Voronoi::idx_t> free_events;
+    std::priority_queue<Voronoi::idx_t, std::vector<Voronoi::idx_t>, EventComparator> events; // Pending circle events
+    BeachLine beach_line; // Parabolas
     double sweep_line = 0; // Current y-position of sweep line
 
     // Limits for bounding box
@@ -21,15 +37,17 @@ private:
 
     Box bounding_box;
 
-    void handleSiteEvent(Event event);
-    void handleCircleEvent(Event event);
-    Arc* locateArcAbove(Site site);
-    Arc* breakArc(Arc* arc, Site* site);
-    void invalidateCircleEvent(Arc* arc);
-    void checkCircleEvents(Arc* arc);
-    void removeArc(Arc* arc);
+    void handleSiteEvent(const Event& event);
+    void handleCircleEvent(const Event& event);
+    Voronoi::idx_t breakArc(Voronoi::idx_t arc, Voronoi::idx_t site);
+    Voronoi::idx_t addEdge(Vector2 start, Voronoi::idx_t site_1, Voronoi::idx_t site_2);
+    void invalidateCircleEvent(Voronoi::idx_t arc);
+    void checkCircleEvents(Voronoi::idx_t arc);
+    bool clipEdge(Edge& edge) const;
 public:
-    FortuneAlgorithm(std::vector<Site*> sites);
+    FortuneAlgorithm(const std::vector<Vector2> &points);
+    FortuneAlgorithm(const FortuneAlgorithm &) = delete;
+    FortuneAlgorithm &operator=(const FortuneAlgorithm &) = delete;
 
     VoronoiDiagram construct();
-};
\ No newline at end of file
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "FortuneAlgorithm.h"
+#include "VoronoiDiagram.h"
+
+#include <vector>
+
+/**
+ * @brief Voronoi diagram built in parallel over vertical strips of sites.
+ *
+ * Sites are split by x into one strip per thread, and each strip is built
+ * with Fortune's algorithm on its own. A cell of a strip is final if all of
+ * its vertices have an empty circle that does not reach past the strip, as
+ * no site of another strip can then be closer. The other (border) sites are
+ * rebuilt in a single pass, together with the final sites next to them, and
+ * the edges of both are merged into one diagram.
+ */
+class FortuneAlgorithmTiled {
+private:
+    // Below this many sites per strip, a single sweep is faster
+    static const size_t MIN_STRIP_SITES = 256;
+
+    struct Strip {
+        std::vector<Voronoi::idx_t> sites; // Indices in points
+        double xl, xr;                     // No site of another strip is in (xl, xr)
+        VoronoiDiagram diagram;
+        std::vector<bool> final;           // Per site of the strip
+    };
+
+    std::vector<Vector2> points;
+    size_t nThreads;
+    size_t border_sites = 0;
+
+    void buildStrip(Strip &strip) const;
+public:
+    FortuneAlgorithmTiled(const std::vector<Vector2> &points, size_t nThreads);
+
+    VoronoiDiagram construct();
+
+    /**
+     * @brief Get number of sites rebuilt at the seams by the last construct,
+     * including the final sites next to them.
+     */
+    size_t getBorderSites() const;
+};
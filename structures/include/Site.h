@@ -2,6 +2,18 @@
 
 #include "Vector2.h"
 
+#include <cstdint>
+#include <limits>
+
+/**
+ * @brief Index types for the Voronoi diagram, whose sites, edges, arcs and
+ * events are stored in contiguous arrays and refer to each other by index.
+ */
+namespace Voronoi {
+    typedef uint32_t idx_t;
+    static const idx_t INVALID_IDX = std::numeric_limits<idx_t>::max();
+}
+
 struct Site {
     Vector2 point;
-};
\ No newline at end of file
+};
@@ -2,6 +2,7 @@
 
 #include "Coord.h"
 
+#include <fstream>
 #include <string>
 #include <vector>
 
@@ -11,7 +12,58 @@ public:
     long long timestamp;
     std::vector<Coord> coords;
 
+    /**
+     * @brief Seconds between consecutive coordinates.
+     */
+    static const long long SAMPLING_PERIOD = 15;
+
+    /**
+     * @brief Get timestamp of each coordinate, from the timestamp of the trip.
+     */
+    std::vector<long long> getTimestamps() const;
+
     static std::vector<Trip> loadTrips(const std::string &filepath);
     static void storeTripsBin(const std::vector<Trip> &trips, const std::string &filepath);
     static std::vector<Trip> loadTripsBin(const std::string &filepath);
+
+    class Reader;
+};
+
+/**
+ * @brief Reads trips from a binary file (as written by storeTripsBin) one
+ * at a time, so they need not all be in memory.
+ */
+class Trip::Reader {
+private:
+    std::ifstream is;
+    size_t N;
+    size_t read = 0;
+public:
+    Reader(const std::string &filepath);
+
+    /**
+     * @brief Get number of trips in the file.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Get number of trips read so far.
+     */
+    size_t tell() const;
+
+    /**
+     * @brief Read the next trip.
+     * 
+     * @param trip  Output
+     * @return false if all trips were read
+     */
+    bool next(Trip &trip);
+
+    /**
+     * @brief Skip the next n trips, without reading their coordinates.
+     * 
+     * @param n Number of trips to skip
+     * @return Number of trips skipped; less than n if the file ended
+     */
+    size_t skip(size_t n);
 };
@@ -2,6 +2,7 @@
 
 #include "Box.h"
 #include "Edge.h"
+#include "Site.h"
 #include "Vector2.h"
 
 #include <queue>
@@ -9,15 +10,50 @@
 
 class Edge;
 
+/**
+ * @brief Voronoi diagram, as flat arrays: sites, and edges that refer to
+ * sites by index. It owns all of its storage, so copying or destroying it
+ * does not touch individual elements.
+ */
 class VoronoiDiagram {
 private:
     std::vector<Edge> edges;
+    std::vector<std::pair<Voronoi::idx_t, Voronoi::idx_t>> delaunay_edges;
 public:
-    std::vector<Site*> sites;
+    std::vector<Site> sites;
     Box bounding_box;
 
-    VoronoiDiagram(std::vector<Site*> sites);
+    VoronoiDiagram();
+    VoronoiDiagram(const std::vector<Vector2> &points);
 
-    void addEdge(Edge segment);
-    std::vector<Edge> getEdges() const;
+    /**
+     * @brief Add a site.
+     * 
+     * @param point             Position of the site
+     * @return Voronoi::idx_t   Index of the new site in sites
+     */
+    Voronoi::idx_t addSite(Vector2 point);
+
+    void addEdge(const Edge &segment);
+    const std::vector<Edge> &getEdges() const;
+
+    /**
+     * @brief Reserve space for edges, to avoid reallocations when the
+     * number of edges can be estimated.
+     */
+    void reserveEdges(size_t n);
+
+    /**
+     * @brief Add a Delaunay edge, i.e. mark two sites as neighbours.
+     * 
+     * @param i Index of a site in sites
+     * @param j Index of another site in sites
+     */
+    void addDelaunayEdge(Voronoi::idx_t i, Voronoi::idx_t j);
+
+    /**
+     * @brief Get pairs of sites whose Voronoi cells share an edge (before
+     * clipping to the bounding box), as indices in sites.
+     */
+    const std::vector<std::pair<Voronoi::idx_t, Voronoi::idx_t>> &getDelaunayEdges() const;
 };
@@ -3,18 +3,12 @@
 #include <cmath>
 #include <limits>
 
-Arc::Arc(Site* site) : site(site) {
-
-}
-
-Arc::Arc(Site* site, Arc* previous, Arc* next) : previous(previous), next(next), site(site) {
+Arc::Arc(Voronoi::idx_t site, Vector2 focus) : site(site), focus(focus) {
 
 }
 
 // Get parabola point for x
-Vector2 Arc::getPoint(double x, double sweep_line) {
-    Vector2 focus = site->point;
-
+Vector2 Arc::getPoint(double x, double sweep_line) const {
     // Distance between the parabola's focus and its vertex
     // Or distance from the parabola's vertex to its directrix (the sweep line)
     double p = (focus.y - sweep_line) / 2;
@@ -23,44 +17,52 @@ Vector2 Arc::getPoint(double x, double sweep_line) {
     double h = focus.x;
     double k = focus.y - p;
 
-    double a = 1 / (4 * p);
-    double b = -h / (2 * p);
-    double c = (pow(h, 2) / (4 * p)) + k;
-
-    double y = a * pow(x, 2) + b * x + c;
+    // Vertex form; expanding it cancels badly for narrow parabolas
+    double y = pow(x - h, 2) / (4 * p) + k;
 
     return Vector2(x, y);
 }
 
 // Intersect two parabolas 
-Vector2 Arc::intersect(Arc arc, double sweep_line) {
-    Vector2 point1 = this->site->point;
-    Vector2 point2 = arc.site->point;
+Vector2 Arc::intersect(const Arc& arc, double sweep_line) const {
+    Vector2 point1 = this->focus;
+    Vector2 point2 = arc.focus;
 
     double x1 = point1.x, y1 = point1.y, x2 = point2.x, y2 = point2.y;
-    
-    double d1 = 1.0 / (2.0 * (y1 - sweep_line));
-	double d2 = 1.0 / (2.0 * (y2 - sweep_line));
-
-	double a = d1 - d2;
-	double b = 2.0 * (x2 * d2 - x1 * d1);
-	double c = (y1 * y1 + x1 * x1 - sweep_line * sweep_line) * d1 - (y2 * y2 + x2 * x2 - sweep_line * sweep_line) * d2;
-	double delta = b * b - 4.0 * a * c;
-    double x;
 
-    // a is 0
-    if (fabs(a) < 0.00000001)
-        x = - c / b;
+    // A focus on the sweep line is a degenerate parabola (a vertical ray)
+    if (y1 == sweep_line && y2 == sweep_line)
+        return Vector2((x1 + x2) / 2, sweep_line);
+
+    if (y1 == sweep_line)
+        return arc.getPoint(x1, sweep_line);
+
+    if (y2 == sweep_line)
+        return getPoint(x2, sweep_line);
+
+    // With u = x - x1 the intersections solve
+    // (dy2 - dy1) u^2 + 2 dy1 dx u - dy1 (dx^2 + dy2 (dy2 - dy1)) = 0,
+    // of which this arc being on the left takes the + root. It is computed
+    // in the form that does not cancel, so that nearby sites at close
+    // heights still get accurate breakpoints
+    double dy1 = y1 - sweep_line;
+    double dy2 = y2 - sweep_line;
+    double dx = x2 - x1;
+    double a = y2 - y1;
+    double s = std::sqrt(dy1 * dy2 * (dx * dx + a * a));
+    double u;
+
+    if (dx >= 0)
+        u = dy1 * (dx * dx + dy2 * a) / (s + dy1 * dx);
 
     else
-        x = (-b + std::sqrt(delta)) / (2.0 * a);
+        u = (s - dy1 * dx) / a;
 
-    return getPoint(x, sweep_line);
+    return getPoint(x1 + u, sweep_line);
 }
 
 // Intersect parabola with edge
-Vector2 Arc::intersect(Edge edge, double sweep_line) {
-    Vector2 focus = site->point;
+Vector2 Arc::intersect(const Edge &edge, double sweep_line) const {
     double x;
 
     if (edge.m == std::numeric_limits<double>::infinity())
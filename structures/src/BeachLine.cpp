@@ -0,0 +1,251 @@
+#include "BeachLine.h"
+
+using Voronoi::idx_t;
+using Voronoi::INVALID_IDX;
+
+unsigned BeachLine::nextPriority() {
+    // xorshift32
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    return seed;
+}
+
+Arc& BeachLine::operator[](idx_t arc) {
+    return arcs[arc];
+}
+
+const Arc& BeachLine::operator[](idx_t arc) const {
+    return arcs[arc];
+}
+
+idx_t BeachLine::createArc(idx_t site, Vector2 focus) {
+    if (!free_arcs.empty()) {
+        idx_t arc = free_arcs.back();
+        free_arcs.pop_back();
+        arcs[arc] = Arc(site, focus);
+
+        return arc;
+    }
+
+    arcs.push_back(Arc(site, focus));
+
+    return idx_t(arcs.size() - 1);
+}
+
+void BeachLine::destroyArc(idx_t arc) {
+    free_arcs.push_back(arc);
+}
+
+void BeachLine::replaceChild(idx_t parent, idx_t old_child, idx_t new_child) {
+    if (parent == INVALID_IDX)
+        root = new_child;
+
+    else if (arcs[parent].left == old_child)
+        arcs[parent].left = new_child;
+
+    else
+        arcs[parent].right = new_child;
+
+    if (new_child != INVALID_IDX)
+        arcs[new_child].parent = parent;
+}
+
+// Rotate arc above its parent
+void BeachLine::rotateUp(idx_t arc) {
+    Arc& a = arcs[arc];
+    idx_t parent = a.parent;
+    Arc& p = arcs[parent];
+
+    if (p.left == arc) {
+        p.left = a.right;
+
+        if (a.right != INVALID_IDX)
+            arcs[a.right].parent = parent;
+
+        a.right = parent;
+    }
+
+    else {
+        p.right = a.left;
+
+        if (a.left != INVALID_IDX)
+            arcs[a.left].parent = parent;
+
+        a.left = parent;
+    }
+
+    replaceChild(p.parent, parent, arc);
+    p.parent = arc;
+}
+
+void BeachLine::siftUp(idx_t arc) {
+    while (arcs[arc].parent != INVALID_IDX && arcs[arcs[arc].parent].priority < arcs[arc].priority)
+        rotateUp(arc);
+}
+
+bool BeachLine::empty() const {
+    return root == INVALID_IDX;
+}
+
+void BeachLine::insert(idx_t arc) {
+    Arc& a = arcs[arc];
+    a.parent = a.left = a.right = INVALID_IDX;
+    a.previous = a.next = INVALID_IDX;
+    a.priority = nextPriority();
+
+    root = arc;
+}
+
+void BeachLine::insertBefore(idx_t pos, idx_t arc) {
+    Arc& a = arcs[arc];
+    Arc& p = arcs[pos];
+
+    a.previous = p.previous;
+    a.next = pos;
+
+    if (p.previous != INVALID_IDX)
+        arcs[p.previous].next = arc;
+
+    p.previous = arc;
+
+    a.left = a.right = INVALID_IDX;
+    a.priority = nextPriority();
+
+    // Predecessor of pos in the tree has a free right child
+    if (p.left == INVALID_IDX) {
+        p.left = arc;
+        a.parent = pos;
+    }
+
+    else {
+        idx_t node = p.left;
+
+        while (arcs[node].right != INVALID_IDX)
+            node = arcs[node].right;
+
+        arcs[node].right = arc;
+        a.parent = node;
+    }
+
+    siftUp(arc);
+}
+
+void BeachLine::insertAfter(idx_t pos, idx_t arc) {
+    Arc& a = arcs[arc];
+    Arc& p = arcs[pos];
+
+    a.previous = pos;
+    a.next = p.next;
+
+    if (p.next != INVALID_IDX)
+        arcs[p.next].previous = arc;
+
+    p.next = arc;
+
+    a.left = a.right = INVALID_IDX;
+    a.priority = nextPriority();
+
+    // Successor of pos in the tree has a free left child
+    if (p.right == INVALID_IDX) {
+        p.right = arc;
+        a.parent = pos;
+    }
+
+    else {
+        idx_t node = p.right;
+
+        while (arcs[node].left != INVALID_IDX)
+            node = arcs[node].left;
+
+        arcs[node].left = arc;
+        a.parent = node;
+    }
+
+    siftUp(arc);
+}
+
+void BeachLine::replace(idx_t old_arc, idx_t arc) {
+    Arc& a = arcs[arc];
+    Arc& o = arcs[old_arc];
+
+    a.previous = o.previous;
+    a.next = o.next;
+
+    if (a.previous != INVALID_IDX)
+        arcs[a.previous].next = arc;
+
+    if (a.next != INVALID_IDX)
+        arcs[a.next].previous = arc;
+
+    a.priority = o.priority;
+    a.left = o.left;
+    a.right = o.right;
+
+    if (a.left != INVALID_IDX)
+        arcs[a.left].parent = arc;
+
+    if (a.right != INVALID_IDX)
+        arcs[a.right].parent = arc;
+
+    replaceChild(o.parent, old_arc, arc);
+
+    o.previous = o.next = INVALID_IDX;
+    o.parent = o.left = o.right = INVALID_IDX;
+}
+
+void BeachLine::erase(idx_t arc) {
+    Arc& a = arcs[arc];
+
+    // Rotate arc down until it is a leaf
+    while (a.left != INVALID_IDX || a.right != INVALID_IDX) {
+        if (a.right == INVALID_IDX || (a.left != INVALID_IDX && arcs[a.left].priority > arcs[a.right].priority))
+            rotateUp(a.left);
+
+        else
+            rotateUp(a.right);
+    }
+
+    replaceChild(a.parent, arc, INVALID_IDX);
+
+    if (a.previous != INVALID_IDX)
+        arcs[a.previous].next = a.next;
+
+    if (a.next != INVALID_IDX)
+        arcs[a.next].previous = a.previous;
+
+    a.previous = a.next = INVALID_IDX;
+    a.parent = INVALID_IDX;
+}
+
+idx_t BeachLine::locate(double x, double sweep_line) const {
+    idx_t arc = root;
+
+    while (arc != INVALID_IDX) {
+        const Arc& a = arcs[arc];
+
+        if (a.previous != INVALID_IDX && a.left != INVALID_IDX && x < arcs[a.previous].intersect(a, sweep_line).x)
+            arc = a.left;
+
+        else if (a.next != INVALID_IDX && a.right != INVALID_IDX && x > a.intersect(arcs[a.next], sweep_line).x)
+            arc = a.right;
+
+        else
+            return arc;
+    }
+
+    return INVALID_IDX;
+}
+
+idx_t BeachLine::front() const {
+    idx_t arc = root;
+
+    if (arc == INVALID_IDX)
+        return INVALID_IDX;
+
+    while (arcs[arc].left != INVALID_IDX)
+        arc = arcs[arc].left;
+
+    return arc;
+}
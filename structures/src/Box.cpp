@@ -21,8 +21,8 @@ Box::Box(double width, double height) : Box(Vector2(0, 0), Vector2(width, height
 
 }
 
-bool Box::intersect(Edge edge, Vector2& intersection) {
-    for (Edge bound : bounds)
+bool Box::intersect(const Edge &edge, Vector2& intersection) const {
+    for (const Edge &bound : bounds)
         if (bound.intersect(edge, intersection)) {
             if (
                 !intersection.isOn(bound) || 
@@ -38,7 +38,7 @@ bool Box::intersect(Edge edge, Vector2& intersection) {
     return false;
 }
 
-bool Box::contains(Vector2 point) {
+bool Box::contains(Vector2 point) const {
     return point.x >= bounds[0].start.x &&
         point.x <= bounds[2].start.x &&
         point.y >= bounds[0].start.y &&
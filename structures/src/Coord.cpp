@@ -30,6 +30,16 @@ double Coord::getDistanceArc(const Vector2 &p1, const Vector2 &p2){
     return haversine(p1.y, p1.x, p2.y, p2.x) * EARTH_RADIUS;
 }
 
+void Coord::getDistanceArcMany(const Coord &p, const double *lat, const double *lon, size_t n, double *d){
+    const double cosLat = cos(p.lat()*DEG_TO_RAD);
+    for(size_t i = 0; i < n; ++i){
+        double dLat = sin((p.lat() - lat[i]) * DEG_TO_RAD / 2.0);
+        double dLon = sin((p.lon() - lon[i]) * DEG_TO_RAD / 2.0);
+        double a = dLat*dLat + dLon*dLon * cosLat * cos(lat[i]*DEG_TO_RAD);
+        d[i] = 2.0 * asin(sqrt(a)) * EARTH_RADIUS;
+    }
+}
+
 double Coord::getDistanceArcSimple(const Coord &p1, const Coord &p2){
     double dy = (p1.y - p2.y)*Coord::LatDegreesToMeters();
     double dx = (p1.x - p2.x)*Coord::LonDegreesToMeters();
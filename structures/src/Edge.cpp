@@ -16,8 +16,9 @@ Edge::Edge(Vector2 start, Vector2 leftpoint, Vector2 rightpoint) : start(start)
     this->direction = Vector2(-1.0 * (leftpoint.y - rightpoint.y), leftpoint.x - rightpoint.x);
 }
 
-Edge::Edge(Vector2 start, Site* site_1, Site* site_2) : Edge(start, site_1->point, site_2->point) {
-    if (site_1->point.y > site_2->point.y) {
+Edge::Edge(Vector2 start, const std::vector<Site> &sites, Voronoi::idx_t site_1, Voronoi::idx_t site_2) :
+    Edge(start, sites[site_1].point, sites[site_2].point) {
+    if (sites[site_1].point.y > sites[site_2].point.y) {
         site_up = site_1;
         site_down = site_2;
     }
@@ -28,7 +29,7 @@ Edge::Edge(Vector2 start, Site* site_1, Site* site_2) : Edge(start, site_1->poin
     }
 }
 
-bool Edge::intersect(Edge edge, Vector2& intersection) {
+bool Edge::intersect(const Edge &edge, Vector2& intersection) const {
     // Edges are parallel
     if (this->m == edge.m)
         return false;
@@ -69,11 +70,11 @@ bool Edge::intersect(Edge edge, Vector2& intersection) {
     return true;
 }
 
-Edge Edge::merge() {
+Edge Edge::merge(const std::vector<Edge> &edges) const {
     Edge edge = *this;
 
     if (edge.finished)
-        edge.start = adjacent->end;
+        edge.start = edges[adjacent].end;
 
     return edge;
 }
@@ -2,16 +2,16 @@
 
 #include <cmath>
 
-Event::Event(Site* site) : type(SITE), point(site->point), site(site) {
+Event::Event(Voronoi::idx_t site, Vector2 point) : type(SITE), point(point), site(site) {
 
 }
 
-Event::Event(Arc* arc, Vector2 point, double radius) : type(CIRCLE), point(point), arc(arc), radius(radius) {
-    arc->event = this;
+Event::Event(Voronoi::idx_t arc, Vector2 point, double radius) : type(CIRCLE), point(point), arc(arc), radius(radius) {
+
 }
 
 bool Event::operator<(const Event &event) const {
-    if (fabs(this->point.y - event.point.y) < 0.00000001)
+    if (this->point.y == event.point.y)
         return this->point.x < event.point.x;
 
     return this->point.y < event.point.y;
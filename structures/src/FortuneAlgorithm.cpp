@@ -1,105 +1,115 @@
 #include "FortuneAlgorithm.h"
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 #include <iostream>
 #include <iomanip>
 
-FortuneAlgorithm::FortuneAlgorithm(std::vector<Site*> sites) : diagram(sites) {
+using Voronoi::idx_t;
+using Voronoi::INVALID_IDX;
+
+bool FortuneAlgorithm::EventComparator::operator()(idx_t lhs, idx_t rhs) const {
+    return (*circle_events)[lhs] < (*circle_events)[rhs];
+}
+
+FortuneAlgorithm::FortuneAlgorithm(const std::vector<Vector2> &points) :
+    diagram(points),
+    events(EventComparator{&circle_events})
+{
 
 }
 
 VoronoiDiagram FortuneAlgorithm::construct() {
-    // Generate site events
-    for (Site* site : diagram.sites) {
-        events.push(Event(site));
+    const std::vector<Site> &sites = diagram.sites;
+
+    // Generate site events, sorted in the order they are swept
+    std::vector<Event> site_events;
+    site_events.reserve(sites.size());
+
+    for (idx_t i = 0; i < sites.size(); ++i) {
+        const Vector2 &point = sites[i].point;
+
+        site_events.push_back(Event(i, point));
 
         // Set bounding box limits
-        x0 = std::min(x0, site->point.x);
-        y0 = std::min(y0, site->point.y);
-        x1 = std::max(x1, site->point.x);
-        y1 = std::max(y1, site->point.y);
+        x0 = std::min(x0, point.x);
+        y0 = std::min(y0, point.y);
+        x1 = std::max(x1, point.x);
+        y1 = std::max(y1, point.y);
     }
 
+    std::sort(site_events.begin(), site_events.end(), [](const Event& lhs, const Event& rhs) {
+        return rhs < lhs;
+    });
+
     bounding_box = Box(Vector2(x0, y0), Vector2(x1, y1));
 
-    while (!events.empty()) {
-        Event event = events.top();
-        events.pop();
+    // A diagram of n sites has at most 3n edges
+    edges.reserve(3 * sites.size());
 
-        // Update sweep line position
-        sweep_line = event.point.y;
+    std::vector<Event>::const_iterator next_site = site_events.begin();
+    idx_t last_site = INVALID_IDX;
 
-        if (event.type == Event::SITE)
-            handleSiteEvent(event);
+    while (next_site != site_events.end() || !events.empty()) {
+        // Next site event, unless a circle event comes first
+        if (events.empty() || (next_site != site_events.end() && circle_events[events.top()] < *next_site)) {
+            const Event& event = *next_site++;
 
-        else if (invalid_events.find(event) == invalid_events.end())
-            handleCircleEvent(event);
-    }
+            // Repeated sites are skipped, they would only add empty cells
+            if (last_site != INVALID_IDX && sites[last_site].point == event.point)
+                continue;
 
-    // Finish edges
-    for (Edge* edge : edges) {
-        Vector2 intersection;
-
-        bool start_inside = bounding_box.contains(edge->start);
-        bool end_inside = bounding_box.contains(edge->end);
-        bool include_edge = true;
-        bool intersects = bounding_box.intersect(*edge, intersection);
-
-        // Edge is not finished (doesn't have a end point)
-        if (!edge->finished) {
-            // 1) Edge starts inside the bounding box
-            if (start_inside) {
-                edge->end = intersection;
-                edge->finished = true;
-            }
-
-            // 2) Edge starts outside the bounding box and intersects it
-            else if (intersects) {
-                edge->start = intersection;
-
-                bounding_box.intersect(*edge, intersection);
+            last_site = event.site;
 
-                edge->end = intersection;
-                edge->finished = true;
-            }
+            // Update sweep line position
+            sweep_line = event.point.y;
 
-            // 3) Edge starts outside the bounding box and doesn't intersect it
-            else
-                include_edge = false;
+            handleSiteEvent(event);
         }
 
-        // Edge is finished
         else {
-            intersects = intersects && intersection.isOn(edge->start, edge->end);
+            idx_t e = events.top();
+            events.pop();
 
-            // 4.1) Edge starts inside and ends outside the bounding box
-            if (start_inside && !end_inside)
-                edge->end = intersection;
+            // Copy, handling the event may grow the arena
+            Event event = circle_events[e];
+            free_events.push_back(e);
 
-            // 4.2) Edge starts and ends outside the bounding box and doesn't intersect it
-            else if (!start_inside && end_inside)
-                edge->start = intersection;
+            if (event.valid) {
+                sweep_line = event.point.y;
 
-            // 5) Edge starts and ends outside the bounding box and doesn't intersect it
-            else if (!start_inside && !end_inside && !intersects)
-                include_edge = false;
+                handleCircleEvent(event);
+            }
+        }
+    }
 
-            // 6) Edge starts and ends outside the bounding box and intersects it
-            else if (!start_inside && !end_inside && intersects) {
-                edge->start = intersection;
+    // Finish edges
+    std::vector<Voronoi::idx_t> new_index(edges.size(), Voronoi::INVALID_IDX);
+    std::vector<Voronoi::idx_t> kept;
 
-                bounding_box.intersect(*edge, intersection);
+    for (Voronoi::idx_t i = 0; i < edges.size(); ++i) {
+        Edge& edge = edges[i];
 
-                edge->end = intersection;
-            }
+        if (clipEdge(edge)) {
+            new_index[i] = Voronoi::idx_t(kept.size());
+            kept.push_back(i);
         }
+    }
+
+    // Twins are referred to by their index among the edges kept
+    diagram.reserveEdges(kept.size() + bounding_box.bounds.size());
 
-        if (include_edge && edge->finished)
-            diagram.addEdge(*edge);
+    for (Voronoi::idx_t i : kept) {
+        Edge edge = edges[i];
+
+        if (edge.adjacent != Voronoi::INVALID_IDX)
+            edge.adjacent = new_index[edge.adjacent];
+
+        diagram.addEdge(edge);
     }
 
-    for (Edge bound : bounding_box.bounds)
+    for (const Edge &bound : bounding_box.bounds)
         diagram.addEdge(bound);
 
     diagram.bounding_box = bounding_box;
@@ -107,42 +117,104 @@ VoronoiDiagram FortuneAlgorithm::construct() {
     return diagram;
 }
 
-// Add new parabola
-void FortuneAlgorithm::handleSiteEvent(Event event) {
-    // std::cout << std::setprecision(7) << event.point.x << " " << event.point.y << std::endl;
+// Clip edge to the bounding box (Liang-Barsky); false if nothing is left
+bool FortuneAlgorithm::clipEdge(Edge& edge) const {
+    // Finished edges are the segment from start to end, others a ray
+    Vector2 d = edge.finished ? edge.end - edge.start : edge.direction;
+    double t0 = 0;
+    double t1 = edge.finished ? 1 : std::numeric_limits<double>::infinity();
+
+    const double p[4] = {-d.x, d.x, -d.y, d.y};
+    const double q[4] = {edge.start.x - x0, x1 - edge.start.x, edge.start.y - y0, y1 - edge.start.y};
+
+    for (int k = 0; k < 4; ++k) {
+        if (p[k] == 0) {
+            if (q[k] < 0)
+                return false;
+        }
+
+        else if (p[k] < 0)
+            t0 = std::max(t0, q[k] / p[k]);
+
+        else
+            t1 = std::min(t1, q[k] / p[k]);
+    }
+
+    // Empty, or a single point on the boundary
+    if (!(t0 < t1))
+        return false;
+
+    // Endpoints inside the box are kept exactly, other edges may share them
+    if (!(edge.finished && t1 == 1))
+        edge.end = edge.start + d * t1;
+
+    if (t0 > 0)
+        edge.start = edge.start + d * t0;
 
+    edge.finished = true;
+
+    return true;
+}
+
+// Add new parabola
+void FortuneAlgorithm::handleSiteEvent(const Event& event) {
     // Beachline is empty
-    if (arcs.empty()) {
-        arcs.push_back(new Arc(event.site));
+    if (beach_line.empty()) {
+        beach_line.insert(beach_line.createArc(event.site, event.point));
 
         return;
     }
 
-    Arc* arc_above = locateArcAbove(*event.site);
+    idx_t arc_above = beach_line.locate(event.point.x, sweep_line);
 
-    // Starting point for the two new edges
-    Vector2 start = arc_above->getPoint(event.site->point.x, sweep_line);
+    // breakArc frees arc_above
+    idx_t site_above = beach_line[arc_above].site;
+    Vector2 focus_above = beach_line[arc_above].focus;
 
-    Arc* middle_arc = breakArc(arc_above, event.site);
-    Arc* left_arc = middle_arc->previous;
-    Arc* right_arc = middle_arc->next;
+    // Sites on the topmost row: their arcs are still vertical rays, so the
+    // new arc goes next to arc_above, separated by a vertical edge
+    if (focus_above.y == sweep_line) {
+        idx_t arc = beach_line.createArc(event.site, event.point);
 
-    Edge* left_edge = new Edge(start, arc_above->site, event.site);
-    Edge* right_edge = new Edge(start, event.site, arc_above->site);
+        if (event.point.x < focus_above.x)
+            beach_line.insertBefore(arc_above, arc);
 
-    // Add edges to diagram 
-    edges.push_back(left_edge);
-    edges.push_back(right_edge);
+        else
+            beach_line.insertAfter(arc_above, arc);
+
+        idx_t left_arc = beach_line[arc].next == arc_above ? arc : arc_above;
+        idx_t right_arc = beach_line[left_arc].next;
+
+        Vector2 start((focus_above.x + event.point.x) / 2, sweep_line);
+        idx_t edge = addEdge(start, beach_line[left_arc].site, beach_line[right_arc].site);
+        diagram.addDelaunayEdge(site_above, event.site);
+
+        beach_line[left_arc].s1 = edge;
+        beach_line[right_arc].s0 = edge;
+
+        return;
+    }
+
+    // Starting point for the two new edges
+    Vector2 start = beach_line[arc_above].getPoint(event.point.x, sweep_line);
+
+    idx_t middle_arc = breakArc(arc_above, event.site);
+    idx_t left_arc = beach_line[middle_arc].previous;
+    idx_t right_arc = beach_line[middle_arc].next;
+
+    idx_t left_edge = addEdge(start, site_above, event.site);
+    idx_t right_edge = addEdge(start, event.site, site_above);
+    diagram.addDelaunayEdge(site_above, event.site);
 
     // Link up the two edges
-    left_edge->adjacent = right_edge;
-    right_edge->adjacent = left_edge;
+    edges[left_edge].adjacent = right_edge;
+    edges[right_edge].adjacent = left_edge;
 
-    middle_arc->s0 = left_edge;
-    middle_arc->s1 = right_edge;
+    beach_line[middle_arc].s0 = left_edge;
+    beach_line[middle_arc].s1 = right_edge;
 
-    left_arc->s1 = middle_arc->s0;
-    right_arc->s0 = middle_arc->s1;
+    beach_line[left_arc].s1 = left_edge;
+    beach_line[right_arc].s0 = right_edge;
 
     // Check for new circle events
     checkCircleEvents(left_arc);
@@ -150,124 +222,120 @@ void FortuneAlgorithm::handleSiteEvent(Event event) {
 }
 
 // Remove parabola
-void FortuneAlgorithm::handleCircleEvent(Event event) {
-    Arc* arc = event.arc;
-    Arc* left_arc = arc->previous;
-    Arc* right_arc = arc->next;
+void FortuneAlgorithm::handleCircleEvent(const Event& event) {
+    idx_t arc = event.arc;
+    idx_t left_arc = beach_line[arc].previous;
+    idx_t right_arc = beach_line[arc].next;
 
-    left_arc->next = right_arc;
-    right_arc->previous = left_arc;
-
-    Edge* left_edge = left_arc->s1;
-    Edge* right_edge = right_arc->s0;
+    Edge& left_edge = edges[beach_line[left_arc].s1];
+    Edge& right_edge = edges[beach_line[right_arc].s0];
 
     Vector2 point = Vector2(event.point.x, event.point.y + event.radius);
 
-    left_edge->end = point;
-    right_edge->end = point;
-    left_edge->finished = true;
-    right_edge->finished = true;
-
-    Edge* boundary_ray = new Edge(point, left_arc->site, right_arc->site);
-    edges.push_back(boundary_ray);
+    left_edge.end = point;
+    right_edge.end = point;
+    left_edge.finished = true;
+    right_edge.finished = true;
 
-    left_arc->s1 = boundary_ray;
-    right_arc->s0 = boundary_ray;
+    idx_t boundary_ray = addEdge(point, beach_line[left_arc].site, beach_line[right_arc].site);
+    diagram.addDelaunayEdge(beach_line[left_arc].site, beach_line[right_arc].site);
 
-    removeArc(arc);
+    beach_line[left_arc].s1 = boundary_ray;
+    beach_line[right_arc].s0 = boundary_ray;
 
-    delete arc;
+    beach_line.erase(arc);
+    beach_line.destroyArc(arc);
 
     // Check to see if we need to create new circle events
     checkCircleEvents(left_arc);
     checkCircleEvents(right_arc);
 }
 
-Arc* FortuneAlgorithm::locateArcAbove(Site site) {
-    double x = site.point.x;
+idx_t FortuneAlgorithm::breakArc(idx_t arc, idx_t site) {
+    // The circle event of the old arc no longer happens
+    invalidateCircleEvent(arc);
 
-    for (Arc* arc : arcs) {
-        double a = -std::numeric_limits<double>::infinity();
-        double b = std::numeric_limits<double>::infinity();
+    idx_t left_arc = beach_line.createArc(beach_line[arc].site, beach_line[arc].focus);
+    idx_t right_arc = beach_line.createArc(beach_line[arc].site, beach_line[arc].focus);
+    idx_t middle_arc = beach_line.createArc(site, diagram.sites[site].point);
 
-        if (arc->previous != nullptr)
-            a = arc->previous->intersect(*arc, sweep_line).x;
+    beach_line.replace(arc, left_arc);
+    beach_line.insertAfter(left_arc, middle_arc);
+    beach_line.insertAfter(middle_arc, right_arc);
 
-        if (arc->next != nullptr)
-            b = arc->intersect(*arc->next, sweep_line).x;
+    beach_line[left_arc].s0 = beach_line[arc].s0;
+    beach_line[right_arc].s1 = beach_line[arc].s1;
 
-        if (((arc->previous == nullptr) || (x > a)) && ((arc->next == nullptr) || (x < b))) 
-            return arc;
-    }
-}
+    // Free old arc
+    beach_line.destroyArc(arc);
 
-Arc* FortuneAlgorithm::breakArc(Arc* arc, Site* site) {
-    Arc* left_arc = new Arc(arc->site);
-    Arc* right_arc = new Arc(arc->site);
-    Arc* middle_arc = new Arc(site, left_arc, right_arc);
+    return middle_arc;
+}
 
-    removeArc(arc);
+idx_t FortuneAlgorithm::addEdge(Vector2 start, idx_t site_1, idx_t site_2) {
+    edges.push_back(Edge(start, diagram.sites, site_1, site_2));
 
-    arcs.push_back(left_arc);
-    arcs.push_back(right_arc);
-    arcs.push_back(middle_arc);
+    return idx_t(edges.size() - 1);
+}
 
-    left_arc->s0 = arc->s0;
-    right_arc->s1 = arc->s1;
-    left_arc->event = arc->event;
-    right_arc->event = arc->event;
+void FortuneAlgorithm::checkCircleEvents(idx_t arc) {
+    // Neighbours of arc changed, so its previous circle event is stale
+    invalidateCircleEvent(arc);
 
-    left_arc->previous = arc->previous;
-    left_arc->next = middle_arc;
+    const Arc& a = beach_line[arc];
 
-    if (left_arc->previous != nullptr)
-        left_arc->previous->next = left_arc;
+    if (a.previous == INVALID_IDX || a.next == INVALID_IDX)
+        return;
 
-    right_arc->previous = middle_arc;
-    right_arc->next = arc->next;
+    // Relative to the focus, for precision
+    Vector2 focus = a.focus;
+    Vector2 u = beach_line[a.previous].focus - focus;
+    Vector2 w = beach_line[a.next].focus - focus;
 
-    if (right_arc->next != nullptr)
-        right_arc->next->previous = right_arc;
+    // The breakpoints of arc only converge if its sites turn clockwise.
+    // Deciding this on the sites, not on the intersection of the edges,
+    // keeps degenerate inputs (e.g. sites on a lattice) exact.
+    double det = u.x * w.y - u.y * w.x;
 
+    if (det <= 0)
+        return;
 
-    // Delete old arc
-    delete arc;
+    // Circumcenter of the three sites
+    double u2 = u.x * u.x + u.y * u.y;
+    double w2 = w.x * w.x + w.y * w.y;
+    double cx = (w.y * u2 - u.y * w2) / (2 * det);
+    double cy = (u.x * w2 - w.x * u2) / (2 * det);
 
-    return middle_arc;
-}
+    Vector2 center = focus + Vector2(cx, cy);
 
-void FortuneAlgorithm::checkCircleEvents(Arc* arc) {
-    Vector2 intersection;
+    // Calculate radius of circle
+    double radius = sqrt(cx * cx + cy * cy);
 
-    if (arc->s0 == nullptr || arc->s1 == nullptr || !arc->s0->intersect(*arc->s1, intersection))
-        return;
+    // A converging arc never vanishes above the sweep line, so the event is
+    // created even if rounding puts it slightly above
+    Event event(arc, Vector2(center.x, center.y - radius), radius);
+    idx_t e;
 
-    Vector2 focus = arc->site->point;
+    if (!free_events.empty()) {
+        e = free_events.back();
+        free_events.pop_back();
+        circle_events[e] = event;
+    }
 
-    // Calculate radius of circle
-    double dy = focus.y - intersection.y;
-    double dx = focus.x - intersection.x;
-    double radius = sqrt(pow(dx, 2) + pow(dy, 2));
-
-    // Check if sweepline hasn't passed possible circle event location
-    if (intersection.y - radius < sweep_line) {
-        // Remove any circle events now not needed
-        invalidateCircleEvent(arc);
-
-        // Create circle event
-        Event* circle_event = new Event(arc, Vector2(intersection.x, intersection.y - radius), radius);
-        events.push(*circle_event);
+    else {
+        e = idx_t(circle_events.size());
+        circle_events.push_back(event);
     }
-}
 
-void FortuneAlgorithm::invalidateCircleEvent(Arc* arc) {
-    if (arc->event != nullptr)
-        invalid_events.insert(*arc->event);
+    beach_line[arc].event = e;
+    events.push(e);
 }
 
-void FortuneAlgorithm::removeArc(Arc* arc) {
-    std::vector<Arc*>::iterator position = std::find(arcs.begin(), arcs.end(), arc);
+void FortuneAlgorithm::invalidateCircleEvent(idx_t arc) {
+    idx_t& e = beach_line[arc].event;
 
-    if (position != arcs.end())
-        arcs.erase(position);
-}
\ No newline at end of file
+    if (e != INVALID_IDX) {
+        circle_events[e].valid = false;
+        e = INVALID_IDX;
+    }
+}
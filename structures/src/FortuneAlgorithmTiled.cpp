@@ -0,0 +1,199 @@
+#include "FortuneAlgorithmTiled.h"
+
+#include "parallelFor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+using Voronoi::idx_t;
+using Voronoi::INVALID_IDX;
+
+namespace {
+    /**
+     * @brief Append the edges of a diagram for which keep is true, mapping
+     * sites to indices in the merged diagram and twins to their new index.
+     */
+    template<class F>
+    void mergeEdges(VoronoiDiagram &merged, const VoronoiDiagram &diagram, const std::vector<idx_t> &to_global, const F &keep) {
+        const std::vector<Edge> &edges = diagram.getEdges();
+        const idx_t offset = idx_t(merged.getEdges().size());
+
+        std::vector<idx_t> new_index(edges.size(), INVALID_IDX);
+        idx_t n = 0;
+        for (idx_t i = 0; i < edges.size(); ++i)
+            if (edges[i].site_up != INVALID_IDX && keep(edges[i].site_up, edges[i].site_down))
+                new_index[i] = offset + n++;
+
+        for (idx_t i = 0; i < edges.size(); ++i) {
+            if (new_index[i] == INVALID_IDX) continue;
+
+            Edge edge = edges[i];
+            edge.site_up = to_global[edge.site_up];
+            edge.site_down = to_global[edge.site_down];
+            if (edge.adjacent != INVALID_IDX)
+                edge.adjacent = new_index[edge.adjacent];
+
+            merged.addEdge(edge);
+        }
+
+        for (const std::pair<idx_t, idx_t> &e : diagram.getDelaunayEdges())
+            if (keep(e.first, e.second))
+                merged.addDelaunayEdge(to_global[e.first], to_global[e.second]);
+    }
+}
+
+FortuneAlgorithmTiled::FortuneAlgorithmTiled(const std::vector<Vector2> &points_, size_t nThreads_) :
+    points(points_),
+    nThreads(nThreads_)
+{
+
+}
+
+void FortuneAlgorithmTiled::buildStrip(Strip &strip) const {
+    std::vector<Vector2> local;
+    local.reserve(strip.sites.size());
+    for (idx_t i : strip.sites)
+        local.push_back(points[i]);
+
+    strip.diagram = FortuneAlgorithm(local).construct();
+
+    double x0 = std::numeric_limits<double>::max(), x1 = -x0;
+    double y0 = x0, y1 = -x0;
+    for (const Vector2 &p : local) {
+        x0 = std::min(x0, p.x); x1 = std::max(x1, p.x);
+        y0 = std::min(y0, p.y); y1 = std::max(y1, p.y);
+    }
+
+    // Margin for rounding in the vertices
+    const double eps = 1e-9 * std::max(x1 - x0, y1 - y0);
+
+    std::vector<bool> has_edge(local.size(), false);
+    std::vector<bool> border(local.size(), false);
+
+    for (const Edge &edge : strip.diagram.getEdges()) {
+        if (edge.site_up == INVALID_IDX) continue;
+
+        has_edge[edge.site_up] = has_edge[edge.site_down] = true;
+
+        // Edges clipped by the box belong to cells that leave the strip's
+        // box, whose shape may depend on other strips
+        bool final = true;
+        for (const Vector2 &v : {edge.start, edge.end}) {
+            if (v.x <= x0 + eps || v.x >= x1 - eps || v.y <= y0 + eps || v.y >= y1 - eps)
+                final = false;
+
+            double r = v.getDistance(local[edge.site_up]);
+            if (!(v.x - r > strip.xl + eps && v.x + r < strip.xr - eps))
+                final = false;
+        }
+
+        if (!final)
+            border[edge.site_up] = border[edge.site_down] = true;
+    }
+
+    strip.final.resize(local.size());
+    for (size_t i = 0; i < local.size(); ++i)
+        strip.final[i] = has_edge[i] && !border[i];
+}
+
+VoronoiDiagram FortuneAlgorithmTiled::construct() {
+    const size_t N = points.size();
+    const size_t nStrips = std::min(nThreads, N / MIN_STRIP_SITES);
+
+    border_sites = 0;
+
+    if (nStrips <= 1) {
+        border_sites = N;
+        return FortuneAlgorithm(points).construct();
+    }
+
+    std::vector<idx_t> order(N);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](idx_t i, idx_t j) {
+        return Vector2::compXY(points[i], points[j]);
+    });
+
+    // Strips do not share an x, so a site on a seam belongs to one strip
+    std::vector<Strip> strips;
+    size_t l = 0;
+    for (size_t s = 1; s <= nStrips && l < N; ++s) {
+        size_t r = s * N / nStrips;
+        while (r < N && r > l && points[order[r]].x == points[order[r - 1]].x) ++r;
+        if (r <= l) continue;
+
+        Strip strip;
+        strip.sites.assign(order.begin() + l, order.begin() + r);
+        strip.xl = l > 0 ? points[order[l - 1]].x : -std::numeric_limits<double>::infinity();
+        strip.xr = r < N ? points[order[r]].x : std::numeric_limits<double>::infinity();
+        strips.push_back(std::move(strip));
+
+        l = r;
+    }
+
+    utils::parallelFor(strips.size(), nThreads, [this, &strips](size_t l_, size_t r_) {
+        for (size_t s = l_; s < r_; ++s)
+            buildStrip(strips[s]);
+    });
+
+    // Border sites, and the final sites next to them which bound their cells
+    std::vector<bool> is_final(N, false);
+    std::vector<bool> rebuild(N, false);
+    for (const Strip &strip : strips) {
+        for (size_t i = 0; i < strip.sites.size(); ++i) {
+            is_final[strip.sites[i]] = strip.final[i];
+            rebuild[strip.sites[i]] = !strip.final[i];
+        }
+    }
+    for (const Strip &strip : strips) {
+        for (const std::pair<idx_t, idx_t> &e : strip.diagram.getDelaunayEdges()) {
+            if (!strip.final[e.first] || !strip.final[e.second]) {
+                rebuild[strip.sites[e.first]] = true;
+                rebuild[strip.sites[e.second]] = true;
+            }
+        }
+    }
+
+    std::vector<idx_t> seam_sites;
+    std::vector<Vector2> seam_points;
+    for (idx_t i = 0; i < N; ++i) {
+        if (rebuild[i]) {
+            seam_sites.push_back(i);
+            seam_points.push_back(points[i]);
+        }
+    }
+    border_sites = seam_sites.size();
+
+    // The extreme sites have unbounded cells in their strip, so they are
+    // rebuilt and the seam diagram is clipped to the bounding box of all sites
+    VoronoiDiagram seam = FortuneAlgorithm(seam_points).construct();
+
+    VoronoiDiagram diagram(points);
+    size_t n_edges = seam.getEdges().size();
+    for (const Strip &strip : strips)
+        n_edges += strip.diagram.getEdges().size();
+    diagram.reserveEdges(n_edges);
+
+    // Edges between final sites come from the strips, all others from the seams
+    for (const Strip &strip : strips) {
+        mergeEdges(diagram, strip.diagram, strip.sites, [&strip](idx_t i, idx_t j) {
+            return strip.final[i] && strip.final[j];
+        });
+    }
+
+    mergeEdges(diagram, seam, seam_sites, [&is_final, &seam_sites](idx_t i, idx_t j) {
+        return !is_final[seam_sites[i]] || !is_final[seam_sites[j]];
+    });
+
+    for (const Edge &bound : seam.bounding_box.bounds)
+        diagram.addEdge(bound);
+
+    diagram.bounding_box = seam.bounding_box;
+
+    return diagram;
+}
+
+size_t FortuneAlgorithmTiled::getBorderSites() const {
+    return border_sites;
+}
@@ -4,6 +4,13 @@
 
 using namespace std;
 
+vector<long long> Trip::getTimestamps() const {
+    vector<long long> ret(coords.size());
+    for(size_t i = 0; i < coords.size(); ++i)
+        ret[i] = timestamp + (long long)i*SAMPLING_PERIOD;
+    return ret;
+}
+
 vector<Trip> Trip::loadTrips(const std::string &filepath){
     vector<Trip> ret;
 
@@ -58,3 +65,34 @@ vector<Trip> Trip::loadTripsBin(const std::string &filepath){
 
     return ret;
 }
+
+Trip::Reader::Reader(const std::string &filepath){
+    is.exceptions(ifstream::failbit | ifstream::badbit);
+    is.open(filepath, ios::binary);
+    is.read((char*)&N, sizeof(N));
+}
+
+size_t Trip::Reader::size() const { return N; }
+size_t Trip::Reader::tell() const { return read; }
+
+bool Trip::Reader::next(Trip &trip){
+    if(read >= N) return false;
+    is.read((char*)&trip.id, sizeof(trip.id));
+    is.read((char*)&trip.timestamp, sizeof(trip.timestamp));
+    size_t M; is.read((char*)&M, sizeof(M));
+    trip.coords.resize(M);
+    is.read((char*)&trip.coords[0], sizeof(Coord)*M);
+    ++read;
+    return true;
+}
+
+size_t Trip::Reader::skip(size_t n){
+    size_t i = 0;
+    for(; i < n && read < N; ++i){
+        is.seekg(sizeof(Trip::id) + sizeof(Trip::timestamp), ios::cur);
+        size_t M; is.read((char*)&M, sizeof(M));
+        is.seekg(streamoff(sizeof(Coord)*M), ios::cur);
+        ++read;
+    }
+    return i;
+}
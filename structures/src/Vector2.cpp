@@ -109,7 +109,8 @@ bool within(double p, double q, double r) {
 bool Vector2::isOn(Vector2 a, Vector2 b) const {
     Vector2 c = *this;
 
-    return collinear(a, b, c) && (a.x != b.x ? within(a.x, c.x, b.x) : within(a.y, c.y, b.y));
+    // Compare along the longer axis, the other may differ only by rounding
+    return collinear(a, b, c) && (fabs(a.x - b.x) >= fabs(a.y - b.y) ? within(a.x, c.x, b.x) : within(a.y, c.y, b.y));
 }
 
 bool Vector2::isOn(Edge edge) const {
@@ -3,14 +3,39 @@
 #include <algorithm>
 #include <limits>
 
-void VoronoiDiagram::addEdge(Edge segment) {
+Voronoi::idx_t VoronoiDiagram::addSite(Vector2 point) {
+    sites.push_back(Site{point});
+
+    return Voronoi::idx_t(sites.size() - 1);
+}
+
+void VoronoiDiagram::addEdge(const Edge &segment) {
     edges.push_back(segment);
 }
 
-std::vector<Edge> VoronoiDiagram::getEdges() const {
+const std::vector<Edge> &VoronoiDiagram::getEdges() const {
     return edges;
 }
 
-VoronoiDiagram::VoronoiDiagram(std::vector<Site*> sites) : sites(sites) {
+void VoronoiDiagram::reserveEdges(size_t n) {
+    edges.reserve(n);
+}
+
+void VoronoiDiagram::addDelaunayEdge(Voronoi::idx_t i, Voronoi::idx_t j) {
+    delaunay_edges.push_back(std::make_pair(i, j));
+}
+
+const std::vector<std::pair<Voronoi::idx_t, Voronoi::idx_t>> &VoronoiDiagram::getDelaunayEdges() const {
+    return delaunay_edges;
+}
+
+VoronoiDiagram::VoronoiDiagram() {
+
+}
+
+VoronoiDiagram::VoronoiDiagram(const std::vector<Vector2> &points) {
+    sites.reserve(points.size());
 
+    for (const Vector2 &point : points)
+        addSite(point);
 }
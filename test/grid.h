@@ -0,0 +1,88 @@
+#pragma once
+
+#include "MapGraph.h"
+#include "Trip.h"
+
+#include <random>
+#include <vector>
+
+/**
+ * @brief Small road network and trips shared by the map matching tests.
+ */
+namespace testGrid {
+    // Map matchers keep the strongly connected component of this node, so
+    // the grid is numbered from it
+    const DWGraph::node_t FIRST_NODE = 4523960191;
+
+    const size_t W = 12;
+    const double STEP = 0.0004; // Degrees between grid nodes, about 40m
+
+    /**
+     * @brief Get node at column x and row y of the grid.
+     */
+    inline DWGraph::node_t getNode(size_t x, size_t y){
+        return FIRST_NODE + DWGraph::node_t(x*W + y);
+    }
+
+    /**
+     * @brief Get coordinates at column x and row y of the grid, which need
+     * not be whole.
+     */
+    inline Coord getCoord(double x, double y){
+        return Coord(41.15 + y*STEP, -8.61 + x*STEP);
+    }
+
+    /**
+     * @brief Two-way square grid.
+     */
+    inline MapGraph getGrid(){
+        MapGraph M;
+        for(size_t x = 0; x < W; ++x)
+            for(size_t y = 0; y < W; ++y)
+                M.addNode(getNode(x, y), getCoord(double(x), double(y)));
+        for(size_t x = 0; x < W; ++x){
+            for(size_t y = 0; y < W; ++y){
+                const DWGraph::node_t u = getNode(x, y);
+                if(x+1 < W){
+                    M.addWay(MapGraph::way_t{{u, getNode(x+1, y)}, 50, edge_type_t::RESIDENTIAL});
+                    M.addWay(MapGraph::way_t{{getNode(x+1, y), u}, 50, edge_type_t::RESIDENTIAL});
+                }
+                if(y+1 < W){
+                    M.addWay(MapGraph::way_t{{u, getNode(x, y+1)}, 50, edge_type_t::RESIDENTIAL});
+                    M.addWay(MapGraph::way_t{{getNode(x, y+1), u}, 50, edge_type_t::RESIDENTIAL});
+                }
+            }
+        }
+        return M;
+    }
+
+    /**
+     * @brief Random walks on the grid, observed with noise.
+     */
+    inline std::vector<Trip> getTrips(size_t N, size_t minLength = 2, size_t maxLength = 25){
+        std::mt19937 gen(0);
+        std::normal_distribution<double> noise(0.0, 0.00003);
+        std::uniform_int_distribution<size_t> start(0, W-1), length(minLength, maxLength);
+        std::vector<Trip> trips(N);
+        for(size_t i = 0; i < N; ++i){
+            Trip &trip = trips[i];
+            trip.id = (long long)(1000 + i);
+            trip.timestamp = 0;
+            size_t x = start(gen), y = start(gen);
+            const size_t T = length(gen);
+            for(size_t t = 0; t < T; ++t){
+                trip.coords.push_back(Coord(
+                    getCoord(double(x), double(y)).lat() + noise(gen),
+                    getCoord(double(x), double(y)).lon() + noise(gen)
+                ));
+                switch(gen()%4){
+                    case 0: if(x+1 < W) ++x; break;
+                    case 1: if(x > 0  ) --x; break;
+                    case 2: if(y+1 < W) ++y; break;
+                    case 3: if(y > 0  ) --y; break;
+                }
+            }
+        }
+        return trips;
+    }
+}
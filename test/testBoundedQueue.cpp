@@ -0,0 +1,72 @@
+#include "BoundedQueue.h"
+
+#include <catch2/catch_all.hpp>
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <thread>
+
+using namespace std;
+
+TEST_CASE("Bounded queue", "[bounded-queue]"){
+    SECTION("Close drains the queue"){
+        utils::BoundedQueue<int> q(3);
+        q.push(1); q.push(2);
+        q.close();
+        q.push(3);
+        int x;
+        REQUIRE(q.pop(x)); REQUIRE(x == 1);
+        REQUIRE(q.pop(x)); REQUIRE(x == 2);
+        REQUIRE(!q.pop(x));
+        REQUIRE(q.size() == 0);
+    }
+
+    SECTION("Move-only elements"){
+        utils::BoundedQueue<unique_ptr<int>> q(1);
+        q.push(unique_ptr<int>(new int(5)));
+        unique_ptr<int> p;
+        REQUIRE(q.pop(p));
+        REQUIRE(*p == 5);
+    }
+
+    SECTION("Producers and consumers"){
+        const size_t capacity = 4, N = 20000, nConsumers = 3;
+        utils::BoundedQueue<size_t> q(capacity);
+
+        // Assertions are not thread-safe, so threads only count errors
+        atomic<size_t> overfull(0), count(0), sum(0);
+        thread producer([&q, &overfull, N, capacity](){
+            for(size_t i = 1; i <= N; ++i){
+                q.push(i);
+                if(q.size() > capacity) ++overfull;
+            }
+            q.close();
+        });
+        list<thread> consumers;
+        for(size_t k = 0; k < nConsumers; ++k){
+            consumers.emplace_back([&q, &count, &sum](){
+                size_t x;
+                while(q.pop(x)){ ++count; sum += x; }
+            });
+        }
+        producer.join();
+        for(thread &t: consumers) t.join();
+
+        REQUIRE(overfull == 0);
+        REQUIRE(count == N);
+        REQUIRE(sum == N*(N+1)/2);
+    }
+
+    SECTION("Close wakes up a blocked producer"){
+        utils::BoundedQueue<int> q(1);
+        q.push(1);
+        thread producer([&q](){ q.push(2); });
+        this_thread::sleep_for(chrono::milliseconds(20));
+        q.close();
+        producer.join();
+        int x;
+        REQUIRE(q.pop(x)); REQUIRE(x == 1);
+        REQUIRE(!q.pop(x));
+    }
+}
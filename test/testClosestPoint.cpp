@@ -4,7 +4,10 @@
 
 #include "K2DTreeClosestPoint.h"
 #include "DeepVStripes.h"
+#include "DelaunayWalk.h"
+#include "GridRadius.h"
 #include "VStripesRadius.h"
+#include "VoronoiGrid.h"
 
 using namespace std;
 
@@ -250,3 +253,266 @@ TEST_CASE("VStripes Closest Points in Radius 2", "[vstripes-radius-3]"){
     //     }
     // }
 }
+
+TEST_CASE("Batched closest point", "[closest-point-many]"){
+    const size_t N = 10000, M = 10000;
+    list<Vector2> l;
+    for(size_t i = 0; i < N; ++i){
+        l.push_back(Vector2(
+            double(rand())/double(RAND_MAX),
+            double(rand())/double(RAND_MAX)
+        ));
+    }
+    vector<Vector2> points(l.begin(), l.end());
+
+    vector<Vector2> queries(M);
+    for(Vector2 &u: queries){
+        u = Vector2(
+            double(rand())/double(RAND_MAX),
+            double(rand())/double(RAND_MAX)
+        );
+    }
+
+    K2DTreeClosestPoint kdtree;
+    DeepVStripes deepvstripes(0.01, 8);
+    for(ClosestPoint *q: vector<ClosestPoint*>({&kdtree, &deepvstripes})){
+        q->initialize(l);
+        q->run();
+
+        for(size_t nThreads: {1, 4}){
+            vector<size_t> res;
+            q->getClosestPointMany(queries, res, nThreads);
+            REQUIRE(res.size() == M);
+            for(size_t i = 0; i < M; ++i){
+                REQUIRE(points.at(res[i]) == q->getClosestPoint(queries[i]));
+            }
+        }
+    }
+}
+
+TEST_CASE("Batched closest points in radius", "[vstripes-radius-many]"){
+    const size_t N = 10000, M = 1000;
+    list<Coord> l;
+    for(size_t i = 0; i < N; ++i){
+        l.push_back(Coord(
+            41.1 + 0.05*double(rand())/double(RAND_MAX),
+            -8.6 + 0.05*double(rand())/double(RAND_MAX)
+        ));
+    }
+    vector<Coord> points(l.begin(), l.end());
+
+    vector<Coord> queries(M);
+    for(Coord &u: queries){
+        u = Coord(
+            41.1 + 0.05*double(rand())/double(RAND_MAX),
+            -8.6 + 0.05*double(rand())/double(RAND_MAX)
+        );
+    }
+
+    const double d = 50.0;
+
+    VStripesRadius q;
+    q.initialize(l, d);
+    q.run();
+
+    for(size_t nThreads: {1, 4}){
+        vector<size_t> offsets, idxs;
+        q.getClosestPointsMany(queries, offsets, idxs, nThreads);
+        REQUIRE(offsets.size() == M+1);
+        REQUIRE(offsets[M] == idxs.size());
+
+        for(size_t i = 0; i < M; ++i){
+            vector<size_t> expected;
+            q.getClosestPointsIdx(queries[i], expected);
+            vector<size_t> got(idxs.begin() + offsets[i], idxs.begin() + offsets[i+1]);
+            sort(expected.begin(), expected.end());
+            sort(got.begin(), got.end());
+            REQUIRE(got == expected);
+
+            for(const size_t &j: got)
+                REQUIRE(Coord::getDistanceArcSimple(points.at(j), queries[i]) < d);
+        }
+    }
+}
+
+TEST_CASE("Grid Closest Points in Radius", "[grid-radius]"){
+    const size_t N = 10000, M = 300;
+    list<Coord> l;
+    for(size_t i = 0; i < N; ++i){
+        l.push_back(Coord(
+            41.1 + 0.05*double(rand())/double(RAND_MAX),
+            -8.6 + 0.05*double(rand())/double(RAND_MAX)
+        ));
+    }
+    vector<Coord> points(l.begin(), l.end());
+
+    const double d = 50.0;
+    const double epsilon = d * 0.000000001;
+
+    for(size_t nThreads: {1, 3}){
+        GridRadius q(nThreads);
+        q.initialize(l, d);
+        q.run();
+
+        for(size_t i = 0; i < M; ++i){
+            // Some queries fall outside the grid
+            Coord u(
+                41.099 + 0.052*double(rand())/double(RAND_MAX),
+                -8.601 + 0.052*double(rand())/double(RAND_MAX)
+            );
+
+            vector<size_t> v;
+            q.getClosestPointsIdx(u, v);
+            set<size_t> s(v.begin(), v.end());
+            REQUIRE(s.size() == v.size());
+
+            for(size_t j = 0; j < N; ++j){
+                double dist = Coord::getDistanceArcSimple(u, points[j]);
+                if     (dist > d+epsilon) REQUIRE(s.count(j) == 0);
+                else if(dist < d-epsilon) REQUIRE(s.count(j) == 1);
+            }
+        }
+    }
+}
+
+TEST_CASE("Cached Closest Points in Radius", "[radius-cache]"){
+    const size_t N = 10000, M = 2000;
+    list<Coord> l;
+    for(size_t i = 0; i < N; ++i){
+        l.push_back(Coord(
+            41.1 + 0.05*double(rand())/double(RAND_MAX),
+            -8.6 + 0.05*double(rand())/double(RAND_MAX)
+        ));
+    }
+
+    const double d = 50.0;
+
+    VStripesRadius reference;
+    reference.initialize(l, d);
+    reference.run();
+
+    // Queries are repeated with small perturbations, so cells are reused
+    vector<Coord> queries;
+    for(size_t i = 0; i < M/4; ++i){
+        Coord u(
+            41.1 + 0.05*double(rand())/double(RAND_MAX),
+            -8.6 + 0.05*double(rand())/double(RAND_MAX)
+        );
+        for(size_t j = 0; j < 4; ++j){
+            queries.push_back(Coord(
+                u.lat() + 0.00001*double(rand())/double(RAND_MAX),
+                u.lon() + 0.00001*double(rand())/double(RAND_MAX)
+            ));
+        }
+    }
+
+    for(size_t maxBytes: {size_t(1) << 30, size_t(1) << 12}){
+        VStripesRadius inner;
+        ClosestPointsInRadius::Cache q(inner, 2.0, maxBytes);
+        q.initialize(l, d);
+        q.run();
+
+        for(size_t nThreads: {1, 4}){
+            vector<size_t> offsets, idxs;
+            q.getClosestPointsMany(queries, offsets, idxs, nThreads);
+            for(size_t i = 0; i < queries.size(); ++i){
+                vector<size_t> expected;
+                reference.getClosestPointsIdx(queries[i], expected);
+                vector<size_t> got(idxs.begin() + offsets[i], idxs.begin() + offsets[i+1]);
+                sort(expected.begin(), expected.end());
+                sort(got.begin(), got.end());
+                REQUIRE(got == expected);
+            }
+        }
+
+        ClosestPointsInRadius::Cache::stats_t stats = q.getStats();
+        REQUIRE(stats.hits + stats.misses == 2*queries.size());
+        REQUIRE(stats.hits > 0);
+    }
+}
+
+TEST_CASE("Delaunay walk", "[delaunay-walk]"){
+    const size_t N = 2000, M = 2000;
+    list<Vector2> l;
+    for(size_t i = 0; i < N; ++i){
+        l.push_back(Vector2(
+            double(rand())/double(RAND_MAX),
+            double(rand())/double(RAND_MAX)
+        ));
+    }
+    vector<Vector2> points(l.begin(), l.end());
+
+    DelaunayWalk q;
+    q.initialize(l);
+    q.run();
+
+    for(size_t i = 0; i < M; ++i){
+        Vector2 u(
+            double(rand())/double(RAND_MAX),
+            double(rand())/double(RAND_MAX)
+        );
+        REQUIRE(q.getClosestPoint(u) == findClosestBruteForce(l, u));
+    }
+
+    // Trajectory: small random steps
+    DelaunayWalk::Cursor cursor(q);
+    Vector2 u(0.5, 0.5);
+    for(size_t i = 0; i < M; ++i){
+        u.x = min(1.0, max(0.0, u.x + 0.01*(double(rand())/double(RAND_MAX) - 0.5)));
+        u.y = min(1.0, max(0.0, u.y + 0.01*(double(rand())/double(RAND_MAX) - 0.5)));
+        REQUIRE(points.at(cursor.next(u)) == findClosestBruteForce(l, u));
+    }
+    REQUIRE(cursor.getSteps() < 2*M);
+}
+
+TEST_CASE("Voronoi grid", "[voronoi-grid]"){
+    const size_t N = 5000, M = 20000;
+
+    SECTION("Random points"){
+        list<Vector2> l;
+        for(size_t i = 0; i < N; ++i){
+            l.push_back(Vector2(
+                double(rand())/double(RAND_MAX),
+                double(rand())/double(RAND_MAX)
+            ));
+        }
+
+        // Default, and split down to a few candidates per cell
+        for(const pair<size_t, size_t> &params: vector<pair<size_t, size_t>>{{8, 8}, {2, 6}}){
+            VoronoiGrid q(1.0, params.first, params.second);
+            q.initialize(l);
+            q.run();
+
+            // Also outside the grid
+            for(size_t i = 0; i < M; ++i){
+                Vector2 u(
+                    1.2*double(rand())/double(RAND_MAX) - 0.1,
+                    1.2*double(rand())/double(RAND_MAX) - 0.1
+                );
+                REQUIRE(q.getClosestPoint(u) == findClosestBruteForce(l, u));
+            }
+
+            // A few candidates per site with the defaults
+            if(params.first == 8) REQUIRE(q.getMemoryUsage() < N*256);
+        }
+    }
+
+    SECTION("Points on a lattice"){
+        // Voronoi edges run along cell boundaries
+        list<Vector2> l;
+        for(size_t i = 0; i < N; ++i)
+            l.push_back(Vector2(rand()%100, rand()%100));
+
+        VoronoiGrid q(4.0, 1, 6);
+        q.initialize(l);
+        q.run();
+
+        for(size_t i = 0; i < M; ++i){
+            Vector2 u(
+                99.0*double(rand())/double(RAND_MAX),
+                99.0*double(rand())/double(RAND_MAX)
+            );
+            REQUIRE(q.getClosestPoint(u).getDistance(u) == findClosestBruteForce(l, u).getDistance(u));
+        }
+    }
+}
@@ -0,0 +1,100 @@
+#include <catch2/catch_all.hpp>
+
+#include <bits/stdc++.h>
+
+#include "SegmentRTree.h"
+
+using namespace std;
+
+typedef ClosestSegmentsInRadius::segment_t segment_t;
+
+double distanceToSegmentBruteForce(const segment_t &s, const Coord &p){
+    // Sample the segment densely and keep the best sample
+    const size_t N = 1000;
+    double dBest = 1e20;
+    for(size_t i = 0; i <= N; ++i){
+        Coord c = s.first + (s.second-s.first)*(double(i)/double(N));
+        dBest = min(dBest, Coord::getDistanceArcSimple(p, c));
+    }
+    return dBest;
+}
+
+TEST_CASE("Segment R-tree, small", "[segment-rtree-1]"){
+    // Two parallel horizontal segments 0.001 degrees (111m) apart
+    vector<segment_t> segments = {
+        segment_t(Coord(41.000, -8.600), Coord(41.000, -8.590)),
+        segment_t(Coord(41.001, -8.600), Coord(41.001, -8.590))
+    };
+
+    SegmentRTree q(2);
+    q.initialize(segments, 50.0);
+    q.run();
+
+    vector<ClosestSegmentsInRadius::result_t> res;
+    q.getClosestSegments(Coord(41.0002, -8.595), res);
+    REQUIRE(res.size() == 1);
+    REQUIRE(res[0].idx == 0);
+    REQUIRE(fabs(res[0].projection.lat() - 41.000) < 1e-9);
+    REQUIRE(fabs(res[0].projection.lon() - -8.595) < 1e-9);
+    REQUIRE(fabs(res[0].offset - Coord::getDistanceArc(segments[0].first, segments[0].second)/2.0) < 0.01);
+    REQUIRE(fabs(res[0].distance - 0.0002*Coord::LatDegreesToMeters()) < 1e-6);
+
+    res.clear();
+    q.getClosestSegments(Coord(41.0005, -8.595), res);
+    REQUIRE(res.empty());
+
+    res.clear();
+    q.getClosestSegments(Coord(41.0010, -8.6001), res);
+    REQUIRE(res.size() == 1);
+    REQUIRE(res[0].idx == 1);
+    REQUIRE(res[0].offset == 0.0);
+}
+
+TEST_CASE("Segment R-tree, random", "[segment-rtree-2]"){
+    const size_t N = 2000, M = 100;
+    const double d = 50.0;
+    const double epsilon = 0.2;
+
+    vector<segment_t> segments(N);
+    for(segment_t &s: segments){
+        Coord a(
+            41.1 + 0.02*double(rand())/double(RAND_MAX),
+            -8.6 + 0.02*double(rand())/double(RAND_MAX)
+        );
+        Coord b(
+            a.lat() + 0.002*(double(rand())/double(RAND_MAX) - 0.5),
+            a.lon() + 0.002*(double(rand())/double(RAND_MAX) - 0.5)
+        );
+        s = segment_t(a, b);
+    }
+
+    SegmentRTree q;
+    q.initialize(segments, d);
+    q.run();
+
+    for(size_t i = 0; i < M; ++i){
+        Coord u(
+            41.1 + 0.02*double(rand())/double(RAND_MAX),
+            -8.6 + 0.02*double(rand())/double(RAND_MAX)
+        );
+
+        vector<ClosestSegmentsInRadius::result_t> res;
+        q.getClosestSegments(u, res);
+        map<size_t, double> found;
+        for(const ClosestSegmentsInRadius::result_t &r: res){
+            REQUIRE(found.count(r.idx) == 0);
+            found[r.idx] = r.distance;
+            REQUIRE(fabs(r.distance - Coord::getDistanceArcSimple(u, r.projection)) < 1e-6);
+        }
+
+        for(size_t j = 0; j < N; ++j){
+            double dist = distanceToSegmentBruteForce(segments[j], u);
+            if     (dist > d+epsilon) REQUIRE(found.count(j) == 0);
+            else if(dist < d-epsilon){
+                REQUIRE(found.count(j) == 1);
+                REQUIRE(found.at(j) <= dist + 1e-6);
+                REQUIRE(found.at(j) >= dist - epsilon);
+            }
+        }
+    }
+}
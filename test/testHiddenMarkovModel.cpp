@@ -0,0 +1,261 @@
+#include "DijkstraFew.h"
+#include "HiddenMarkovModel.h"
+#include "HiddenMarkovModelHybrid.h"
+#include "K2DTreeClosestPointFactory.h"
+#include "VStripesRadius.h"
+#include "grid.h"
+
+#include <catch2/catch_all.hpp>
+
+#include <cmath>
+#include <random>
+
+using namespace std;
+
+typedef DWGraph::node_t node_t;
+
+using namespace testGrid;
+
+namespace {
+    vector<node_t> matchOnline(HiddenMarkovModel::Session &session, const vector<Coord> &trip, size_t maxLag){
+        vector<node_t> matches;
+        for(const Coord &z: trip){
+            const vector<node_t> decided = session.push(z);
+            matches.insert(matches.end(), decided.begin(), decided.end());
+            REQUIRE(session.getWindowSize() >= 1);
+            REQUIRE(session.getWindowSize() <= maxLag);
+        }
+        const vector<node_t> decided = session.flush();
+        matches.insert(matches.end(), decided.begin(), decided.end());
+        REQUIRE(session.getWindowSize() == 0);
+        return matches;
+    }
+}
+
+TEST_CASE("Online sessions", "[hmm-session]"){
+    const MapGraph M = getGrid();
+    const vector<Trip> trips = getTrips(30);
+
+    VStripesRadius vstripesRadius;
+    DijkstraFew shortestPathFew;
+    HiddenMarkovModel hmm(vstripesRadius, shortestPathFew, 50.0, 5.0, 6.0);
+    hmm.initialize(&M);
+    hmm.run();
+
+    DijkstraFew sessionShortestPathFew;
+
+    SECTION("Unbounded lag gives the same matches as the whole trip"){
+        HiddenMarkovModel::Session session(hmm, sessionShortestPathFew, 1000);
+        for(const Trip &trip: trips)
+            REQUIRE(matchOnline(session, trip.coords, 1000) == hmm.getMatches(trip.coords));
+    }
+
+    SECTION("Window is bounded by the lag"){
+        for(size_t maxLag: {size_t(1), size_t(2), size_t(5)}){
+            HiddenMarkovModel::Session session(hmm, sessionShortestPathFew, maxLag);
+            for(const Trip &trip: trips)
+                REQUIRE(matchOnline(session, trip.coords, maxLag).size() == trip.coords.size());
+        }
+    }
+
+    SECTION("Single candidate keeps the context"){
+        // Off the corner, only the corner is close enough; the next
+        // observation is closer to (0,1), but only (0,2) is as far by road
+        // from the corner as it is in a straight line
+        const vector<Coord> trip = {
+            getCoord(2, 0), getCoord(1, 0), getCoord(-0.625, -0.625), getCoord(0, 1.45), getCoord(0, 3)
+        };
+        vector<size_t> idxs;
+        vstripesRadius.getClosestPointsIdx(trip[2], idxs);
+        REQUIRE(idxs.size() == 1);
+
+        const vector<node_t> expected = {getNode(2, 0), getNode(1, 0), getNode(0, 0), getNode(0, 2), getNode(0, 3)};
+        REQUIRE(hmm.getMatches(trip) == expected);
+
+        HiddenMarkovModel::Session session(hmm, sessionShortestPathFew, 1000);
+        REQUIRE(matchOnline(session, trip, 1000) == expected);
+    }
+}
+
+TEST_CASE("Lazy route distances", "[hmm-lazy]"){
+    const MapGraph M = getGrid();
+    const vector<Trip> trips = getTrips(50);
+
+    VStripesRadius vstripesRadius;
+    DijkstraFew eagerSearches, lazySearches;
+    HiddenMarkovModel eager(vstripesRadius, eagerSearches, 50.0, 5.0, 6.0, 0, fINF, false);
+    HiddenMarkovModel lazy (vstripesRadius, lazySearches , 50.0, 5.0, 6.0, 0, fINF, true );
+    eager.initialize(&M);
+    lazy .initialize(&M);
+    eager.run();
+
+    for(const Trip &trip: trips)
+        REQUIRE(lazy.getMatches(trip.coords) == eager.getMatches(trip.coords));
+}
+
+TEST_CASE("Beam", "[hmm-beam]"){
+    const MapGraph M = getGrid();
+    const vector<Trip> trips = getTrips(50);
+
+    VStripesRadius vstripesRadius;
+    DijkstraFew shortestPathFew;
+    HiddenMarkovModel hmm(vstripesRadius, shortestPathFew, 50.0, 5.0, 6.0, 0, fINF, false);
+    hmm.initialize(&M);
+    hmm.run();
+
+    SECTION("No beam gives the same matches as a beam wider than all states"){
+        HiddenMarkovModel wide(vstripesRadius, shortestPathFew, 50.0, 5.0, 6.0, 1000, 1e9, false);
+        wide.initialize(&M);
+        wide.run();
+        for(const Trip &trip: trips)
+            REQUIRE(wide.getMatches(trip.coords) == hmm.getMatches(trip.coords));
+    }
+
+    SECTION("Narrow beam still matches each observation to one of its candidates"){
+        for(size_t beamWidth: {size_t(1), size_t(2)}){
+            HiddenMarkovModel narrow(vstripesRadius, shortestPathFew, 50.0, 5.0, 6.0, beamWidth, 5.0, false);
+            narrow.initialize(&M);
+            narrow.run();
+            for(const Trip &trip: trips){
+                const vector<node_t> matches = narrow.getMatches(trip.coords);
+                REQUIRE(matches.size() == trip.coords.size());
+                for(size_t t = 0; t < matches.size(); ++t)
+                    REQUIRE(Coord::getDistanceArc(trip.coords[t], M.nodeToCoord(matches[t])) <= 50.0);
+            }
+        }
+    }
+}
+
+TEST_CASE("Maximum speed", "[hmm-max-speed]"){
+    const MapGraph M = getGrid();
+
+    // Only the nodes next to an observation are candidates
+    VStripesRadius vstripesRadius;
+    DijkstraFew shortestPathFew;
+    HiddenMarkovModel hmm(vstripesRadius, shortestPathFew, 30.0, 5.0, 20.0, 0, fINF, true, 5.0);
+    hmm.initialize(&M);
+    hmm.run();
+
+    SECTION("Routes too long to travel in time are dropped"){
+        // (2,3) is closer to the second observation, but 200m away by road
+        const vector<Coord> trip = {getCoord(0, 0), getCoord(2, 2.6)};
+        REQUIRE(hmm.getMatches(trip) == vector<node_t>{getNode(0, 0), getNode(2, 3)});
+        REQUIRE(hmm.getMatches(trip, {0, 60}) == vector<node_t>{getNode(0, 0), getNode(2, 3)});
+        REQUIRE(hmm.getMatches(trip, {0, 15}) == vector<node_t>{getNode(0, 0), getNode(2, 2)});
+    }
+
+    SECTION("Trips that cannot be travelled in time throw"){
+        const vector<Coord> trip = {getCoord(0, 0), getCoord(4, 4)};
+        REQUIRE(hmm.getMatches(trip, {0, 60}) == vector<node_t>{getNode(0, 0), getNode(4, 4)});
+        REQUIRE_THROWS_AS(hmm.getMatches(trip, {0, 15}), runtime_error);
+    }
+
+    SECTION("Timestamps must match the observations"){
+        REQUIRE_THROWS_AS(hmm.getMatches({getCoord(0, 0), getCoord(1, 0)}, {0}), invalid_argument);
+    }
+}
+
+TEST_CASE("Log scores", "[hmm-scores]"){
+    VStripesRadius vstripesRadius;
+    DijkstraFew shortestPathFew;
+    const double sigma_z = 5.0, beta = 6.0;
+    HiddenMarkovModel hmm(vstripesRadius, shortestPathFew, 50.0, sigma_z, beta);
+
+    mt19937 gen(1);
+    uniform_real_distribution<double> pos(0.0, double(W-1));
+    uniform_real_distribution<double> offset(-0.1, 0.1);
+    uniform_real_distribution<double> route(0.0, 300.0);
+    uniform_int_distribution<size_t> size(1, 6);
+
+    // Candidates of all steps, numbered as in MyA and MyB
+    const size_t T = 20;
+    vector<Coord> Y(T), S;
+    vector<vector<size_t>> idx(T);
+    vector<vector<Coord>> candidates(T);
+    for(size_t t = 0; t < T; ++t){
+        const double x = pos(gen), y = pos(gen);
+        Y[t] = getCoord(x, y);
+        const size_t n = size(gen);
+        for(size_t j = 0; j < n; ++j){
+            idx[t].push_back(S.size());
+            S.push_back(getCoord(x + offset(gen), y + offset(gen)));
+            candidates[t].push_back(S.back());
+        }
+    }
+    vector<vector<double>> D(S.size(), vector<double>(S.size(), fINF));
+    vector<vector<double>> dRoute(T);
+    for(size_t t = 1; t < T; ++t){
+        for(const size_t &i: idx[t-1]){
+            for(const size_t &j: idx[t]){
+                if(gen()%5 != 0) D[i][j] = route(gen);
+                dRoute[t].push_back(D[i][j]);
+            }
+        }
+    }
+
+    ViterbiLog::Scores scores;
+    hmm.getScores(Y, candidates, dRoute, scores);
+    REQUIRE(scores.getSteps() == T);
+
+    HiddenMarkovModel::MyA A(beta, Y, D);
+    HiddenMarkovModel::MyB B(sigma_z, S, Y);
+    const double EPS = 1e-9;
+    for(size_t t = 0; t < T; ++t){
+        REQUIRE(scores.getSize(t) == idx[t].size());
+        const double *b = scores.emission(t);
+        for(size_t j = 0; j < idx[t].size(); ++j)
+            REQUIRE(fabs(b[j] - log(B(long(idx[t][j]), long(t)))) < EPS);
+
+        if(t == 0) continue;
+        const double *a = scores.transition(t);
+        const size_t stride = scores.getStride(t);
+        for(size_t i = 0; i < idx[t-1].size(); ++i){
+            for(size_t j = 0; j < idx[t].size(); ++j){
+                const size_t u = idx[t-1][i], v = idx[t][j];
+                if(D[u][v] >= fINF) REQUIRE(!ViterbiLog::isReachable(a[i*stride + j]));
+                else REQUIRE(fabs(a[i*stride + j] - log(A(long(u), long(v), long(t)))) < EPS);
+            }
+        }
+    }
+}
+
+TEST_CASE("Hybrid", "[hmm-hybrid]"){
+    const MapGraph M = getGrid();
+    const vector<Trip> trips = getTrips(30);
+
+    VStripesRadius vstripesRadius;
+    DijkstraFew shortestPathFew;
+    HiddenMarkovModel hmm(vstripesRadius, shortestPathFew, 50.0, 5.0, 6.0);
+    K2DTreeClosestPointFactory closestPointFactory;
+    MapMatching::FromClosestPoint nearestNeighbour(closestPointFactory);
+
+    SECTION("Every observation doubtful is the HMM"){
+        HiddenMarkovModelHybrid hybrid(nearestNeighbour, hmm, shortestPathFew, 0.0, 0.0, 2);
+        hybrid.initialize(&M);
+        hybrid.run();
+        size_t T = 0;
+        for(const Trip &trip: trips){
+            REQUIRE(hybrid.getMatches(trip.coords) == hmm.getMatches(trip.coords));
+            T += trip.coords.size();
+        }
+        const HiddenMarkovModelHybrid::stats_t stats = hybrid.getStats();
+        REQUIRE(stats.points == T);
+        REQUIRE(stats.fastPoints == 0);
+        REQUIRE(stats.windows == trips.size());
+    }
+
+    SECTION("No observation doubtful is the nearest neighbour"){
+        HiddenMarkovModelHybrid hybrid(nearestNeighbour, hmm, shortestPathFew, 1e9, 1e9, 2);
+        hybrid.initialize(&M);
+        hybrid.run();
+        for(const Trip &trip: trips)
+            REQUIRE(hybrid.getMatches(trip.coords) == nearestNeighbour.getMatches(trip.coords));
+        const HiddenMarkovModelHybrid::stats_t stats = hybrid.getStats();
+        REQUIRE(stats.points > 0);
+        REQUIRE(stats.fastPoints == stats.points);
+        REQUIRE(stats.windows == 0);
+
+        hybrid.resetStats();
+        REQUIRE(hybrid.getStats().points == 0);
+    }
+}
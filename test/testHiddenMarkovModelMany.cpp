@@ -0,0 +1,352 @@
+#include "HiddenMarkovModelMany.h"
+#include "ShortestPathAll.h"
+#include "VStripesRadius.h"
+#include "ViterbiParallel.h"
+#include "grid.h"
+
+#include <catch2/catch_all.hpp>
+
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <streambuf>
+
+using namespace std;
+
+typedef DWGraph::node_t node_t;
+
+using namespace testGrid;
+
+namespace {
+    /**
+     * @brief Write lines as Pipeline writes matches to a stream.
+     */
+    string toString(const vector<Trip> &trips, const HiddenMarkovModelMany &hmm){
+        stringstream ss;
+        for(const Trip &trip: trips){
+            vector<node_t> matches;
+            try {
+                hmm.matchTrip(trip, matches);
+            } catch(const runtime_error &e){
+                continue;
+            }
+            ss << trip.id << " " << matches.size() << "\n";
+            for(const node_t &u: matches) ss << u << "\n";
+        }
+        return ss.str();
+    }
+
+    /**
+     * @brief Stream buffer that fails on the first write.
+     */
+    class FailingBuffer: public streambuf {
+    protected:
+        int_type overflow(int_type){
+            throw runtime_error("Write failed");
+        }
+    };
+
+    string getTempDir(const string &name){
+        const filesystem::path dir = filesystem::temp_directory_path() / name;
+        filesystem::remove_all(dir);
+        filesystem::create_directories(dir);
+        return dir.string();
+    }
+}
+
+TEST_CASE("Pipeline", "[hmm-many-pipeline]"){
+    const MapGraph M = getGrid();
+    const vector<Trip> trips = getTrips(40);
+    const string dir = getTempDir("testHiddenMarkovModelMany-pipeline");
+    const string tripsPath = dir + "/trips.bin";
+    Trip::storeTripsBin(trips, tripsPath);
+
+    VStripesRadius vstripesRadius;
+    ShortestPathAll::Cache distanceCache(DWGraph::weight_t(650000), size_t(1) << 24);
+    HiddenMarkovModelMany hmm(vstripesRadius, 50.0, 5.0, 6.0, 2, fINF, &distanceCache);
+    hmm.initialize(&M);
+    hmm.prepare();
+
+    const string expected = toString(trips, hmm);
+    REQUIRE(!expected.empty());
+
+    SECTION("Matches are written in input order"){
+        for(size_t chunkSize: {size_t(1), size_t(3), size_t(100)}){
+            Trip::Reader reader(tripsPath);
+            stringstream ss;
+            HiddenMarkovModelMany::Pipeline pipeline(hmm, 3, chunkSize, 2);
+            pipeline.run(reader, ss);
+            REQUIRE(ss.str() == expected);
+
+            const vector<double> &busy = pipeline.getBusyTimes();
+            REQUIRE(busy.size() == 3);
+            for(const double &b: busy) REQUIRE(b >= 0.0);
+            REQUIRE(accumulate(busy.begin(), busy.end(), 0.0) > 0.0);
+        }
+    }
+
+    SECTION("Write errors are rethrown once all threads stop"){
+        Trip::Reader reader(tripsPath);
+        FailingBuffer buf;
+        ostream os(&buf);
+        os.exceptions(ostream::badbit);
+        HiddenMarkovModelMany::Pipeline pipeline(hmm, 3, 2, 2);
+        REQUIRE_THROWS_AS(pipeline.run(reader, os), runtime_error);
+    }
+}
+
+namespace {
+    string readFile(const string &path){
+        ifstream is(path);
+        stringstream ss;
+        ss << is.rdbuf();
+        return ss.str();
+    }
+
+    /**
+     * @brief Concatenate the segments listed in the manifest.
+     */
+    string readSegments(const string &dir, const HiddenMarkovModelMany::Checkpoint &checkpoint){
+        string ret;
+        char buf[32];
+        for(const HiddenMarkovModelMany::Checkpoint::segment_t &segment: checkpoint.getSegments()){
+            snprintf(buf, sizeof(buf), "segment-%06zu.txt", segment.index);
+            ret += readFile(dir + "/" + buf);
+        }
+        return ret;
+    }
+
+    bool exists(const string &path){
+        return filesystem::exists(path);
+    }
+}
+
+TEST_CASE("Checkpoint", "[hmm-many-checkpoint]"){
+    const vector<Trip> trips = getTrips(23);
+    const string dir = getTempDir("testHiddenMarkovModelMany-checkpoint");
+    const string tripsPath = dir + "/trips.bin";
+    Trip::storeTripsBin(trips, tripsPath);
+    const string manifestPath = dir + "/" + HiddenMarkovModelMany::Checkpoint::MANIFEST;
+
+    // Every third trip fails to match
+    auto write = [&trips](HiddenMarkovModelMany::Checkpoint &checkpoint, size_t l, size_t r){
+        for(size_t i = l; i < r; ++i){
+            const vector<node_t> matches(trips[i].coords.size(), node_t(i));
+            checkpoint.write(trips[i], (i%3 == 0 ? nullptr : &matches));
+        }
+    };
+    string expected;
+    for(size_t i = 0; i < trips.size(); ++i){
+        if(i%3 == 0) continue;
+        expected += to_string(trips[i].id) + " " + to_string(trips[i].coords.size()) + "\n";
+        for(size_t t = 0; t < trips[i].coords.size(); ++t) expected += to_string(i) + "\n";
+    }
+
+    SECTION("Segments and manifest"){
+        {
+            HiddenMarkovModelMany::Checkpoint checkpoint(dir, 5, tripsPath, trips.size());
+            REQUIRE(checkpoint.getMatchedTrips() == 0);
+            write(checkpoint, 0, trips.size());
+            checkpoint.commit();
+            REQUIRE(checkpoint.getMatchedTrips() == trips.size());
+        }
+
+        HiddenMarkovModelMany::Checkpoint checkpoint(dir, 5, tripsPath, trips.size());
+        REQUIRE(checkpoint.getMatchedTrips() == trips.size());
+        const vector<HiddenMarkovModelMany::Checkpoint::segment_t> &segments = checkpoint.getSegments();
+        REQUIRE(segments.size() == 5);
+        for(size_t k = 0; k < segments.size(); ++k){
+            REQUIRE(segments[k].index == k);
+            REQUIRE(segments[k].firstTrip == 5*k);
+            REQUIRE(segments[k].trips == min(size_t(5), trips.size() - 5*k));
+            size_t written = 0;
+            for(size_t i = segments[k].firstTrip; i < segments[k].firstTrip + segments[k].trips; ++i)
+                if(i%3 != 0) ++written;
+            REQUIRE(segments[k].written == written);
+        }
+        REQUIRE(readSegments(dir, checkpoint) == expected);
+        REQUIRE(!exists(dir + "/segment.tmp"));
+        REQUIRE(!exists(dir + "/segment-000005.txt"));
+    }
+
+    SECTION("Resume after an interrupted run"){
+        {
+            // Interrupted while writing the third segment
+            HiddenMarkovModelMany::Checkpoint checkpoint(dir, 5, tripsPath, trips.size());
+            write(checkpoint, 0, 13);
+        }
+        REQUIRE(exists(dir + "/segment.tmp"));
+
+        HiddenMarkovModelMany::Checkpoint checkpoint(dir, 5, tripsPath, trips.size());
+        REQUIRE(checkpoint.getMatchedTrips() == 10);
+
+        Trip::Reader reader(tripsPath);
+        REQUIRE(reader.skip(checkpoint.getMatchedTrips()) == 10);
+        Trip trip;
+        REQUIRE(reader.next(trip));
+        REQUIRE(trip.id == trips[10].id);
+
+        // The stale segment.tmp is overwritten
+        write(checkpoint, 10, trips.size());
+        checkpoint.commit();
+        REQUIRE(readSegments(dir, checkpoint) == expected);
+    }
+
+    SECTION("Manifest cut short"){
+        {
+            HiddenMarkovModelMany::Checkpoint checkpoint(dir, 5, tripsPath, trips.size());
+            write(checkpoint, 0, trips.size());
+            checkpoint.commit();
+        }
+        const string manifest = readFile(manifestPath);
+        const size_t lastLine = manifest.rfind('\n', manifest.size()-2) + 1;
+
+        // Cut within the last line, and within its last number
+        for(size_t cut: {lastLine + 2, manifest.size() - 2, manifest.size() - 1}){
+            {
+                ofstream os(manifestPath);
+                os << manifest.substr(0, cut);
+            }
+            HiddenMarkovModelMany::Checkpoint checkpoint(dir, 5, tripsPath, trips.size());
+            REQUIRE(checkpoint.getSegments().size() == 4);
+            REQUIRE(checkpoint.getMatchedTrips() == 20);
+        }
+
+        // Cut within the header, nothing is resumed
+        {
+            ofstream os(manifestPath);
+            os << manifest.substr(0, manifest.find('\n'));
+        }
+        HiddenMarkovModelMany::Checkpoint checkpoint(dir, 5, tripsPath, trips.size());
+        REQUIRE(checkpoint.getMatchedTrips() == 0);
+    }
+
+    SECTION("Other input or segment size"){
+        {
+            HiddenMarkovModelMany::Checkpoint checkpoint(dir, 5, tripsPath, trips.size());
+            write(checkpoint, 0, 12);
+        }
+        REQUIRE(readFile(manifestPath).substr(0, readFile(manifestPath).find('\n')) == "input 23 5 " + tripsPath);
+
+        REQUIRE_THROWS_AS(HiddenMarkovModelMany::Checkpoint(dir, 5, dir + "/other.bin", trips.size()), runtime_error);
+        REQUIRE_THROWS_AS(HiddenMarkovModelMany::Checkpoint(dir, 5, tripsPath, trips.size() + 1), runtime_error);
+        REQUIRE_THROWS_AS(HiddenMarkovModelMany::Checkpoint(dir, 6, tripsPath, trips.size()), runtime_error);
+
+        HiddenMarkovModelMany::Checkpoint checkpoint(dir, 5, tripsPath, trips.size());
+        REQUIRE(checkpoint.getMatchedTrips() == 10);
+    }
+}
+
+TEST_CASE("Pipeline with checkpoint", "[hmm-many-checkpoint-pipeline]"){
+    const MapGraph M = getGrid();
+    const vector<Trip> trips = getTrips(40);
+    const string dir = getTempDir("testHiddenMarkovModelMany-checkpoint-pipeline");
+    const string tripsPath = dir + "/trips.bin";
+    Trip::storeTripsBin(trips, tripsPath);
+
+    VStripesRadius vstripesRadius;
+    ShortestPathAll::Cache distanceCache(DWGraph::weight_t(650000), size_t(1) << 24);
+    HiddenMarkovModelMany hmm(vstripesRadius, 50.0, 5.0, 6.0, 2, fINF, &distanceCache);
+    hmm.initialize(&M);
+    hmm.prepare();
+
+    const string expected = toString(trips, hmm);
+
+    // First run is stopped after writing 17 trips, so only the first two
+    // segments were committed
+    {
+        HiddenMarkovModelMany::Checkpoint checkpoint(dir, 6, tripsPath, trips.size());
+        for(size_t i = 0; i < 17; ++i){
+            vector<node_t> matches;
+            try {
+                hmm.matchTrip(trips[i], matches);
+                checkpoint.write(trips[i], &matches);
+            } catch(const runtime_error &e){
+                checkpoint.write(trips[i], nullptr);
+            }
+        }
+        REQUIRE(checkpoint.getMatchedTrips() == 12);
+    }
+
+    Trip::Reader reader(tripsPath);
+    HiddenMarkovModelMany::Checkpoint checkpoint(dir, 6, tripsPath, trips.size());
+    REQUIRE(checkpoint.getMatchedTrips() == 12);
+    HiddenMarkovModelMany::Pipeline pipeline(hmm, 3, 4, 2);
+    pipeline.run(reader, checkpoint);
+    REQUIRE(checkpoint.getMatchedTrips() == trips.size());
+    REQUIRE(readSegments(dir, checkpoint) == expected);
+
+    SECTION("Write errors are rethrown"){
+        Trip::Reader reader(tripsPath);
+        HiddenMarkovModelMany::Checkpoint checkpoint(dir + "/missing", 6, tripsPath, trips.size());
+        HiddenMarkovModelMany::Pipeline pipeline(hmm, 3, 4, 2);
+        REQUIRE_THROWS(pipeline.run(reader, checkpoint));
+    }
+}
+
+TEST_CASE("Precomputed paths and distance cache", "[hmm-many-precompute]"){
+    const MapGraph M = getGrid();
+    const vector<Trip> trips = getTrips(40);
+
+    // Searches from every candidate, precomputed for all trips
+    VStripesRadius vstripesRadius;
+    HiddenMarkovModelMany precomputed(vstripesRadius, 50.0, 5.0, 6.0, 2);
+    precomputed.initialize(&M, trips);
+    precomputed.run();
+
+    // Route distances found on request
+    VStripesRadius vstripesRadiusCached;
+    ShortestPathAll::Cache distanceCache(DWGraph::weight_t(650000), size_t(1) << 24);
+    HiddenMarkovModelMany cached(vstripesRadiusCached, 50.0, 5.0, 6.0, 2, fINF, &distanceCache);
+    cached.initialize(&M);
+    cached.prepare();
+
+    for(const Trip &trip: trips){
+        vector<node_t> matches;
+        cached.matchTrip(trip, matches);
+        REQUIRE(precomputed.getMatches(trip.id) == matches);
+    }
+}
+
+TEST_CASE("Long trips on spare threads", "[hmm-many-spare-threads]"){
+    const MapGraph M = getGrid();
+    const vector<Trip> longTrips = getTrips(3, ViterbiParallel::DEFAULT_MIN_STEPS, ViterbiParallel::DEFAULT_MIN_STEPS + 100);
+
+    VStripesRadius vstripesRadius;
+    ShortestPathAll::Cache distanceCache(DWGraph::weight_t(650000), size_t(1) << 24);
+    HiddenMarkovModelMany hmm(vstripesRadius, 50.0, 5.0, 6.0, 2, fINF, &distanceCache);
+    hmm.initialize(&M);
+    hmm.prepare();
+
+    SECTION("Same matches, and spare threads are given back"){
+        for(const Trip &trip: longTrips){
+            vector<node_t> expected, matches;
+            hmm.matchTrip(trip, expected);
+            atomic<size_t> spareThreads(3);
+            hmm.matchTrip(trip, matches, &spareThreads);
+            REQUIRE(matches == expected);
+            REQUIRE(spareThreads == 3);
+        }
+    }
+
+    SECTION("Pipeline"){
+        vector<Trip> trips = getTrips(20);
+        for(size_t i = 0; i < longTrips.size(); ++i){
+            trips.push_back(longTrips[i]);
+            trips.back().id = (long long)(2000 + i);
+        }
+        const string dir = getTempDir("testHiddenMarkovModelMany-spare-threads");
+        const string tripsPath = dir + "/trips.bin";
+        Trip::storeTripsBin(trips, tripsPath);
+
+        Trip::Reader reader(tripsPath);
+        stringstream ss;
+        HiddenMarkovModelMany::Pipeline pipeline(hmm, 3, 8, 2);
+        pipeline.run(reader, ss);
+        REQUIRE(ss.str() == toString(trips, hmm));
+    }
+}
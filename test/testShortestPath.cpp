@@ -0,0 +1,76 @@
+#include "DijkstraFew.h"
+#include "ShortestPathAll.h"
+#include "parallelFor.h"
+
+#include <catch2/catch_all.hpp>
+
+#include <atomic>
+#include <random>
+
+using namespace std;
+
+typedef DWGraph::node_t node_t;
+typedef DWGraph::weight_t weight_t;
+
+TEST_CASE("Cached path weights", "[shortest-path-cache]"){
+    // Directed grid with random weights, some edges missing
+    const node_t W = 30;
+    mt19937 gen(0);
+    uniform_int_distribution<weight_t> weight(1, 100);
+    DWGraph::DWGraph G;
+    for(node_t u = 0; u < W*W; ++u) G.addNode(u);
+    for(node_t x = 0; x < W; ++x){
+        for(node_t y = 0; y < W; ++y){
+            const node_t u = x*W + y;
+            if(x+1 < W && gen()%5) G.addEdge(u, u+W, weight(gen));
+            if(y+1 < W && gen()%5) G.addEdge(u, u+1, weight(gen));
+            if(x > 0   && gen()%5) G.addEdge(u, u-W, weight(gen));
+            if(y > 0   && gen()%5) G.addEdge(u, u-1, weight(gen));
+        }
+    }
+
+    const weight_t dMax = 500;
+
+    // Queries from a few sources to nearby destinations, repeated
+    vector<pair<node_t, vector<node_t>>> queries;
+    for(size_t i = 0; i < 200; ++i){
+        const node_t s = node_t(gen()%size_t(W*W));
+        vector<node_t> d;
+        for(size_t j = 0; j < 5; ++j) d.push_back(node_t(gen()%size_t(W*W)));
+        queries.emplace_back(s, d);
+    }
+    for(size_t i = 0; i < 800; ++i) queries.push_back(queries[gen()%200]);
+
+    for(size_t maxBytes: {size_t(1) << 30, size_t(1) << 14}){
+        ShortestPathAll::Cache cache(dMax, maxBytes);
+        cache.initialize(&G);
+        cache.run();
+
+        // Assertions are not thread-safe, so threads only count wrong answers
+        atomic<size_t> wrong(0);
+        utils::parallelFor(queries.size(), 4, [&cache, &queries, &G, &wrong, dMax](size_t l, size_t r){
+            DijkstraFew reference(dMax);
+            vector<weight_t> got;
+            for(size_t i = l; i < r; ++i){
+                const node_t &s = queries[i].first;
+                const vector<node_t> &d = queries[i].second;
+                cache.getPathWeights(s, d, got);
+                reference.initialize(&G, s, list<node_t>(d.begin(), d.end()));
+                reference.run();
+                for(size_t j = 0; j < d.size(); ++j){
+                    weight_t expected = (d[j] == s ? 0 : reference.getPathWeight(d[j]));
+                    if(expected > dMax) expected = iINF;
+                    if(got[j] != expected) ++wrong;
+                }
+            }
+        });
+        REQUIRE(wrong == 0);
+
+        ShortestPathAll::Cache::stats_t stats = cache.getStats();
+        REQUIRE(stats.hits + stats.misses <= 5*queries.size());
+        REQUIRE(stats.hits > 0);
+        REQUIRE(stats.searches <= stats.misses);
+        if(maxBytes < (size_t(1) << 20)) REQUIRE(stats.evictions > 0);
+        else REQUIRE(stats.evictions == 0);
+    }
+}
@@ -5,11 +5,14 @@
 #include "VoronoiDiagram.h"
 #include "SlabDecomposition.h"
 #include "SlabDecompositionRB.h"
+#include "SlabDecompositionRBArena.h"
+#include "TrapezoidalMap.h"
+#include "FortuneAlgorithm.h"
 
 using namespace std;
 
 unordered_map<string, Site> sites;
-list<Edge> edges;
+VoronoiDiagram diagram;
 
 void initializeVoronoiDecomposition(VoronoiDecomposition &s){
     sites.clear();
@@ -21,26 +24,31 @@ void initializeVoronoiDecomposition(VoronoiDecomposition &s){
         {"E", {Vector2(5,2)}},
     };
     
-    edges.clear();
+    diagram = VoronoiDiagram();
+    unordered_map<string, Voronoi::idx_t> idx;
+    for(const char *name: {"A", "B", "C", "D", "E"})
+        idx[name] = diagram.addSite(sites.at(name).point);
+    const Voronoi::idx_t NONE = Voronoi::INVALID_IDX;
+
     Edge e = Edge(Vector2(0,0),Vector2(1,1),Vector2(-1,-1));
-    e.start = Vector2( 0,12); e.end = Vector2( 7,12); e.site_up = nullptr       ; e.site_down = &sites.at("A"); edges.push_back(e);
-    e.start = Vector2( 0,12); e.end = Vector2( 0, 8); e.site_up = &sites.at("A"); e.site_down = nullptr       ; edges.push_back(e);
-    e.start = Vector2( 0, 8); e.end = Vector2( 7, 8); e.site_up = &sites.at("A"); e.site_down = &sites.at("C"); edges.push_back(e);
-    e.start = Vector2( 7,12); e.end = Vector2( 7, 8); e.site_up = &sites.at("B"); e.site_down = &sites.at("A"); edges.push_back(e);
-    e.start = Vector2( 7,12); e.end = Vector2(10,12); e.site_up = nullptr       ; e.site_down = &sites.at("B"); edges.push_back(e);
-    e.start = Vector2(10,12); e.end = Vector2(10, 5); e.site_up = nullptr       ; e.site_down = &sites.at("B"); edges.push_back(e);
-    e.start = Vector2( 7, 8); e.end = Vector2(10, 5); e.site_up = &sites.at("B"); e.site_down = &sites.at("C"); edges.push_back(e);
-    e.start = Vector2(10, 4); e.end = Vector2(10, 5); e.site_up = nullptr       ; e.site_down = &sites.at("C"); edges.push_back(e);
-    e.start = Vector2( 3, 4); e.end = Vector2(10, 4); e.site_up = &sites.at("C"); e.site_down = &sites.at("E"); edges.push_back(e);
-    e.start = Vector2( 3, 0); e.end = Vector2( 3, 4); e.site_up = &sites.at("E"); e.site_down = &sites.at("D"); edges.push_back(e);
-    e.start = Vector2( 3, 0); e.end = Vector2(10, 0); e.site_up = &sites.at("E"); e.site_down = nullptr       ; edges.push_back(e);
-    e.start = Vector2(10, 0); e.end = Vector2(10, 4); e.site_up = nullptr       ; e.site_down = &sites.at("E"); edges.push_back(e);
-    e.start = Vector2( 0, 0); e.end = Vector2( 3, 0); e.site_up = &sites.at("D"); e.site_down = nullptr       ; edges.push_back(e);
-    e.start = Vector2( 0, 0); e.end = Vector2( 0, 7); e.site_up = &sites.at("D"); e.site_down = nullptr       ; edges.push_back(e);
-    e.start = Vector2( 0, 7); e.end = Vector2( 3, 4); e.site_up = &sites.at("C"); e.site_down = &sites.at("D"); edges.push_back(e);
-    e.start = Vector2( 0, 7); e.end = Vector2( 0, 8); e.site_up = &sites.at("C"); e.site_down = nullptr       ; edges.push_back(e);
-
-    s.initialize(edges);
+    e.start = Vector2( 0,12); e.end = Vector2( 7,12); e.site_up = NONE       ; e.site_down = idx.at("A"); diagram.addEdge(e);
+    e.start = Vector2( 0,12); e.end = Vector2( 0, 8); e.site_up = idx.at("A"); e.site_down = NONE       ; diagram.addEdge(e);
+    e.start = Vector2( 0, 8); e.end = Vector2( 7, 8); e.site_up = idx.at("A"); e.site_down = idx.at("C"); diagram.addEdge(e);
+    e.start = Vector2( 7,12); e.end = Vector2( 7, 8); e.site_up = idx.at("B"); e.site_down = idx.at("A"); diagram.addEdge(e);
+    e.start = Vector2( 7,12); e.end = Vector2(10,12); e.site_up = NONE       ; e.site_down = idx.at("B"); diagram.addEdge(e);
+    e.start = Vector2(10,12); e.end = Vector2(10, 5); e.site_up = NONE       ; e.site_down = idx.at("B"); diagram.addEdge(e);
+    e.start = Vector2( 7, 8); e.end = Vector2(10, 5); e.site_up = idx.at("B"); e.site_down = idx.at("C"); diagram.addEdge(e);
+    e.start = Vector2(10, 4); e.end = Vector2(10, 5); e.site_up = NONE       ; e.site_down = idx.at("C"); diagram.addEdge(e);
+    e.start = Vector2( 3, 4); e.end = Vector2(10, 4); e.site_up = idx.at("C"); e.site_down = idx.at("E"); diagram.addEdge(e);
+    e.start = Vector2( 3, 0); e.end = Vector2( 3, 4); e.site_up = idx.at("E"); e.site_down = idx.at("D"); diagram.addEdge(e);
+    e.start = Vector2( 3, 0); e.end = Vector2(10, 0); e.site_up = idx.at("E"); e.site_down = NONE       ; diagram.addEdge(e);
+    e.start = Vector2(10, 0); e.end = Vector2(10, 4); e.site_up = NONE       ; e.site_down = idx.at("E"); diagram.addEdge(e);
+    e.start = Vector2( 0, 0); e.end = Vector2( 3, 0); e.site_up = idx.at("D"); e.site_down = NONE       ; diagram.addEdge(e);
+    e.start = Vector2( 0, 0); e.end = Vector2( 0, 7); e.site_up = idx.at("D"); e.site_down = NONE       ; diagram.addEdge(e);
+    e.start = Vector2( 0, 7); e.end = Vector2( 3, 4); e.site_up = idx.at("C"); e.site_down = idx.at("D"); diagram.addEdge(e);
+    e.start = Vector2( 0, 7); e.end = Vector2( 0, 8); e.site_up = idx.at("C"); e.site_down = NONE       ; diagram.addEdge(e);
+
+    s.initialize(diagram);
     s.run();
 }
 
@@ -235,3 +243,123 @@ TEST_CASE("Slab decomposition RB", "[slab-rb-1]"){
     initializeVoronoiDecomposition(s);
     evaluateVoronoiDecomposition(s);
 }
+
+TEST_CASE("Persistent Red-Black Tree with arena", "[persistent-rbtree-arena-1]"){
+    RBTreeArena<int>::Arena arena;
+    RBTreeArena<int> t0(arena);
+    auto t1 = t0.insert(0);
+    auto t2 = t1.insert(1);
+    auto t3 = t2.remove(0);
+
+    REQUIRE( t0.lower_bound(-1) == nullptr);
+    REQUIRE( t0.lower_bound( 0) == nullptr);
+    REQUIRE( t0.lower_bound(+1) == nullptr);
+    REQUIRE( t0.lower_bound(+2) == nullptr);
+
+    REQUIRE(*t1.lower_bound(-1) == 0);
+    REQUIRE(*t1.lower_bound( 0) == 0);
+    REQUIRE( t1.lower_bound(+1) == nullptr);
+    REQUIRE( t1.lower_bound(+2) == nullptr);
+
+    REQUIRE(*t2.lower_bound(-1) == 0);
+    REQUIRE(*t2.lower_bound( 0) == 0);
+    REQUIRE(*t2.lower_bound(+1) == 1);
+    REQUIRE( t2.lower_bound(+2) == nullptr);
+
+    REQUIRE(*t3.lower_bound(-1) == 1);
+    REQUIRE(*t3.lower_bound( 0) == 1);
+    REQUIRE(*t3.lower_bound(+1) == 1);
+    REQUIRE( t3.lower_bound(+2) == nullptr);
+}
+
+TEST_CASE("Persistent Red-Black Tree with arena, random operations", "[persistent-rbtree-arena-2]"){
+    RBTreeArena<int>::Arena arena;
+    vector<RBTreeArena<int>> versions;
+    vector<set<int>> expected;
+    versions.push_back(RBTreeArena<int>(arena));
+    expected.push_back(set<int>());
+
+    mt19937 gen(1);
+    uniform_int_distribution<int> distKey(0, 200);
+    for(size_t i = 0; i < 2000; ++i){
+        int key = distKey(gen);
+        if(gen()%3 == 0){
+            versions.push_back(versions.back().remove(key));
+            expected.push_back(expected.back()); expected.back().erase(key);
+        } else {
+            versions.push_back(versions.back().insert(key));
+            expected.push_back(expected.back()); expected.back().insert(key);
+        }
+        REQUIRE(versions.back().consistent());
+    }
+
+    for(size_t i = 0; i < versions.size(); ++i){
+        REQUIRE(versions[i].size() == expected[i].size());
+        REQUIRE(versions[i].items() == expected[i]);
+    }
+}
+
+TEST_CASE("Slab decomposition RB arena", "[slab-rb-arena-1]"){
+    SlabDecompositionRBArena s;
+    initializeVoronoiDecomposition(s);
+    evaluateVoronoiDecomposition(s);
+}
+
+TEST_CASE("Trapezoidal map", "[trapezoidal-map-1]"){
+    TrapezoidalMap s;
+    initializeVoronoiDecomposition(s);
+    evaluateVoronoiDecomposition(s);
+}
+
+TEST_CASE("Trapezoidal map of Fortune's algorithm output", "[trapezoidal-map-2]"){
+    mt19937 gen(7);
+    vector<Vector2> points;
+    bool checkSlabs = false;
+
+    SECTION("Random sites"){
+        checkSlabs = true;
+        uniform_real_distribution<double> distX(-8.7, -8.5), distY(41.1, 41.2);
+        for(size_t i = 0; i < 2000; ++i)
+            points.push_back(Vector2(distX(gen), distY(gen)));
+    }
+
+    SECTION("Sites on a coarse grid"){
+        // Many cocircular sites, so vertices are computed more than once;
+        // slabs do not handle the tiny edges between them
+        uniform_int_distribution<int> dist(0, 100);
+        for(size_t i = 0; i < 2000; ++i)
+            points.push_back(Vector2(dist(gen)/100.0, dist(gen)/100.0));
+    }
+
+    VoronoiDiagram d = FortuneAlgorithm(points).construct();
+
+    TrapezoidalMap trapezoidalMap;
+    trapezoidalMap.initialize(d);
+    trapezoidalMap.run();
+
+    SlabDecompositionRB slabRB;
+    slabRB.initialize(d);
+    slabRB.run();
+
+    double x0 = points[0].x, x1 = points[0].x, y0 = points[0].y, y1 = points[0].y;
+    for(const Vector2 &p: points){
+        x0 = min(x0, p.x); x1 = max(x1, p.x);
+        y0 = min(y0, p.y); y1 = max(y1, p.y);
+    }
+    uniform_real_distribution<double> distX(x0, x1), distY(y0, y1);
+
+    for(size_t i = 0; i < 2000; ++i){
+        Vector2 q(distX(gen), distY(gen));
+
+        double best = numeric_limits<double>::infinity();
+        for(const Vector2 &p: points) best = min(best, q.getDistance(p));
+
+        Vector2 r = trapezoidalMap.getClosestPoint(q);
+        REQUIRE(q.getDistance(r) <= best + 1e-12);
+
+        if(!checkSlabs) continue;
+
+        r = slabRB.getClosestPoint(q);
+        REQUIRE(q.getDistance(r) <= best + 1e-12);
+    }
+}
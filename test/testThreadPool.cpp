@@ -0,0 +1,46 @@
+#include "ThreadPool.h"
+
+#include <catch2/catch_all.hpp>
+
+#include <list>
+#include <numeric>
+
+using namespace std;
+
+namespace {
+    class SleepTask: public utils::ThreadPool::Task {
+    private:
+        const chrono::milliseconds duration;
+    public:
+        SleepTask(chrono::milliseconds duration_):duration(duration_){}
+        void run(){
+            this_thread::sleep_for(duration);
+        }
+    };
+}
+
+TEST_CASE("Thread pool busy times", "[thread-pool-busy]"){
+    const size_t nThreads = 3;
+    utils::ThreadPool pool(nThreads);
+
+    vector<double> busy = pool.getBusyTimes();
+    REQUIRE(busy.size() == nThreads);
+    for(const double &b: busy) REQUIRE(b == 0.0);
+
+    // 10+20+...+80 ms of work
+    list<SleepTask> tasks;
+    for(int i = 1; i <= 8; ++i) tasks.emplace_back(chrono::milliseconds(10*i));
+    const chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+    for(SleepTask &task: tasks) pool.submit(&task);
+    for(SleepTask &task: tasks) task.wait();
+    const double wall = double(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - begin).count())/1e9;
+
+    // Every task is accounted for as soon as it can be waited on
+    busy = pool.getBusyTimes();
+    REQUIRE(accumulate(busy.begin(), busy.end(), 0.0) >= 0.360);
+    for(const double &b: busy) REQUIRE(b <= wall);
+
+    pool.resetBusyTimes();
+    busy = pool.getBusyTimes();
+    for(const double &b: busy) REQUIRE(b == 0.0);
+}
@@ -0,0 +1,75 @@
+#include "Trip.h"
+
+#include <catch2/catch_all.hpp>
+
+#include <filesystem>
+#include <random>
+
+using namespace std;
+
+TEST_CASE("Trip reader", "[trip-reader]"){
+    mt19937 gen(0);
+    uniform_int_distribution<size_t> length(1, 50);
+    uniform_real_distribution<double> lat(41.1, 41.2), lon(-8.7, -8.5);
+    vector<Trip> trips(100);
+    for(size_t i = 0; i < trips.size(); ++i){
+        trips[i].id = (long long)(10*i + 7);
+        trips[i].timestamp = (long long)(1000*i);
+        trips[i].coords.resize(length(gen));
+        for(Coord &c: trips[i].coords) c = Coord(lat(gen), lon(gen));
+    }
+    const string path = (filesystem::temp_directory_path() / "testTrip.trips.bin").string();
+    Trip::storeTripsBin(trips, path);
+
+    auto requireSame = [](const Trip &a, const Trip &b){
+        REQUIRE(a.id == b.id);
+        REQUIRE(a.timestamp == b.timestamp);
+        REQUIRE(a.coords.size() == b.coords.size());
+        for(size_t t = 0; t < a.coords.size(); ++t){
+            REQUIRE(a.coords[t].lat() == b.coords[t].lat());
+            REQUIRE(a.coords[t].lon() == b.coords[t].lon());
+        }
+    };
+
+    SECTION("Next reads every trip in order"){
+        Trip::Reader reader(path);
+        REQUIRE(reader.size() == trips.size());
+        Trip trip;
+        for(size_t i = 0; i < trips.size(); ++i){
+            REQUIRE(reader.tell() == i);
+            REQUIRE(reader.next(trip));
+            requireSame(trip, trips[i]);
+        }
+        REQUIRE(!reader.next(trip));
+        REQUIRE(reader.tell() == trips.size());
+    }
+
+    SECTION("Skip and next"){
+        Trip::Reader reader(path);
+        Trip trip;
+        REQUIRE(reader.skip(0) == 0);
+        REQUIRE(reader.skip(30) == 30);
+        REQUIRE(reader.tell() == 30);
+        REQUIRE(reader.next(trip));
+        requireSame(trip, trips[30]);
+        REQUIRE(reader.skip(1) == 1);
+        REQUIRE(reader.next(trip));
+        requireSame(trip, trips[32]);
+        REQUIRE(reader.skip(1000) == trips.size() - 33);
+        REQUIRE(reader.tell() == trips.size());
+        REQUIRE(!reader.next(trip));
+        REQUIRE(reader.skip(1) == 0);
+    }
+
+    SECTION("Same as loading all trips"){
+        const vector<Trip> loaded = Trip::loadTripsBin(path);
+        Trip::Reader reader(path);
+        Trip trip;
+        for(const Trip &t: loaded){
+            REQUIRE(reader.next(trip));
+            requireSame(trip, t);
+        }
+    }
+
+    filesystem::remove(path);
+}
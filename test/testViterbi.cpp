@@ -0,0 +1,134 @@
+#include "ViterbiLog.h"
+#include "ViterbiOptimized.h"
+#include "ViterbiParallel.h"
+#include "ViterbiSparse.h"
+
+#include <catch2/catch_all.hpp>
+
+#include <random>
+
+namespace {
+    struct RandomPi : public Viterbi::InitialProbabilitiesGenerator {
+        std::vector<double> p;
+        virtual double operator()(long i) const { return p.at(size_t(i)); }
+    };
+    struct RandomA : public Viterbi::TransitionMatrixGenerator {
+        long K;
+        std::vector<double> p;
+        virtual double operator()(long i, long j, long) const { return p.at(size_t(i*K + j)); }
+    };
+    struct RandomB : public Viterbi::EmissionMatrixGenerator {
+        long K;
+        std::vector<double> p;
+        virtual double operator()(long i, long t) const { return p.at(size_t(t*K + i)); }
+    };
+}
+
+TEST_CASE("Viterbi - Sparse and log", "[viterbi]") {
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<double> prob(0.0, 1.0);
+
+    for(int it = 0; it < 200; ++it){
+        const long T = 1 + long(gen()%60), K = 1 + long(gen()%40);
+
+        RandomPi Pi; RandomA A; RandomB B;
+        A.K = B.K = K;
+        for(long i = 0; i < K; ++i) Pi.p.push_back(prob(gen));
+        // Some transitions are impossible
+        for(long i = 0; i < K*K; ++i) A.p.push_back(prob(gen) < 0.3 ? 0.0 : prob(gen));
+        for(long i = 0; i < T*K; ++i) B.p.push_back(prob(gen));
+
+        std::vector<std::set<long>> candidates(static_cast<size_t>(T));
+        for(auto &c: candidates)
+            for(long i = 0; i < K; ++i)
+                if(gen()%3 == 0) c.insert(i);
+        for(auto &c: candidates)
+            if(c.empty()) c.insert(long(gen()%size_t(K)));
+        // Candidates that are not in the first step are never a start
+        for(long i = 0; i < K; ++i)
+            if(!candidates[0].count(i)) Pi.p[size_t(i)] = 0.0;
+
+        ViterbiOptimized optimized;
+        optimized.initialize(T, K, &Pi, &A, &B, candidates);
+        optimized.run();
+
+        ViterbiSparse sparse;
+        sparse.initialize(&Pi, &A, &B, candidates);
+        sparse.run();
+
+        ViterbiLog::Scores scores = ViterbiLog::Scores::fromGenerators(&Pi, &A, &B, candidates);
+        ViterbiLog viterbiLog;
+        viterbiLog.initialize(&scores);
+        viterbiLog.run();
+
+        bool optimizedFound = true;
+        std::vector<long> expected;
+        try { expected = optimized.getLikeliestPath(); }
+        catch(const std::runtime_error &){ optimizedFound = false; }
+
+        if(optimizedFound){
+            std::vector<long> path = sparse.getLikeliestPath();
+            REQUIRE(path == expected);
+            for(size_t t = 0; t < path.size(); ++t)
+                REQUIRE(candidates[t].count(path[t]));
+
+            std::vector<size_t> local = viterbiLog.getLikeliestPath();
+            REQUIRE(local.size() == expected.size());
+            for(size_t t = 0; t < local.size(); ++t)
+                REQUIRE(*std::next(candidates[t].begin(), long(local[t])) == expected[t]);
+        } else {
+            REQUIRE_THROWS_AS(sparse.getLikeliestPath(), std::runtime_error);
+            REQUIRE_THROWS_AS(viterbiLog.getLikeliestPath(), std::runtime_error);
+        }
+    }
+}
+
+TEST_CASE("Viterbi - Parallel in time", "[viterbi]") {
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<double> prob(0.0, 1.0);
+
+    for(int it = 0; it < 200; ++it){
+        const long T = 1 + long(gen()%300), K = 1 + long(gen()%20);
+        const size_t nThreads = 1 + gen()%8;
+
+        RandomPi Pi; RandomA A; RandomB B;
+        A.K = B.K = K;
+        for(long i = 0; i < K; ++i) Pi.p.push_back(prob(gen));
+        // Some transitions are impossible
+        for(long i = 0; i < K*K; ++i) A.p.push_back(prob(gen) < 0.3 ? 0.0 : prob(gen));
+        for(long i = 0; i < T*K; ++i) B.p.push_back(prob(gen));
+
+        std::vector<std::set<long>> candidates(static_cast<size_t>(T));
+        for(auto &c: candidates)
+            for(long i = 0; i < K; ++i)
+                if(gen()%3 == 0) c.insert(i);
+        for(auto &c: candidates)
+            if(c.empty()) c.insert(long(gen()%size_t(K)));
+        for(long i = 0; i < K; ++i)
+            if(!candidates[0].count(i)) Pi.p[size_t(i)] = 0.0;
+
+        ViterbiOptimized optimized;
+        optimized.initialize(T, K, &Pi, &A, &B, candidates);
+        optimized.run();
+
+        ViterbiLog::Scores scores = ViterbiLog::Scores::fromGenerators(&Pi, &A, &B, candidates);
+        ViterbiParallel parallel(nThreads, 0);
+        parallel.initialize(&scores);
+        parallel.run();
+        REQUIRE(parallel.ranInParallel() == (nThreads > 1 && T >= 4));
+
+        bool optimizedFound = true;
+        std::vector<long> expected;
+        try { expected = optimized.getLikeliestPath(); }
+        catch(const std::runtime_error &){ optimizedFound = false; }
+
+        if(optimizedFound){
+            std::vector<size_t> local = parallel.getLikeliestPath();
+            REQUIRE(local.size() == expected.size());
+            for(size_t t = 0; t < local.size(); ++t)
+                REQUIRE(*std::next(candidates[t].begin(), long(local[t])) == expected[t]);
+        } else {
+            REQUIRE_THROWS_AS(parallel.getLikeliestPath(), std::runtime_error);
+        }
+    }
+}
@@ -1,28 +1,331 @@
 #include "FortuneAlgorithm.h"
+#include "FortuneAlgorithmTiled.h"
 
 #include <catch2/catch_all.hpp>
 
 #include <stdlib.h>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <iomanip>
+#include <map>
+#include <random>
+#include <set>
 
-VoronoiDiagram voronoi(std::vector<Site*> sites) {
+VoronoiDiagram voronoi(const std::vector<Vector2> &sites) {
     VoronoiDiagram diagram = FortuneAlgorithm(sites).construct();
 
     return diagram;
 }
 
 TEST_CASE("Fortune's Algorithm", "[fortune]") {
-    std::vector<Site*> sites = {
-        new Site{Vector2(6, 6)},
-        new Site{Vector2(2, 4)},
-        new Site{Vector2(4, 2)},
-        new Site{Vector2(1, 1)}
+    std::vector<Vector2> sites = {
+        Vector2(6, 6),
+        Vector2(2, 4),
+        Vector2(4, 2),
+        Vector2(1, 1)
     };
 
     VoronoiDiagram diagram = voronoi(sites);
 }
 
+/**
+ * @brief Check that the nearest neighbour of every site is one of its
+ * Delaunay neighbours, and that there are no more than 3n-6 of them.
+ */
+void checkDelaunayNeighbours(const std::vector<Vector2> &points) {
+    VoronoiDiagram diagram = voronoi(points);
+
+    std::set<std::pair<size_t, size_t>> neighbours;
+    for (const std::pair<Voronoi::idx_t, Voronoi::idx_t> &e : diagram.getDelaunayEdges()) {
+        REQUIRE(e.first != e.second);
+        neighbours.insert(std::make_pair(std::min(e.first, e.second), std::max(e.first, e.second)));
+    }
+
+    REQUIRE(neighbours.size() <= 3 * points.size() - 6);
+
+    for (size_t i = 0; i < points.size(); ++i) {
+        double best = std::numeric_limits<double>::infinity();
+        for (size_t j = 0; j < points.size(); ++j)
+            if (j != i) best = std::min(best, points[i].getDistance(points[j]));
+
+        bool found = false;
+        for (size_t j = 0; j < points.size() && !found; ++j)
+            found = j != i &&
+                points[i].getDistance(points[j]) == best &&
+                neighbours.count(std::make_pair(std::min(i, j), std::max(i, j)));
+
+        REQUIRE(found);
+    }
+
+    // Edges refer to sites and to their twins by index
+    const std::vector<Edge> &edges = diagram.getEdges();
+    for (const Edge &edge : edges) {
+        if (edge.site_up == Voronoi::INVALID_IDX) continue;
+
+        REQUIRE(edge.site_up < diagram.sites.size());
+        REQUIRE(edge.site_down < diagram.sites.size());
+
+        if (edge.adjacent != Voronoi::INVALID_IDX) {
+            REQUIRE(edges[edge.adjacent].site_up == edge.site_up);
+            REQUIRE(edges[edge.adjacent].site_down == edge.site_down);
+        }
+    }
+}
+
+TEST_CASE("Fortune's Algorithm - Delaunay neighbours", "[fortune]") {
+    std::mt19937 gen(42);
+
+    SECTION("Random sites") {
+        std::uniform_real_distribution<double> distX(-8.7, -8.5), distY(41.1, 41.2);
+        std::vector<Vector2> points;
+        for (size_t i = 0; i < 2000; ++i)
+            points.push_back(Vector2(distX(gen), distY(gen)));
+
+        checkDelaunayNeighbours(points);
+    }
+
+    SECTION("Sites on a lattice") {
+        // Many sites share a row, a column or a circle
+        std::uniform_int_distribution<int> dist(0, 29);
+        std::set<std::pair<int, int>> cells;
+        while (cells.size() < 300)
+            cells.insert(std::make_pair(dist(gen), dist(gen)));
+
+        std::vector<Vector2> points;
+        for (const std::pair<int, int> &c : cells)
+            points.push_back(Vector2(c.first, c.second));
+        std::shuffle(points.begin(), points.end(), gen);
+
+        checkDelaunayNeighbours(points);
+    }
+}
+
+TEST_CASE("Fortune's Algorithm - Repeated sites", "[fortune]") {
+    std::vector<Vector2> sites = {
+        Vector2(0, 0),
+        Vector2(2, 1),
+        Vector2(0, 0),
+        Vector2(1, 3)
+    };
+
+    VoronoiDiagram diagram = voronoi(sites);
+
+    std::set<std::pair<size_t, size_t>> neighbours;
+    for (const std::pair<Voronoi::idx_t, Voronoi::idx_t> &e : diagram.getDelaunayEdges())
+        neighbours.insert(std::make_pair(std::min(e.first, e.second), std::max(e.first, e.second)));
+
+    // One of the copies of (0, 0) is left out
+    REQUIRE(neighbours.size() == 3);
+}
+
+/**
+ * @brief Check that every edge between two sites lies in the bounding box,
+ * and that its endpoints are equidistant from both sites with no site
+ * closer.
+ */
+void checkEdges(const std::vector<Vector2> &points) {
+    VoronoiDiagram diagram = voronoi(points);
+
+    double x0 = points[0].x, x1 = points[0].x, y0 = points[0].y, y1 = points[0].y;
+    for (const Vector2 &p : points) {
+        x0 = std::min(x0, p.x); x1 = std::max(x1, p.x);
+        y0 = std::min(y0, p.y); y1 = std::max(y1, p.y);
+    }
+
+    const double eps = 1e-9;
+
+    for (const Edge &edge : diagram.getEdges()) {
+        if (edge.site_up == Voronoi::INVALID_IDX) continue;
+
+        for (const Vector2 &v : {edge.start, edge.end}) {
+            REQUIRE(v.x >= x0 - eps); REQUIRE(v.x <= x1 + eps);
+            REQUIRE(v.y >= y0 - eps); REQUIRE(v.y <= y1 + eps);
+
+            double d_up = v.getDistance(diagram.sites[edge.site_up].point);
+            double d_down = v.getDistance(diagram.sites[edge.site_down].point);
+            REQUIRE(fabs(d_up - d_down) < eps);
+
+            for (const Site &site : diagram.sites)
+                REQUIRE(v.getDistance(site.point) > d_up - eps);
+        }
+    }
+}
+
+TEST_CASE("Fortune's Algorithm - Clipped edges", "[fortune]") {
+    SECTION("Edge leaving the box where it starts") {
+        checkEdges({Vector2(0.9, 0.8), Vector2(0.2, 0.2), Vector2(0.3, 0.2)});
+    }
+
+    SECTION("Edge ending above the topmost row") {
+        checkEdges({Vector2(0.81, 0.99), Vector2(0.56, 0.96), Vector2(0.35, 0.99)});
+    }
+
+    SECTION("Edge crossing two sides of the box") {
+        checkEdges({Vector2(0.1, 1), Vector2(0.5, 0.8), Vector2(0.7, 0.3)});
+    }
+
+    SECTION("Sites on a coarse grid") {
+        std::mt19937 gen(4);
+        std::uniform_int_distribution<int> dist(0, 10);
+        std::vector<Vector2> points;
+        for (size_t i = 0; i < 60; ++i)
+            points.push_back(Vector2(dist(gen) / 10.0, dist(gen) / 10.0));
+
+        checkEdges(points);
+    }
+}
+
+/**
+ * @brief Total length of the edges between each pair of sites.
+ */
+std::map<std::pair<size_t, size_t>, double> edgeLengths(const VoronoiDiagram &diagram) {
+    std::map<std::pair<size_t, size_t>, double> lengths;
+    for (const Edge &edge : diagram.getEdges()) {
+        if (edge.site_up == Voronoi::INVALID_IDX) continue;
+
+        std::pair<size_t, size_t> key(std::min(edge.site_up, edge.site_down), std::max(edge.site_up, edge.site_down));
+        lengths[key] += edge.start.getDistance(edge.end);
+    }
+    return lengths;
+}
+
+/**
+ * @brief Check that the tiled construction has the same edges as a single
+ * sweep, and also the same Delaunay edges if no four sites are cocircular.
+ */
+void checkTiled(const std::vector<Vector2> &points, size_t nThreads, bool checkDelaunay) {
+    VoronoiDiagram expected = voronoi(points);
+    FortuneAlgorithmTiled tiled(points, nThreads);
+    VoronoiDiagram diagram = tiled.construct();
+
+    REQUIRE(diagram.sites.size() == points.size());
+
+    std::map<std::pair<size_t, size_t>, double> lengthsExpected = edgeLengths(expected);
+    std::map<std::pair<size_t, size_t>, double> lengths = edgeLengths(diagram);
+
+    const double eps = 1e-9;
+    for (const std::pair<const std::pair<size_t, size_t>, double> &p : lengthsExpected)
+        REQUIRE(fabs(lengths[p.first] - p.second) < eps);
+    for (const std::pair<const std::pair<size_t, size_t>, double> &p : lengths)
+        REQUIRE(fabs(lengthsExpected[p.first] - p.second) < eps);
+
+    const std::vector<Edge> &edges = diagram.getEdges();
+    for (const Edge &edge : edges) {
+        if (edge.site_up == Voronoi::INVALID_IDX || edge.adjacent == Voronoi::INVALID_IDX) continue;
+
+        REQUIRE(edges[edge.adjacent].site_up == edge.site_up);
+        REQUIRE(edges[edge.adjacent].site_down == edge.site_down);
+    }
+
+    // Same sites on each side of every edge; cocircular sites may give
+    // different edges of zero length
+    std::set<std::pair<size_t, size_t>> sidesExpected, sides;
+    for (const Edge &edge : expected.getEdges())
+        if (edge.site_up != Voronoi::INVALID_IDX && edge.start.getDistance(edge.end) > eps)
+            sidesExpected.insert(std::make_pair(edge.site_up, edge.site_down));
+    for (const Edge &edge : edges)
+        if (edge.site_up != Voronoi::INVALID_IDX && edge.start.getDistance(edge.end) > eps)
+            sides.insert(std::make_pair(edge.site_up, edge.site_down));
+    REQUIRE(sides == sidesExpected);
+
+    if (!checkDelaunay) return;
+
+    std::set<std::pair<size_t, size_t>> neighboursExpected, neighbours;
+    for (const std::pair<Voronoi::idx_t, Voronoi::idx_t> &e : expected.getDelaunayEdges())
+        neighboursExpected.insert(std::make_pair(std::min(e.first, e.second), std::max(e.first, e.second)));
+    for (const std::pair<Voronoi::idx_t, Voronoi::idx_t> &e : diagram.getDelaunayEdges())
+        neighbours.insert(std::make_pair(std::min(e.first, e.second), std::max(e.first, e.second)));
+
+    REQUIRE(neighbours == neighboursExpected);
+}
+
+TEST_CASE("Fortune's Algorithm - Tiled", "[fortune]") {
+    std::mt19937 gen(7);
+
+    SECTION("Random sites") {
+        std::uniform_real_distribution<double> distX(-8.7, -8.5), distY(41.1, 41.2);
+        std::vector<Vector2> points;
+        for (size_t i = 0; i < 5000; ++i)
+            points.push_back(Vector2(distX(gen), distY(gen)));
+
+        checkTiled(points, 4, true);
+        checkTiled(points, 7, true);
+
+        // Most cells are final in their strip
+        FortuneAlgorithmTiled tiled(points, 4);
+        tiled.construct();
+        REQUIRE(tiled.getBorderSites() < points.size() / 2);
+    }
+
+    SECTION("Sites on a lattice") {
+        // Strips must not split a column, and cells meet at cocircular sites
+        std::uniform_int_distribution<int> dist(0, 59);
+        std::set<std::pair<int, int>> cells;
+        while (cells.size() < 2000)
+            cells.insert(std::make_pair(dist(gen), dist(gen)));
+
+        std::vector<Vector2> points;
+        for (const std::pair<int, int> &c : cells)
+            points.push_back(Vector2(c.first, c.second));
+        std::shuffle(points.begin(), points.end(), gen);
+
+        checkTiled(points, 4, false);
+    }
+
+    SECTION("Clustered sites") {
+        // Dense clusters, so strips have very different widths
+        std::uniform_real_distribution<double> distX(-8.7, -8.5), distY(41.1, 41.2);
+        std::normal_distribution<double> spread(0.0, 0.002);
+        std::vector<Vector2> centers;
+        for (size_t i = 0; i < 20; ++i)
+            centers.push_back(Vector2(distX(gen), distY(gen)));
+        std::vector<Vector2> points;
+        for (size_t i = 0; i < 5000; ++i) {
+            const Vector2 &c = centers[i % centers.size()];
+            points.push_back(Vector2(c.x + spread(gen), c.y + spread(gen)));
+        }
+
+        checkTiled(points, 4, true);
+        checkTiled(points, 8, true);
+    }
+
+    SECTION("Fewer strips than threads") {
+        // 600 sites make only 2 strips of at least 256 sites
+        std::uniform_real_distribution<double> distX(-8.7, -8.5), distY(41.1, 41.2);
+        std::vector<Vector2> points;
+        for (size_t i = 0; i < 600; ++i)
+            points.push_back(Vector2(distX(gen), distY(gen)));
+
+        checkTiled(points, 8, true);
+    }
+
+    SECTION("Repeated x at strip boundaries") {
+        // Columns of sites at the x where strips would be split, so strips
+        // have to move their boundaries
+        std::uniform_real_distribution<double> distX(-8.7, -8.5), distY(41.1, 41.2);
+        std::vector<Vector2> points;
+        for (size_t i = 0; i < 4000; ++i)
+            points.push_back(Vector2(distX(gen), distY(gen)));
+        std::vector<double> xs;
+        for (const Vector2 &p : points) xs.push_back(p.x);
+        std::sort(xs.begin(), xs.end());
+        for (size_t k = 1; k < 8; ++k) {
+            const double x = xs[k * xs.size() / 8];
+            for (size_t i = 0; i < 40; ++i)
+                points.push_back(Vector2(x, distY(gen)));
+        }
+        std::shuffle(points.begin(), points.end(), gen);
+
+        checkTiled(points, 4, false);
+        checkTiled(points, 8, false);
+    }
+
+    SECTION("Few sites") {
+        checkTiled({Vector2(0, 0), Vector2(2, 1), Vector2(1, 3)}, 4, true);
+    }
+}
+
 TEST_CASE("Point on edge", "[edge]") {
     Edge edge_1(Vector2(0, 0), Vector2(0, 2));
     Edge edge_2(Vector2(1, 1), Vector2(3, 3));
@@ -106,7 +409,7 @@ TEST_CASE("Bounding Box", "[box]") {
 }
 
 TEST_CASE("Parabola intersection with edge", "[arc]") {
-    Arc arc(new Site{Vector2(1, 2)});
+    Arc arc(0, Vector2(1, 2));
     Edge edge(Vector2(1, 0), Vector2(0, 0), Vector2(2, 0));
     double sweep_line = 0;
     Vector2 intersection = arc.intersect(edge, sweep_line);
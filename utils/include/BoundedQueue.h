@@ -0,0 +1,58 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <queue>
+
+namespace utils {
+    /**
+     * @brief Blocking queue with a maximum size, for producer-consumer
+     * pipelines: push waits while the queue is full, so producers cannot
+     * run ahead of consumers.
+     * 
+     * Once closed, push is ignored and pop returns false when there are no
+     * more elements.
+     */
+    template<class T>
+    class BoundedQueue {
+    private:
+        const size_t capacity;
+        std::queue<T> q;
+        bool closed = false;
+        std::mutex m;
+        std::condition_variable cvNotFull, cvNotEmpty;
+    public:
+        BoundedQueue(size_t capacity_):capacity(capacity_){}
+
+        void push(T val){
+            std::unique_lock<std::mutex> lk(m);
+            while(q.size() >= capacity && !closed) cvNotFull.wait(lk);
+            if(closed) return;
+            q.push(std::move(val));
+            cvNotEmpty.notify_one();
+        }
+
+        bool pop(T &val){
+            std::unique_lock<std::mutex> lk(m);
+            while(q.empty() && !closed) cvNotEmpty.wait(lk);
+            if(q.empty()) return false;
+            val = std::move(q.front());
+            q.pop();
+            cvNotFull.notify_one();
+            return true;
+        }
+
+        void close(){
+            std::lock_guard<std::mutex> guard(m);
+            closed = true;
+            cvNotFull.notify_all();
+            cvNotEmpty.notify_all();
+        }
+
+        size_t size(){
+            std::lock_guard<std::mutex> guard(m);
+            return q.size();
+        }
+    };
+}
@@ -1,11 +1,13 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <list>
 #include <mutex>
 #include <queue>
 #include <thread>
+#include <vector>
 
 namespace utils {
     class ThreadPool {
@@ -17,6 +19,10 @@ namespace utils {
             virtual void runFinal() final;
             virtual void wait() final;
         private:
+            /// Runs the task if not done, adding its duration to busyNanos
+            /// (if not null) before waking up those waiting for it
+            void runFinal(std::atomic<long long> *busyNanos);
+
             bool done = false;
             std::mutex m;
             std::condition_variable cv;
@@ -33,9 +39,12 @@ namespace utils {
             }
         };
     private:
-        void workerFunction();
+        void workerFunction(size_t i);
         std::list<std::thread> threads;
 
+        /// Nanoseconds each worker spent running tasks
+        std::vector<std::atomic<long long>> busy;
+
         std::queue<Task*> tasks;
         std::mutex m;
         std::condition_variable cv;
@@ -46,5 +55,12 @@ namespace utils {
         ThreadPool(size_t n);
         ~ThreadPool();
         void submit(Task *task);
+
+        /**
+         * @brief Get time each worker spent running tasks, since the pool was
+         * constructed or resetBusyTimes was last called (in seconds).
+         */
+        std::vector<double> getBusyTimes() const;
+        void resetBusyTimes();
     };
 }
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+namespace utils {
+    /**
+     * @brief Interleave the bits of x and y (Z-order curve).
+     * 
+     * @param x     Quantized x-coordinate
+     * @param y     Quantized y-coordinate
+     * @return unsigned long long Morton code of (x, y)
+     */
+    unsigned long long mortonCode(unsigned x, unsigned y);
+
+    /**
+     * @brief Get the permutation that sorts points in Morton order.
+     * 
+     * Points are quantized to a 2^16 x 2^16 grid over their bounding box.
+     * 
+     * @tparam T    Point type, with public members x and y
+     * @param v     Points
+     * @return std::vector<size_t> Indices of v, in Morton order
+     */
+    template<class T>
+    std::vector<size_t> mortonOrder(const std::vector<T> &v){
+        std::vector<size_t> order(v.size());
+        if(v.empty()) return order;
+
+        double xMin = v[0].x, xMax = v[0].x,
+               yMin = v[0].y, yMax = v[0].y;
+        for(const T &p: v){
+            xMin = std::min(xMin, p.x); xMax = std::max(xMax, p.x);
+            yMin = std::min(yMin, p.y); yMax = std::max(yMax, p.y);
+        }
+        const double SCALE = 65535.0;
+        double fx = (xMax > xMin ? SCALE/(xMax-xMin) : 0.0);
+        double fy = (yMax > yMin ? SCALE/(yMax-yMin) : 0.0);
+
+        std::vector<unsigned long long> codes(v.size());
+        for(size_t i = 0; i < v.size(); ++i){
+            codes[i] = mortonCode(
+                unsigned((v[i].x-xMin)*fx),
+                unsigned((v[i].y-yMin)*fy)
+            );
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&codes](size_t i, size_t j){
+            return codes[i] < codes[j];
+        });
+        return order;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <exception>
+#include <list>
+#include <mutex>
+#include <thread>
+
+namespace utils {
+    /**
+     * @brief Split [0, N) into nThreads contiguous ranges and process each
+     * one in its own thread.
+     * 
+     * The calling thread processes the last range, so nThreads <= 1 runs f
+     * sequentially without spawning any thread. If f throws, the first
+     * exception is rethrown in the calling thread after all threads joined.
+     * 
+     * @param N         Number of elements
+     * @param nThreads  Number of threads to use
+     * @param f         Function with signature f(size_t l, size_t r)
+     */
+    template<class F>
+    void parallelFor(size_t N, size_t nThreads, const F &f){
+        if(nThreads < 1) nThreads = 1;
+        if(nThreads > N) nThreads = (N > 0 ? N : 1);
+
+        std::exception_ptr error = nullptr;
+        std::mutex errorMutex;
+        auto worker = [&f, &error, &errorMutex](size_t l, size_t r){
+            try {
+                f(l, r);
+            } catch(...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if(!error) error = std::current_exception();
+            }
+        };
+
+        std::list<std::thread> threads;
+        size_t l = 0;
+        for(size_t i = 0; i+1 < nThreads; ++i){
+            size_t r = l + N/nThreads + (i < N%nThreads ? 1 : 0);
+            threads.emplace_back(worker, l, r);
+            l = r;
+        }
+        worker(l, N);
+        for(std::thread &t: threads) t.join();
+
+        if(error) std::rethrow_exception(error);
+    }
+}
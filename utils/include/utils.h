@@ -1,7 +1,10 @@
 #pragma once
 
+#include "BoundedQueue.h"
 #include "getDirectory.h"
+#include "mortonCode.h"
 #include "nextPow2.h"
+#include "parallelFor.h"
 #include "ThreadPool.h"
 #include "urlEncode.h"
 
@@ -14,15 +14,23 @@ void utils::ThreadPool::Task::wait(){
 }
 
 void utils::ThreadPool::Task::runFinal(){
+    runFinal(nullptr);
+}
+
+void utils::ThreadPool::Task::runFinal(std::atomic<long long> *busyNanos){
     std::lock_guard<std::mutex> guard(m);
     if(!done){
+        const chrono::steady_clock::time_point begin = chrono::steady_clock::now();
         this->run();
+        const chrono::steady_clock::time_point end = chrono::steady_clock::now();
+        if(busyNanos != nullptr)
+            *busyNanos += chrono::duration_cast<chrono::nanoseconds>(end - begin).count();
         done = true;
         cv.notify_all();
     }
 }
 
-void utils::ThreadPool::workerFunction(){
+void utils::ThreadPool::workerFunction(size_t i){
     Task *task;
     for(;;){
         {
@@ -34,13 +42,15 @@ void utils::ThreadPool::workerFunction(){
             task = tasks.front();
             tasks.pop();
         }
-        task->runFinal();
+        task->runFinal(&busy[i]);
     }
 }
 
-utils::ThreadPool::ThreadPool(size_t n){
+utils::ThreadPool::ThreadPool(size_t n):
+    busy(n)
+{
     while(threads.size() < n){
-        threads.emplace_back(&ThreadPool::workerFunction, this);
+        threads.emplace_back(&ThreadPool::workerFunction, this, threads.size());
     }
 }
 
@@ -59,3 +69,14 @@ void utils::ThreadPool::submit(Task *task){
     tasks.push(task);
     cv.notify_all();
 }
+
+vector<double> utils::ThreadPool::getBusyTimes() const {
+    vector<double> ret(busy.size());
+    for(size_t i = 0; i < busy.size(); ++i)
+        ret[i] = double(busy[i])/1e9;
+    return ret;
+}
+
+void utils::ThreadPool::resetBusyTimes(){
+    for(atomic<long long> &b: busy) b = 0;
+}
@@ -0,0 +1,15 @@
+#include "mortonCode.h"
+
+static unsigned long long spreadBits(unsigned long long x){
+    x &= 0xFFFFFFFFull;
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFull;
+    x = (x | (x <<  8)) & 0x00FF00FF00FF00FFull;
+    x = (x | (x <<  4)) & 0x0F0F0F0F0F0F0F0Full;
+    x = (x | (x <<  2)) & 0x3333333333333333ull;
+    x = (x | (x <<  1)) & 0x5555555555555555ull;
+    return x;
+}
+
+unsigned long long utils::mortonCode(unsigned x, unsigned y){
+    return spreadBits(x) | (spreadBits(y) << 1);
+}
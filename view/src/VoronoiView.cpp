@@ -7,7 +7,7 @@
 
 VoronoiView::VoronoiView(sf::RenderTarget& window_, VoronoiDiagram diagram) : window(window_), diagram(diagram) {
     // Edges
-    for (Edge edge : diagram.getEdges()) {
+    for (const Edge &edge : diagram.getEdges()) {
         sf::Color color(
             rand() % 200,
             rand() % 200,
@@ -20,7 +20,7 @@ VoronoiView::VoronoiView(sf::RenderTarget& window_, VoronoiDiagram diagram) : wi
     }
 
     // Sites
-    for (Site* site : diagram.sites) {
+    for (const Site &site : diagram.sites) {
         sf::CircleShape* circle = new sf::CircleShape();
 
         sf::Color color(
@@ -32,8 +32,8 @@ VoronoiView::VoronoiView(sf::RenderTarget& window_, VoronoiDiagram diagram) : wi
 
         circle->setFillColor(color);
 
-        double x = convertX(site->point.x);
-        double y = convertY(site->point.y);
+        double x = convertX(site.point.x);
+        double y = convertY(site.point.y);
 
         circle->setPosition(x - RADIUS, y - RADIUS); // Center circle
         circle->setRadius(RADIUS);